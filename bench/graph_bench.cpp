@@ -0,0 +1,207 @@
+// ============================================================================
+// Graph Benchmarks — GraphEngine evaluation without OBS.
+//
+//   super-graph-bench [--branches N] [--depth D] [--iters I] [--work W]
+//
+// Builds a wide graph: N independent branches (think one per mixer
+// channel), each a chain of D standard math nodes. Every iteration nudges
+// the head of each branch and evaluates once, so all nodes run.
+//
+//   1. Scaling: interpreted evaluation with set_parallel() on, at 1, 2, 4
+//      and all hardware threads. Run on the light graph and on a heavy one
+//      whose chains also contain a pure busy node doing W sin() calls.
+//   2. A/B: the light graph interpreted vs compiled (GraphProgram), plus a
+//      checksum so both modes are known to compute the same thing.
+// ============================================================================
+
+#include "super/modules/graph/graph_node.hpp"
+#include "super/modules/graph/node_factory.hpp"
+#include "super/core/work_pool.hpp"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QThread>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace super;
+
+// ---------------------------------------------------------------------------
+// BusyNode — Pure node with adjustable cost, standing in for expensive
+// user nodes. Not lowerable, so compiled graphs call it via a trampoline.
+// ---------------------------------------------------------------------------
+class BusyNode : public GraphNode {
+public:
+	explicit BusyNode(int work) : GraphNode("bench_busy"), m_work(work)
+	{
+		m_in = add_input("value", "Value", PinType::Number, 0.0);
+		m_out = add_output("result", "Result", PinType::Number);
+	}
+
+	bool is_pure() const override { return true; }
+
+	void process() override {
+		double x = input_number(m_in);
+		double acc = 0.0;
+		for (int i = 0; i < m_work; i++)
+			acc += std::sin(x + i);
+		set_output_number(m_out, x + acc * 1e-9);
+	}
+
+private:
+	int m_work;
+	int m_in, m_out;
+};
+
+struct Options {
+	int branches = 512;
+	int depth = 8;
+	int iters = 2000;
+	int work = 200;
+};
+
+struct Bench {
+	GraphEngine engine;
+	QVector<Pin *> heads;	// Pin "b" of each branch's first node
+	QVector<GraphNode *> tails;
+};
+
+// Chain: Add → Multiply → Clamp → Map Range → Add → ... (+ BusyNode)
+static void build(Bench &b, const Options &o, bool heavy)
+{
+	auto &factory = NodeFactory::instance();
+	b.engine.set_schedule({GraphTrigger::Manual});
+
+	for (int br = 0; br < o.branches; br++) {
+		GraphNode *head = b.engine.add_node(factory.create("math", {{"op", 0}}));
+		head->find_pin("a")->value.number = br;
+		b.heads.append(head->find_pin("b"));
+
+		GraphNode *prev = head;
+		for (int d = 1; d < o.depth; d++) {
+			GraphNode *node = nullptr;
+			QString in = "a";
+			switch (d % 4) {
+			case 0: node = factory.create("math", {{"op", 0}}); break;
+			case 1: node = factory.create("math", {{"op", 2}}); break;
+			case 2: node = factory.create("clamp"); in = "value"; break;
+			case 3: node = factory.create("map_range"); in = "value"; break;
+			}
+			if (heavy && d == o.depth / 2) {
+				GraphNode *busy = b.engine.add_node(new BusyNode(o.work));
+				b.engine.connect_pins(prev->node_id(), "result", busy->node_id(), "value");
+				prev = busy;
+			}
+			b.engine.add_node(node);
+			b.engine.connect_pins(prev->node_id(), "result", node->node_id(), in);
+			prev = node;
+		}
+		b.tails.append(prev);
+	}
+}
+
+// Microseconds per evaluation; `checksum` sums every branch's output
+static double run(Bench &b, const Options &o, double *checksum = nullptr)
+{
+	// Warm-up: plan, compile, thread start
+	for (int i = 0; i < 10; i++) {
+		for (Pin *p : std::as_const(b.heads))
+			p->value.number = -i;
+		for (GraphNode *n : b.engine.all_nodes())
+			n->mark_dirty();
+		b.engine.evaluate();
+	}
+
+	const QList<GraphNode *> nodes = b.engine.all_nodes();
+	const auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < o.iters; i++) {
+		for (Pin *p : std::as_const(b.heads))
+			p->value.number = i * 1e-3;
+		for (GraphNode *n : nodes)
+			n->mark_dirty();
+		b.engine.evaluate();
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+
+	if (checksum) {
+		*checksum = 0.0;
+		for (GraphNode *n : std::as_const(b.tails))
+			*checksum += n->find_pin("result")->value.number;
+	}
+	return std::chrono::duration<double, std::micro>(t1 - t0).count() / o.iters;
+}
+
+static void scaling(const Options &o, bool heavy)
+{
+	Bench b;
+	build(b, o, heavy);
+
+	QVector<int> threads = {1, 2, 4};
+	const int hw = QThread::idealThreadCount();
+	if (hw > 4)
+		threads.append(hw);
+
+	std::printf("\n%s graph: %d branches x %d nodes%s\n", heavy ? "Heavy" : "Light",
+				o.branches, o.depth + (heavy ? 1 : 0),
+				heavy ? qPrintable(QString(" (busy node: %1 sin/call)").arg(o.work)) : "");
+	std::printf("  %-8s %12s %9s\n", "threads", "us/eval", "speedup");
+
+	double base = 0.0;
+	for (int t : threads) {
+		// The caller takes part, so t threads = t - 1 workers
+		WorkPool::instance().set_worker_count(t - 1);
+		b.engine.set_parallel(t > 1);
+		const double us = run(b, o);
+		if (t == 1)
+			base = us;
+		std::printf("  %-8d %12.1f %8.2fx\n", t, us, base / us);
+	}
+	b.engine.set_parallel(false);
+	WorkPool::instance().set_worker_count(0);
+}
+
+static void compiled_vs_interpreted(const Options &o)
+{
+	Bench interp;
+	build(interp, o, false);
+	double sum_i = 0.0;
+	const double us_i = run(interp, o, &sum_i);
+
+	Bench comp;
+	build(comp, o, false);
+	comp.engine.set_compiled(true);
+	double sum_c = 0.0;
+	const double us_c = run(comp, o, &sum_c);
+
+	std::printf("\nCompiled vs interpreted: %d branches x %d nodes\n", o.branches, o.depth);
+	if (!comp.engine.is_compiled()) {
+		std::printf("  compile failed: %s\n", qPrintable(comp.engine.compile_error()));
+		return;
+	}
+	std::printf("  %-12s %12s %16s\n", "mode", "us/eval", "checksum");
+	std::printf("  %-12s %12.1f %16.6f\n", "interpreted", us_i, sum_i);
+	std::printf("  %-12s %12.1f %16.6f\n", "compiled", us_c, sum_c);
+	std::printf("  speedup %.2fx%s\n", us_i / us_c,
+				std::abs(sum_i - sum_c) > 1e-6 * std::abs(sum_i) ? "  (CHECKSUM MISMATCH)" : "");
+}
+
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+
+	Options o;
+	const QStringList args = app.arguments();
+	for (int i = 1; i + 1 < args.size(); i += 2) {
+		const int v = qMax(1, args[i + 1].toInt());
+		if (args[i] == "--branches") o.branches = v;
+		else if (args[i] == "--depth") o.depth = v;
+		else if (args[i] == "--iters") o.iters = v;
+		else if (args[i] == "--work") o.work = v;
+	}
+
+	scaling(o, false);
+	scaling(o, true);
+	compiled_vs_interpreted(o);
+	return 0;
+}
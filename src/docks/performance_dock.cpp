@@ -0,0 +1,157 @@
+#include "performance_dock.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QSaveFile>
+#include <QMessageBox>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <chrono>
+
+namespace {
+
+enum Column { ColName, ColRate, ColP50, ColP99, ColMax, ColValue, ColCount };
+
+QString formatNs(double ns)
+{
+	if (ns < 1e3)
+		return QString("%1 ns").arg(ns, 0, 'f', 0);
+	if (ns < 1e6)
+		return QString("%1 µs").arg(ns / 1e3, 0, 'f', 1);
+	return QString("%1 ms").arg(ns / 1e6, 0, 'f', 2);
+}
+
+qint64 steadyNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+PerformanceDock::PerformanceDock(QWidget *parent) : QWidget(parent)
+{
+	setWindowTitle("Performance");
+	setMinimumWidth(360);
+
+	QVBoxLayout *mainLayout = new QVBoxLayout(this);
+	mainLayout->setContentsMargins(4, 4, 4, 4);
+
+	m_tree = new QTreeWidget(this);
+	m_tree->setColumnCount(ColCount);
+	m_tree->setHeaderLabels({"Metric", "Rate/s", "p50", "p99", "Max", "Value"});
+	m_tree->setRootIsDecorated(true);
+	m_tree->setUniformRowHeights(true);
+	m_tree->header()->setSectionResizeMode(ColName, QHeaderView::Stretch);
+	for (int c = ColRate; c < ColCount; c++)
+		m_tree->header()->setSectionResizeMode(c, QHeaderView::ResizeToContents);
+	mainLayout->addWidget(m_tree);
+
+	m_histograms = new QTreeWidgetItem(m_tree, {"Timings"});
+	m_counters = new QTreeWidgetItem(m_tree, {"Counters"});
+	m_gauges = new QTreeWidgetItem(m_tree, {"Gauges"});
+	for (auto *group : {m_histograms, m_counters, m_gauges}) {
+		group->setFirstColumnSpanned(true);
+		group->setExpanded(true);
+	}
+
+	QHBoxLayout *bottom = new QHBoxLayout();
+	m_status = new QLabel(this);
+	bottom->addWidget(m_status, 1);
+	m_dump_button = new QPushButton("Dump JSON...", this);
+	connect(m_dump_button, &QPushButton::clicked, this, &PerformanceDock::dumpJson);
+	bottom->addWidget(m_dump_button);
+	mainLayout->addLayout(bottom);
+
+	// Only poll while visible; the metrics themselves are always recorded
+	m_timer.setInterval(1000);
+	connect(&m_timer, &QTimer::timeout, this, &PerformanceDock::refresh);
+}
+
+void PerformanceDock::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+	refresh();
+	m_timer.start();
+}
+
+void PerformanceDock::hideEvent(QHideEvent *event)
+{
+	m_timer.stop();
+	QWidget::hideEvent(event);
+}
+
+QTreeWidgetItem *PerformanceDock::rowFor(const QString &name, QTreeWidgetItem *group)
+{
+	// Keyed by group too: a counter and a timing may share a name
+	QTreeWidgetItem *&row = m_rows[group->text(ColName) + QLatin1Char('/') + name];
+	if (!row) {
+		row = new QTreeWidgetItem(group, {name});
+		for (int c = ColRate; c < ColCount; c++)
+			row->setTextAlignment(c, Qt::AlignRight | Qt::AlignVCenter);
+	}
+	return row;
+}
+
+void PerformanceDock::refresh()
+{
+	auto &registry = super::MetricsRegistry::instance();
+	const qint64 now = steadyNs();
+	const double dt = m_last_refresh_ns ? (now - m_last_refresh_ns) / 1e9 : 0.0;
+	m_last_refresh_ns = now;
+
+	// Timings: rate and percentiles over the last interval
+	for (const QString &name : registry.histogram_names()) {
+		const super::Histogram *h = registry.find_histogram(name);
+		if (!h)
+			continue;
+		super::Histogram::Snapshot snap = h->snapshot();
+		auto last = m_last_snapshots.constFind(name);
+		const super::Histogram::Snapshot window =
+			last != m_last_snapshots.constEnd() ? snap.since(*last) : snap;
+
+		QTreeWidgetItem *row = rowFor(name, m_histograms);
+		row->setText(ColRate, dt > 0 ? QString::number(window.count / dt, 'f', 1) : QString());
+		row->setText(ColP50, window.count ? formatNs(window.percentile(0.50)) : QString());
+		row->setText(ColP99, window.count ? formatNs(window.percentile(0.99)) : QString());
+		row->setText(ColMax, window.count ? formatNs(window.max) : QString());
+		// Time spent per second of wall clock, i.e. the plugin's share of a core
+		row->setText(ColValue, dt > 0 ? QString("%1%").arg(100.0 * window.sum / (dt * 1e9), 0, 'f', 2) : QString());
+		m_last_snapshots.insert(name, std::move(snap));
+	}
+
+	for (const QString &name : registry.counter_names()) {
+		const super::Counter *c = registry.find_counter(name);
+		if (!c)
+			continue;
+		const quint64 v = c->value();
+		QTreeWidgetItem *row = rowFor(name, m_counters);
+		auto last = m_last_counts.constFind(name);
+		if (dt > 0 && last != m_last_counts.constEnd())
+			row->setText(ColRate, QString::number((v - *last) / dt, 'f', 1));
+		row->setText(ColValue, QString::number(v));
+		m_last_counts.insert(name, v);
+	}
+
+	for (const QString &name : registry.gauge_names()) {
+		if (const super::Gauge *g = registry.find_gauge(name))
+			rowFor(name, m_gauges)->setText(ColValue, QString::number(g->value(), 'g', 6));
+	}
+
+	m_status->setText(QString("%1 metrics").arg(m_rows.size()));
+}
+
+void PerformanceDock::dumpJson()
+{
+	const QString path = QFileDialog::getSaveFileName(this, "Dump Metrics", "super_metrics.json",
+		"JSON (*.json)");
+	if (path.isEmpty())
+		return;
+
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly) || file.write(super::MetricsRegistry::instance().to_json()) < 0 ||
+		!file.commit())
+		QMessageBox::warning(this, "Dump Metrics", QString("Cannot write %1").arg(path));
+}
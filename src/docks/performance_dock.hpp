@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QWidget>
+#include <QHash>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QPushButton>
+#include <QLabel>
+
+#include "super/dev/metrics/metrics.hpp"
+
+// Live view of the MetricsRegistry: per-second rates for counters and
+// histograms, interval percentiles (p50/p99/max) for histograms, current
+// gauge values, and a JSON dump of everything on demand.
+class PerformanceDock : public QWidget {
+	Q_OBJECT
+
+public:
+	explicit PerformanceDock(QWidget *parent = nullptr);
+	~PerformanceDock() override = default;
+
+protected:
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+
+private slots:
+	void refresh();
+	void dumpJson();
+
+private:
+	QTreeWidgetItem *rowFor(const QString &name, QTreeWidgetItem *group);
+
+	QTreeWidget *m_tree;
+	QTreeWidgetItem *m_histograms;
+	QTreeWidgetItem *m_counters;
+	QTreeWidgetItem *m_gauges;
+	QPushButton *m_dump_button;
+	QLabel *m_status;
+	QTimer m_timer;
+
+	QHash<QString, QTreeWidgetItem *> m_rows;	// "<group>/<name>"
+	QHash<QString, quint64> m_last_counts;
+	QHash<QString, super::Histogram::Snapshot> m_last_snapshots;
+	qint64 m_last_refresh_ns = 0;
+};
@@ -1,6 +1,7 @@
 #include "sourcerer_item.hpp"
 
 #include "plugin-support.h"
+#include "super/dev/metrics/metrics.hpp"
 
 #include <QVBoxLayout>
 #include <QGridLayout>
@@ -1000,6 +1001,7 @@ void SourcererItem::contextMenuEvent(QContextMenuEvent *event)
 
 void SourcererItem::DrawPreview(void *data, uint32_t cx, uint32_t cy)
 {
+	SUPER_METRIC_TIME("sourcerer.preview_draw");
 	SourcererItem *item = static_cast<SourcererItem *>(data);
 	if (!item)
 		return;
@@ -9,6 +9,9 @@
 //   • Custom easing via cubic bezier curves.
 // ============================================================================
 
+#include "../dev/debugger/trace_recorder.hpp"
+#include "../dev/metrics/metrics.hpp"
+
 #include <QObject>
 #include <QVariant>
 #include <QEasingCurve>
@@ -114,12 +117,14 @@ public:
 		}
 		if (m_tweens.isEmpty())
 			m_tick_timer.stop();
+		SUPER_METRIC_GAUGE("tween.active", m_tweens.size());
 	}
 
 	void cancel_all() {
 		qDeleteAll(m_tweens);
 		m_tweens.clear();
 		m_tick_timer.stop();
+		SUPER_METRIC_GAUGE("tween.active", 0);
 	}
 
 	int active_count() const { return m_tweens.size(); }
@@ -134,6 +139,8 @@ private:
 	}
 
 	void tick() {
+		SUPER_TRACE_SCOPE("tween", "tick");
+		SUPER_TRACE_COUNTER("tween", "active", m_tweens.size());
 		QList<int> finished;
 		for (auto it = m_tweens.begin(); it != m_tweens.end(); ++it) {
 			auto *tw = it.value();
@@ -155,6 +162,7 @@ private:
 		}
 		if (m_tweens.isEmpty())
 			m_tick_timer.stop();
+		SUPER_METRIC_GAUGE("tween.active", m_tweens.size());
 	}
 
 	QTimer m_tick_timer;
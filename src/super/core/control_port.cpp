@@ -3,6 +3,8 @@
 // ============================================================================
 
 #include "control_port.hpp"
+#include "../dev/debugger/trace_recorder.hpp"
+#include "../dev/metrics/metrics.hpp"
 
 #include <QtMath>
 
@@ -196,21 +198,30 @@ void ControlPort::apply_filters_and_commit(const QVariant &raw,
 
 	// Run through filter pipeline
 	QVariant filtered = raw;
-	for (const auto &f : m_filters) {
-		filtered = f->process(filtered, *this);
+	if (!m_filters.isEmpty()) {
+		SUPER_TRACE_SCOPE_DETAIL("port", "pipeline", m_desc.id);
+		SUPER_METRIC_TIME("port.filter_pipeline");
+		for (const auto &f : m_filters) {
+			filtered = f->process(filtered, *this);
+		}
 	}
 
-	// Clamp for Range type
-	if (m_desc.type == ControlType::Range) {
-		double v = qBound(0.0, filtered.toDouble(), 1.0);
-		filtered = QVariant(v);
-	}
+	commit_value(filtered);
+}
 
-	// Commit
-	if (filtered != m_value) {
-		m_value = filtered;
-		emit value_changed(m_value);
-	}
+bool ControlPort::commit_value(const QVariant &val)
+{
+	// Clamp for Range type
+	QVariant v = val;
+	if (m_desc.type == ControlType::Range)
+		v = QVariant(qBound(0.0, val.toDouble(), 1.0));
+
+	if (v == m_value)
+		return false;
+	SUPER_TRACE_SCOPE_DETAIL("port", "commit", m_desc.id);
+	m_value = v;
+	emit value_changed(m_value);
+	return true;
 }
 
 } // namespace super
@@ -61,6 +61,11 @@ public:
 	void set_value(const QVariant &val, bool from_hardware = false);
 	void set_normalized_value(double v);
 
+	// Commit a value that has already been shaped (e.g. from a snapshot),
+	// skipping the filter pipeline. Range values are still clamped.
+	// Returns true if the value changed and value_changed was emitted.
+	bool commit_value(const QVariant &val);
+
 	// -- Constraints -------------------------------------------------------
 	double range_min() const;
 	double range_max() const;
@@ -36,6 +36,7 @@ ControlPort *ControlRegistry::create_port(const ControlDescriptor &desc)
 
 	auto *port = new ControlPort(desc, this);
 	m_ports.insert(desc.id, port);
+	m_generation++;
 	emit port_added(desc.id);
 	return port;
 }
@@ -48,6 +49,7 @@ void ControlRegistry::destroy_port(const QString &id)
 
 	// Also remove from variables if it was one
 	m_variables.remove(id);
+	m_generation++;
 
 	emit port_removed(id);
 	port->deleteLater();
@@ -105,6 +107,7 @@ ControlVariable *ControlRegistry::create_variable(const QString &id,
 	auto *var = new ControlVariable(desc, policy, this);
 	m_ports.insert(id, var);
 	m_variables.insert(id, var);
+	m_generation++;
 	emit port_added(id);
 	return var;
 }
@@ -143,6 +146,19 @@ void ControlRegistry::restore_snapshot(const QJsonObject &snapshot)
 	emit snapshot_restored();
 }
 
+void ControlRegistry::commit_batch(std::span<ControlPort *const> ports,
+								   std::span<const QVariant> values)
+{
+	QList<ControlPort *> changed;
+	const size_t n = qMin(ports.size(), values.size());
+	for (size_t i = 0; i < n; i++) {
+		if (ports[i] && ports[i]->commit_value(values[i]))
+			changed.append(ports[i]);
+	}
+	if (!changed.isEmpty())
+		emit batch_committed(changed);
+}
+
 // ---------------------------------------------------------------------------
 // Modifiers
 // ---------------------------------------------------------------------------
@@ -12,6 +12,7 @@
 #include <QHash>
 #include <QList>
 #include <QJsonObject>
+#include <span>
 
 namespace super {
 
@@ -24,7 +25,7 @@ class ControlVariable;
 //   • Create / destroy ports by descriptor.
 //   • Hierarchical ID lookup  ("audio.mic.vol").
 //   • Group enumeration       ("audio.mic.*").
-//   • Global snapshot / restore.
+//   • Global snapshot / restore, batched commits.
 //   • Modifier state tracking (Shift / Alt layers).
 // ---------------------------------------------------------------------------
 class ControlRegistry : public QObject {
@@ -44,6 +45,9 @@ public:
 	QList<ControlPort *> find_by_group(const QString &group) const;
 	QList<ControlPort *> all_ports() const;
 	QStringList all_ids() const;
+	// Bumped whenever a port is added or removed, so callers caching
+	// find() results can tell when to look again.
+	quint64 generation() const { return m_generation; }
 
 	// -- Variable Management -----------------------------------------------
 	ControlVariable *create_variable(const QString &id, ControlType type,
@@ -55,6 +59,13 @@ public:
 	QJsonObject capture_snapshot() const;
 	void restore_snapshot(const QJsonObject &snapshot);
 
+	// -- Batched Writes ----------------------------------------------------
+	// Commits values[i] to ports[i] via ControlPort::commit_value (no
+	// filters), then emits batch_committed once for the ports that changed.
+	// Null ports are skipped.
+	void commit_batch(std::span<ControlPort *const> ports,
+					  std::span<const QVariant> values);
+
 	// -- Modifiers (Global Layers) -----------------------------------------
 	void set_modifier(const QString &mod_id, bool active);
 	bool modifier(const QString &mod_id) const;
@@ -70,6 +81,7 @@ signals:
 	void port_removed(const QString &id);
 	void modifier_changed(const QString &mod_id, bool active);
 	void snapshot_restored();
+	void batch_committed(const QList<ControlPort *> &ports);
 
 private:
 	ControlRegistry();
@@ -77,6 +89,7 @@ private:
 	Q_DISABLE_COPY_MOVE(ControlRegistry)
 
 	QHash<QString, ControlPort *> m_ports;
+	quint64 m_generation = 0;
 	QHash<QString, ControlVariable *> m_variables;
 	QHash<QString, bool> m_modifiers;
 };
@@ -0,0 +1,603 @@
+#include "expression.hpp"
+#include "control_registry.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+namespace super {
+
+// ===== Instructions =======================================================
+
+namespace {
+
+enum Op : uint8_t {
+	LoadK,
+	LoadX,
+	LoadPrev,
+	LoadDt,
+	LoadPort,
+	Neg,
+	Not,
+	Add,
+	Sub,
+	Mul,
+	Div,
+	Mod,
+	Pow,
+	Lt,
+	Le,
+	Gt,
+	Ge,
+	Eq,
+	Ne,
+	And,
+	Or,
+	Min,
+	Max,
+	Abs,
+	Sqrt,
+	Log10,
+	Log,
+	Exp,
+	Sin,
+	Cos,
+	Floor,
+	Ceil,
+	Round,
+	Sign,
+	Db2Lin,
+	Lin2Db,
+	Select,
+	Clamp,
+	Lerp,
+	Smoothstep,
+};
+
+struct Function {
+	const char *name;
+	Op op;
+	int arity;
+};
+
+const Function kFunctions[] = {
+	{"min", Min, 2},	{"max", Max, 2},	{"pow", Pow, 2},
+	{"abs", Abs, 1},	{"sqrt", Sqrt, 1},	{"log10", Log10, 1},
+	{"log", Log, 1},	{"exp", Exp, 1},	{"sin", Sin, 1},
+	{"cos", Cos, 1},	{"floor", Floor, 1},	{"ceil", Ceil, 1},
+	{"round", Round, 1},	{"sign", Sign, 1},	{"db2lin", Db2Lin, 1},
+	{"lin2db", Lin2Db, 1},	{"clamp", Clamp, 3},	{"lerp", Lerp, 3},
+	{"smoothstep", Smoothstep, 3},
+};
+
+// Shared by the evaluator and the constant folder so both agree exactly.
+inline double apply(uint8_t op, double a, double b, double c)
+{
+	switch (op) {
+	case Neg: return -a;
+	case Not: return a == 0.0 ? 1.0 : 0.0;
+	case Add: return a + b;
+	case Sub: return a - b;
+	case Mul: return a * b;
+	case Div: return a / b;
+	case Mod: return std::fmod(a, b);
+	case Pow: return std::pow(a, b);
+	case Lt: return a < b ? 1.0 : 0.0;
+	case Le: return a <= b ? 1.0 : 0.0;
+	case Gt: return a > b ? 1.0 : 0.0;
+	case Ge: return a >= b ? 1.0 : 0.0;
+	case Eq: return a == b ? 1.0 : 0.0;
+	case Ne: return a != b ? 1.0 : 0.0;
+	case And: return (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
+	case Or: return (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
+	case Min: return a < b ? a : b;
+	case Max: return a > b ? a : b;
+	case Abs: return std::abs(a);
+	case Sqrt: return std::sqrt(a);
+	case Log10: return std::log10(a);
+	case Log: return std::log(a);
+	case Exp: return std::exp(a);
+	case Sin: return std::sin(a);
+	case Cos: return std::cos(a);
+	case Floor: return std::floor(a);
+	case Ceil: return std::ceil(a);
+	case Round: return std::round(a);
+	case Sign: return a > 0.0 ? 1.0 : (a < 0.0 ? -1.0 : 0.0);
+	case Db2Lin: return std::pow(10.0, a / 20.0);
+	case Lin2Db: return a > 0.0 ? 20.0 * std::log10(a) : -144.0;
+	case Select: return a != 0.0 ? b : c;
+	case Clamp: return a < b ? b : (a > c ? c : a);
+	case Lerp: return a + (b - a) * c;
+	case Smoothstep: {
+		double t = b != a ? (c - a) / (b - a) : (c >= b ? 1.0 : 0.0);
+		t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+		return t * t * (3.0 - 2.0 * t);
+	}
+	default: return 0.0;
+	}
+}
+
+} // namespace
+
+// ===== Compiler ===========================================================
+
+// Recursive descent straight to register code. Registers are used as a
+// stack: an operation's result lands in the lowest register of its
+// operands, freeing everything above it. Constants stay unmaterialized
+// until an operation needs them in a register, so constant subtrees fold.
+class ExpressionCompiler {
+public:
+	explicit ExpressionCompiler(ExpressionProgram &prog)
+		: m_prog(prog), m_src(prog.m_source.toUtf8()) {}
+
+	bool run(QString *error)
+	{
+		Operand result = parse_ternary();
+		skip_space();
+		if (m_error.isEmpty() && m_pos < m_src.size())
+			fail(QString("Unexpected '%1'").arg(QChar(m_src[m_pos])));
+		if (!m_error.isEmpty()) {
+			if (error)
+				*error = QString("%1 (at %2)").arg(m_error).arg(m_pos + 1);
+			return false;
+		}
+		if (result.is_const) {
+			m_prog.m_code.clear();
+			m_prog.m_code.append({LoadK, 0, 0, 0, 0, result.value});
+			m_prog.m_result = 0;
+			m_prog.m_registers = 1;
+		} else {
+			m_prog.m_result = result.reg;
+		}
+		m_prog.m_code.squeeze();
+		return true;
+	}
+
+private:
+	struct Operand {
+		bool is_const = true;
+		double value = 0.0;
+		int reg = 0;
+	};
+
+	// ---- Lexing ----------------------------------------------------------
+
+	void skip_space()
+	{
+		while (m_pos < m_src.size() && std::isspace(static_cast<unsigned char>(m_src[m_pos])))
+			m_pos++;
+	}
+
+	char peek(int ahead = 0)
+	{
+		skip_space();
+		int i = m_pos + ahead;
+		return i < m_src.size() ? m_src[i] : '\0';
+	}
+
+	bool accept(const char *tok)
+	{
+		skip_space();
+		int n = static_cast<int>(std::strlen(tok));
+		if (m_src.mid(m_pos, n) != tok)
+			return false;
+		m_pos += n;
+		return true;
+	}
+
+	void expect(char c)
+	{
+		if (peek() == c)
+			m_pos++;
+		else
+			fail(QString("Expected '%1'").arg(c));
+	}
+
+	void fail(const QString &msg)
+	{
+		if (m_error.isEmpty())
+			m_error = msg;
+	}
+
+	bool failed() const { return !m_error.isEmpty(); }
+
+	// ---- Code generation -------------------------------------------------
+
+	int alloc()
+	{
+		if (m_next >= ExpressionProgram::kMaxRegisters) {
+			fail("Expression too complex");
+			return 0;
+		}
+		int r = m_next++;
+		m_prog.m_registers = qMax(m_prog.m_registers, m_next);
+		return r;
+	}
+
+	Operand emit_load(Op op, int a = 0)
+	{
+		Operand o;
+		o.is_const = false;
+		o.reg = alloc();
+		m_prog.m_code.append({op, static_cast<uint8_t>(o.reg), static_cast<uint8_t>(a), 0, 0, 0.0});
+		return o;
+	}
+
+	int materialize(Operand &o)
+	{
+		if (o.is_const) {
+			int r = alloc();
+			m_prog.m_code.append({LoadK, static_cast<uint8_t>(r), 0, 0, 0, o.value});
+			o.is_const = false;
+			o.reg = r;
+		}
+		return o.reg;
+	}
+
+	Operand emit(Op op, Operand a, Operand b = {}, Operand c = {}, int arity = 2)
+	{
+		Operand *args[3] = {&a, &b, &c};
+		bool all_const = true;
+		for (int i = 0; i < arity; i++)
+			all_const &= args[i]->is_const;
+		if (all_const) {
+			Operand o;
+			o.value = apply(op, a.value, b.value, c.value);
+			return o;
+		}
+
+		int regs[3] = {0, 0, 0};
+		int dst = ExpressionProgram::kMaxRegisters;
+		for (int i = 0; i < arity; i++) {
+			regs[i] = materialize(*args[i]);
+			dst = qMin(dst, regs[i]);
+		}
+		if (failed())
+			return {};
+		m_prog.m_code.append({op, static_cast<uint8_t>(dst), static_cast<uint8_t>(regs[0]),
+			static_cast<uint8_t>(regs[1]), static_cast<uint8_t>(regs[2]), 0.0});
+		m_next = dst + 1;
+
+		Operand o;
+		o.is_const = false;
+		o.reg = dst;
+		return o;
+	}
+
+	// ---- Grammar ---------------------------------------------------------
+
+	// ternary := or ('?' ternary ':' ternary)?
+	Operand parse_ternary()
+	{
+		Operand cond = parse_binary(0);
+		if (failed() || !accept("?"))
+			return cond;
+		Operand a = parse_ternary();
+		expect(':');
+		Operand b = parse_ternary();
+		if (failed())
+			return {};
+		return emit(Select, cond, a, b, 3);
+	}
+
+	// Precedence climbing over the left-associative binary operators.
+	Operand parse_binary(int level)
+	{
+		struct Level { const char *tok[4]; Op op[4]; };
+		static const Level kLevels[] = {
+			{{"||"}, {Or}},
+			{{"&&"}, {And}},
+			{{"==", "!="}, {Eq, Ne}},
+			{{"<=", ">=", "<", ">"}, {Le, Ge, Lt, Gt}},
+			{{"+", "-"}, {Add, Sub}},
+			{{"*", "/", "%"}, {Mul, Div, Mod}},
+		};
+		constexpr int kCount = sizeof(kLevels) / sizeof(kLevels[0]);
+		if (level == kCount)
+			return parse_unary();
+
+		Operand lhs = parse_binary(level + 1);
+		while (!failed()) {
+			const Level &l = kLevels[level];
+			int hit = -1;
+			for (int i = 0; i < 4 && l.tok[i]; i++) {
+				if (accept(l.tok[i])) {
+					hit = i;
+					break;
+				}
+			}
+			if (hit < 0)
+				break;
+			Operand rhs = parse_binary(level + 1);
+			if (failed())
+				break;
+			lhs = emit(l.op[hit], lhs, rhs);
+		}
+		return lhs;
+	}
+
+	// unary := ('-' | '+' | '!') unary | power
+	Operand parse_unary()
+	{
+		if (accept("-"))
+			return emit(Neg, parse_unary(), {}, {}, 1);
+		if (accept("+"))
+			return parse_unary();
+		if (peek() == '!' && peek(1) != '=') {
+			m_pos++;
+			return emit(Not, parse_unary(), {}, {}, 1);
+		}
+		return parse_power();
+	}
+
+	// power := primary ('^' unary)?   so -x^2 is -(x^2) and 2^-1 works
+	Operand parse_power()
+	{
+		Operand base = parse_primary();
+		if (failed() || !accept("^"))
+			return base;
+		Operand exp = parse_unary();
+		if (failed())
+			return {};
+		return emit(Pow, base, exp);
+	}
+
+	Operand parse_primary()
+	{
+		char c = peek();
+		if (c == '(') {
+			m_pos++;
+			Operand o = parse_ternary();
+			expect(')');
+			return o;
+		}
+		if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+			return parse_number();
+		if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+			return parse_identifier();
+		if (c == '\0')
+			fail("Unexpected end of expression");
+		else
+			fail(QString("Unexpected '%1'").arg(QChar(c)));
+		return {};
+	}
+
+	Operand parse_number()
+	{
+		int start = m_pos;
+		auto digits = [this]() {
+			while (m_pos < m_src.size() && std::isdigit(static_cast<unsigned char>(m_src[m_pos])))
+				m_pos++;
+		};
+		digits();
+		if (m_pos < m_src.size() && m_src[m_pos] == '.') {
+			m_pos++;
+			digits();
+		}
+		if (m_pos < m_src.size() && (m_src[m_pos] == 'e' || m_src[m_pos] == 'E')) {
+			int mark = m_pos++;
+			if (m_pos < m_src.size() && (m_src[m_pos] == '+' || m_src[m_pos] == '-'))
+				m_pos++;
+			if (m_pos < m_src.size() && std::isdigit(static_cast<unsigned char>(m_src[m_pos])))
+				digits();
+			else
+				m_pos = mark;	// "2e" is 2 followed by the constant e
+		}
+
+		bool ok = false;
+		Operand o;
+		o.value = m_src.mid(start, m_pos - start).toDouble(&ok);
+		if (!ok)
+			fail("Invalid number");
+		return o;
+	}
+
+	Operand parse_identifier()
+	{
+		int start = m_pos;
+		while (m_pos < m_src.size() &&
+			   (std::isalnum(static_cast<unsigned char>(m_src[m_pos])) || m_src[m_pos] == '_'))
+			m_pos++;
+		QByteArray name = m_src.mid(start, m_pos - start);
+
+		if (peek() != '(') {
+			if (name == "x") return emit_load(LoadX);
+			if (name == "prev") return emit_load(LoadPrev);
+			if (name == "dt") return emit_load(LoadDt);
+			Operand o;
+			if (name == "pi") { o.value = 3.14159265358979323846; return o; }
+			if (name == "e") { o.value = 2.71828182845904523536; return o; }
+			m_pos = start;
+			fail(QString("Unknown variable '%1'").arg(QString::fromUtf8(name)));
+			return {};
+		}
+		m_pos++;
+
+		if (name == "port")
+			return parse_port();
+
+		const Function *fn = nullptr;
+		for (const auto &f : kFunctions) {
+			if (name == f.name) {
+				fn = &f;
+				break;
+			}
+		}
+		if (!fn) {
+			m_pos = start;
+			fail(QString("Unknown function '%1'").arg(QString::fromUtf8(name)));
+			return {};
+		}
+
+		Operand args[3];
+		for (int i = 0; i < fn->arity; i++) {
+			if (i > 0)
+				expect(',');
+			if (failed())
+				return {};
+			args[i] = parse_ternary();
+		}
+		expect(')');
+		if (failed())
+			return {};
+		return emit(fn->op, args[0], args[1], args[2], fn->arity);
+	}
+
+	// port("id") — the id must be a literal so slots are fixed at compile time
+	Operand parse_port()
+	{
+		char quote = peek();
+		if (quote != '"' && quote != '\'') {
+			fail("port() expects a quoted id");
+			return {};
+		}
+		int start = ++m_pos;
+		while (m_pos < m_src.size() && m_src[m_pos] != quote)
+			m_pos++;
+		if (m_pos >= m_src.size()) {
+			fail("Unterminated string");
+			return {};
+		}
+		QString id = QString::fromUtf8(m_src.mid(start, m_pos - start));
+		m_pos++;
+		expect(')');
+		if (failed())
+			return {};
+
+		int slot = m_prog.m_ports.indexOf(id);
+		if (slot < 0) {
+			if (m_prog.m_ports.size() >= ExpressionProgram::kMaxPorts) {
+				fail(QString("Too many ports (max %1)").arg(ExpressionProgram::kMaxPorts));
+				return {};
+			}
+			slot = m_prog.m_ports.size();
+			m_prog.m_ports.append(id);
+		}
+		return emit_load(LoadPort, slot);
+	}
+
+	ExpressionProgram &m_prog;
+	QByteArray m_src;
+	QString m_error;
+	int m_pos = 0;
+	int m_next = 0;
+};
+
+// ===== ExpressionProgram ==================================================
+
+std::shared_ptr<const ExpressionProgram> ExpressionProgram::compile(const QString &source,
+																	 QString *error)
+{
+	auto prog = std::make_shared<ExpressionProgram>();
+	prog->m_source = source;
+	ExpressionCompiler compiler(*prog);
+	if (!compiler.run(error))
+		return nullptr;
+	return prog;
+}
+
+double ExpressionProgram::evaluate(const Inputs &in) const
+{
+	double regs[kMaxRegisters];
+	const Instr *ip = m_code.constData();
+	const Instr *end = ip + m_code.size();
+	for (; ip != end; ++ip) {
+		switch (ip->op) {
+		case LoadK: regs[ip->dst] = ip->k; break;
+		case LoadX: regs[ip->dst] = in.x; break;
+		case LoadPrev: regs[ip->dst] = in.prev; break;
+		case LoadDt: regs[ip->dst] = in.dt; break;
+		case LoadPort: regs[ip->dst] = in.ports ? in.ports[ip->a] : 0.0; break;
+		default:
+			regs[ip->dst] = apply(ip->op, regs[ip->a], regs[ip->b], regs[ip->c]);
+			break;
+		}
+	}
+	return regs[m_result];
+}
+
+// ===== ExpressionPorts ====================================================
+
+void ExpressionPorts::bind(const ExpressionProgram *program)
+{
+	m_program = program;
+	resolve();
+}
+
+void ExpressionPorts::resolve()
+{
+	auto &reg = ControlRegistry::instance();
+	m_generation = reg.generation();
+	const int n = m_program ? m_program->port_ids().size() : 0;
+	for (int i = 0; i < n; i++)
+		m_ports[i] = reg.find(m_program->port_ids()[i]);
+}
+
+void ExpressionPorts::read(double *out)
+{
+	if (!m_program)
+		return;
+	if (m_generation != ControlRegistry::instance().generation())
+		resolve();
+	const int n = m_program->port_ids().size();
+	for (int i = 0; i < n; i++)
+		out[i] = m_ports[i] ? m_ports[i]->as_double() : 0.0;
+}
+
+// ===== ExpressionFilter ===================================================
+
+ExpressionFilter::ExpressionFilter(const QString &source)
+{
+	set_source(source);
+}
+
+bool ExpressionFilter::set_source(const QString &source)
+{
+	m_error.clear();
+	m_program = ExpressionProgram::compile(source, &m_error);
+	m_ports.bind(m_program.get());
+	return m_program != nullptr;
+}
+
+QString ExpressionFilter::source() const
+{
+	return m_program ? m_program->source() : QString();
+}
+
+QString ExpressionFilter::name() const
+{
+	return QStringLiteral("Expression(%1)").arg(source());
+}
+
+QVariant ExpressionFilter::process(const QVariant &input, const ControlPort &/*port*/) const
+{
+	bool ok = false;
+	double x = input.toDouble(&ok);
+	if (!m_program || !ok)
+		return input;
+
+	ExpressionProgram::Inputs in;
+	in.x = x;
+	in.prev = m_initialized ? m_prev : x;
+	// Nanosecond resolution: bursts inside 1 ms must not see dt == 0
+	if (m_timer.isValid()) {
+		in.dt = m_timer.nsecsElapsed() / 1e9;
+		m_timer.restart();
+	} else {
+		in.dt = 0.0;
+		m_timer.start();
+	}
+
+	double ports[ExpressionProgram::kMaxPorts];
+	m_ports.read(ports);
+	in.ports = ports;
+
+	double out = m_program->evaluate(in);
+	if (!std::isfinite(out))
+		return m_initialized ? QVariant(m_prev) : input;
+	m_prev = out;
+	m_initialized = true;
+	return QVariant(out);
+}
+
+} // namespace super
@@ -0,0 +1,129 @@
+#pragma once
+
+// ============================================================================
+// Universal Control API — Compiled Expressions
+// Small math expressions used as custom transfer functions:
+//
+//   clamp(db2lin(x * 60 - 60), 0, 1)
+//   lerp(prev, x, 1 - exp(-dt * 8))
+//   x * port("audio.master.vol")
+//
+// Compiled once into register bytecode; evaluation touches only a fixed
+// register file on the stack and never allocates.
+// ============================================================================
+
+#include "control_port.hpp"
+
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdint>
+#include <memory>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// ExpressionProgram — Immutable compiled expression (shareable).
+//
+// Variables:  x (input), prev (previous output), dt (seconds since the
+//             previous evaluation), pi, e
+// Operators:  + - * / % ^  < <= > >= == !=  && || !  c ? a : b
+// Functions:  clamp(v,lo,hi) lerp(a,b,t) smoothstep(e0,e1,v) min max pow
+//             abs sqrt exp log log10 sin cos floor ceil round sign
+//             db2lin(db) lin2db(lin) port("id")
+//
+// Both sides of ?:, && and || are evaluated (branch-free).
+// ---------------------------------------------------------------------------
+class ExpressionProgram {
+public:
+	static constexpr int kMaxRegisters = 32;
+	static constexpr int kMaxPorts = 8;
+
+	struct Inputs {
+		double x = 0.0;
+		double prev = 0.0;
+		double dt = 0.0;
+		const double *ports = nullptr;	// port_ids().size() values
+	};
+
+	// Returns nullptr and fills `error` (if given) on a syntax error.
+	static std::shared_ptr<const ExpressionProgram> compile(const QString &source,
+															 QString *error = nullptr);
+
+	double evaluate(const Inputs &in) const;
+
+	const QString &source() const { return m_source; }
+	const QStringList &port_ids() const { return m_ports; }
+	int instruction_count() const { return m_code.size(); }
+	int register_count() const { return m_registers; }
+	bool is_constant() const { return m_code.size() == 1 && m_code[0].op == 0; }
+
+	struct Instr {
+		uint8_t op;
+		uint8_t dst;
+		uint8_t a;
+		uint8_t b;
+		uint8_t c;
+		double k;
+	};
+
+private:
+	friend class ExpressionCompiler;
+
+	QString m_source;
+	QVector<Instr> m_code;
+	QStringList m_ports;
+	int m_registers = 0;
+	int m_result = 0;
+};
+
+// ---------------------------------------------------------------------------
+// ExpressionPorts — A program's port("id") references resolved to ports.
+// bind() looks the ids up once; read() only dereferences, and looks them up
+// again only after ControlRegistry's port set changed.
+// ---------------------------------------------------------------------------
+class ExpressionPorts {
+public:
+	void bind(const ExpressionProgram *program);
+
+	// Current values in slot order; `out` must hold port_ids().size() values.
+	// Unregistered ports read 0.
+	void read(double *out);
+
+private:
+	void resolve();
+
+	const ExpressionProgram *m_program = nullptr;
+	QPointer<ControlPort> m_ports[ExpressionProgram::kMaxPorts];
+	quint64 m_generation = 0;
+};
+
+// ---------------------------------------------------------------------------
+// ExpressionFilter — ControlFilter running an ExpressionProgram.
+// Non-numeric values pass through; a result that isn't finite keeps the
+// previous output.
+// ---------------------------------------------------------------------------
+class ExpressionFilter : public ControlFilter {
+public:
+	explicit ExpressionFilter(const QString &source = "x");
+
+	QVariant process(const QVariant &input, const ControlPort &port) const override;
+	QString name() const override;
+
+	bool set_source(const QString &source);
+	QString source() const;
+	bool is_valid() const { return m_program != nullptr; }
+	const QString &error() const { return m_error; }
+
+private:
+	std::shared_ptr<const ExpressionProgram> m_program;
+	QString m_error;
+	mutable ExpressionPorts m_ports;
+	mutable double m_prev = 0.0;
+	mutable bool m_initialized = false;
+	mutable QElapsedTimer m_timer;
+};
+
+} // namespace super
@@ -0,0 +1,237 @@
+// ============================================================================
+// SnapshotMorph — Implementation
+// ============================================================================
+
+#include "snapshot_morph.hpp"
+#include "control_registry.hpp"
+#include "../dev/debugger/trace_recorder.hpp"
+#include "../dev/metrics/metrics.hpp"
+
+#include <cmath>
+
+namespace super {
+
+static bool is_numeric(ControlType t)
+{
+	switch (t) {
+	case ControlType::Range:
+	case ControlType::Float:
+	case ControlType::Int:
+	case ControlType::Time:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Construction
+// ---------------------------------------------------------------------------
+SnapshotMorph::SnapshotMorph(QObject *parent) : QObject(parent)
+{
+	m_timer.setTimerType(Qt::PreciseTimer);
+	connect(&m_timer, &QTimer::timeout, this, &SnapshotMorph::tick);
+	connect(&ControlRegistry::instance(), &ControlRegistry::port_removed,
+			this, &SnapshotMorph::on_port_removed);
+}
+
+SnapshotMorph::~SnapshotMorph()
+{
+	bind_position(nullptr);
+}
+
+// ---------------------------------------------------------------------------
+// Setup
+// ---------------------------------------------------------------------------
+int SnapshotMorph::set_snapshots(const QJsonObject &a, const QJsonObject &b)
+{
+	clear();
+	auto &reg = ControlRegistry::instance();
+
+	struct Disc { ControlPort *port; QString id; QVariant a, b; };
+	std::vector<Disc> discrete;
+
+	for (auto it = a.constBegin(); it != a.constEnd(); ++it) {
+		const QJsonValue bv = b.value(it.key());
+		if (bv.isUndefined() || bv == it.value())
+			continue;
+		auto *port = reg.find(it.key());
+		if (!port)
+			continue;
+
+		if (is_numeric(port->type()) && it.value().isDouble() && bv.isDouble()) {
+			const double from = it.value().toDouble();
+			m_ports.push_back(port);
+			m_ids.append(it.key());
+			m_from.push_back(from);
+			m_delta.push_back(bv.toDouble() - from);
+			m_round.push_back(port->type() == ControlType::Int ? 1 : 0);
+		} else {
+			discrete.push_back({port, it.key(), it.value().toVariant(), bv.toVariant()});
+		}
+	}
+
+	m_num = m_ports.size();
+	for (auto &d : discrete) {
+		m_ports.push_back(d.port);
+		m_ids.append(d.id);
+		m_disc_a.push_back(std::move(d.a));
+		m_disc_b.push_back(std::move(d.b));
+	}
+	m_mix.resize(m_num);
+	m_out.resize(m_ports.size());
+	return static_cast<int>(m_ports.size());
+}
+
+void SnapshotMorph::clear()
+{
+	stop();
+	m_ports.clear();
+	m_ids.clear();
+	m_num = 0;
+	m_from.clear();
+	m_delta.clear();
+	m_mix.clear();
+	m_round.clear();
+	m_out.clear();
+	m_disc_a.clear();
+	m_disc_b.clear();
+	m_disc_side = -1;
+	m_dirty = true;
+}
+
+void SnapshotMorph::set_curve(const QEasingCurve &curve)
+{
+	m_curve = curve;
+	m_dirty = true;
+}
+
+void SnapshotMorph::set_switch_point(double t)
+{
+	m_switch = qBound(0.0, t, 1.0);
+	m_dirty = true;
+}
+
+void SnapshotMorph::on_port_removed(const QString &id)
+{
+	const qsizetype i = m_ids.indexOf(id);
+	if (i >= 0)
+		m_ports[static_cast<size_t>(i)] = nullptr;	// commit_batch skips nulls
+}
+
+// ---------------------------------------------------------------------------
+// Position
+// ---------------------------------------------------------------------------
+void SnapshotMorph::set_position(double t)
+{
+	t = qBound(0.0, t, 1.0);
+	if (!m_dirty && t == m_position)
+		return;
+	m_position = t;
+	m_dirty = false;
+	apply();
+	emit position_changed(m_position);
+}
+
+void SnapshotMorph::apply()
+{
+	if (m_ports.empty())
+		return;
+	SUPER_TRACE_SCOPE("morph", "apply");
+	SUPER_METRIC_TIME("morph.apply");
+
+	// Numeric ports: plain loops over contiguous doubles so the compiler
+	// can vectorise them
+	const double e = m_curve.valueForProgress(m_position);
+	const double *from = m_from.data();
+	const double *delta = m_delta.data();
+	double *mix = m_mix.data();
+	for (size_t i = 0; i < m_num; i++)
+		mix[i] = from[i] + delta[i] * e;
+	for (size_t i = 0; i < m_num; i++) {
+		if (m_round[i])
+			mix[i] = std::round(mix[i]);
+	}
+	for (size_t i = 0; i < m_num; i++)
+		m_out[i] = QVariant(mix[i]);
+
+	// Discrete ports are only written when they change side
+	size_t count = m_num;
+	const int side = m_position >= m_switch ? 1 : 0;
+	if (side != m_disc_side) {
+		m_disc_side = side;
+		const auto &src = side ? m_disc_b : m_disc_a;
+		for (size_t i = m_num; i < m_ports.size(); i++)
+			m_out[i] = src[i - m_num];
+		count = m_ports.size();
+	}
+
+	ControlRegistry::instance().commit_batch(
+		std::span<ControlPort *const>(m_ports.data(), count),
+		std::span<const QVariant>(m_out.data(), count));
+}
+
+// ---------------------------------------------------------------------------
+// Timed morph
+// ---------------------------------------------------------------------------
+void SnapshotMorph::morph_to(double target, int duration_ms)
+{
+	m_anim_from = m_position;
+	m_anim_to = qBound(0.0, target, 1.0);
+	m_anim_ms = qMax(0, duration_ms);
+	m_elapsed.start();
+	if (!m_timer.isActive())
+		m_timer.start(16);	// ~60fps, same as TweenManager
+	tick();
+}
+
+void SnapshotMorph::stop()
+{
+	m_timer.stop();
+}
+
+void SnapshotMorph::tick()
+{
+	const double p = m_anim_ms > 0
+		? qBound(0.0, static_cast<double>(m_elapsed.elapsed()) / m_anim_ms, 1.0)
+		: 1.0;
+	const double pos = m_anim_from + (m_anim_to - m_anim_from) * p;
+
+	if (m_position_port) {
+		m_driving = true;
+		m_position_port->set_normalized_value(pos);
+		m_driving = false;
+	} else {
+		set_position(pos);
+	}
+
+	if (p >= 1.0) {
+		m_timer.stop();
+		emit finished();
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Crossfader binding
+// ---------------------------------------------------------------------------
+void SnapshotMorph::bind_position(ControlPort *port)
+{
+	disconnect(m_position_conn);
+	disconnect(m_position_destroyed);
+	m_position_port = port;
+	if (!port)
+		return;
+
+	m_position_conn = connect(port, &ControlPort::value_changed, this, [this]() {
+		// A user moving the crossfader takes over from morph_to()
+		if (!m_driving)
+			stop();
+		set_position(m_position_port->normalized_value());
+	});
+	m_position_destroyed = connect(port, &QObject::destroyed, this, [this]() {
+		m_position_port = nullptr;
+	});
+	set_position(port->normalized_value());
+}
+
+} // namespace super
@@ -0,0 +1,111 @@
+#pragma once
+
+// ============================================================================
+// SnapshotMorph — Crossfade every port between two control snapshots.
+//
+// set_snapshots() resolves the ports that differ between A and B once and
+// lays numeric ones out as flat from/delta arrays, so each position update
+// is one tight loop over doubles followed by a single
+// ControlRegistry::commit_batch(). Discrete ports (toggles, selects,
+// strings, ...) jump from A to B when the position crosses switch_point().
+//
+// The position can be set directly, animated with morph_to(), or bound to
+// a ControlPort so a crossfader drives it.
+// ============================================================================
+
+#include <QObject>
+#include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+#include <vector>
+
+namespace super {
+
+class ControlPort;
+
+class SnapshotMorph : public QObject {
+	Q_OBJECT
+
+public:
+	explicit SnapshotMorph(QObject *parent = nullptr);
+	~SnapshotMorph() override;
+
+	// Resolve the ports present in both snapshots whose values differ.
+	// Returns the number of ports that will move.
+	int set_snapshots(const QJsonObject &a, const QJsonObject &b);
+	void clear();
+
+	int numeric_count() const { return static_cast<int>(m_num); }
+	int discrete_count() const { return static_cast<int>(m_ports.size() - m_num); }
+
+	// Crossfade law, applied to the position (0 = A, 1 = B).
+	void set_curve(const QEasingCurve &curve);
+	QEasingCurve curve() const { return m_curve; }
+
+	// Position at which discrete ports switch from A to B.
+	void set_switch_point(double t);
+	double switch_point() const { return m_switch; }
+
+	// -- Position ----------------------------------------------------------
+	void set_position(double t);
+	double position() const { return m_position; }
+
+	// Animate the position to `target` over `duration_ms`. With a bound
+	// port the port is moved instead, so motorised faders follow.
+	void morph_to(double target, int duration_ms);
+	void stop();
+	bool is_running() const { return m_timer.isActive(); }
+
+	// Drive the position from `port`'s normalized value; nullptr unbinds.
+	void bind_position(ControlPort *port);
+	ControlPort *position_port() const { return m_position_port; }
+
+signals:
+	void position_changed(double t);
+	void finished();
+
+private:
+	void apply();
+	void tick();
+	void on_port_removed(const QString &id);
+
+	// Numeric ports occupy [0, m_num), discrete ports the rest
+	std::vector<ControlPort *> m_ports;
+	QStringList m_ids;					// Parallel to m_ports
+	size_t m_num = 0;
+
+	// Numeric, structure-of-arrays
+	std::vector<double> m_from;
+	std::vector<double> m_delta;
+	std::vector<double> m_mix;			// Scratch
+	std::vector<quint8> m_round;		// 1 for Int ports
+	std::vector<QVariant> m_out;		// Scratch for commit_batch, all ports
+
+	// Discrete, indexed from m_num
+	std::vector<QVariant> m_disc_a;
+	std::vector<QVariant> m_disc_b;
+	int m_disc_side = -1;				// 0 = A, 1 = B, -1 = not yet written
+
+	QEasingCurve m_curve{QEasingCurve::Linear};
+	double m_switch = 0.5;
+	double m_position = 0.0;
+	bool m_dirty = true;				// Apply even if the position is unchanged
+
+	// morph_to()
+	QTimer m_timer;
+	QElapsedTimer m_elapsed;
+	double m_anim_from = 0.0;
+	double m_anim_to = 0.0;
+	int m_anim_ms = 0;
+
+	ControlPort *m_position_port = nullptr;
+	QMetaObject::Connection m_position_conn;
+	QMetaObject::Connection m_position_destroyed;
+	bool m_driving = false;				// tick() is moving the bound port
+};
+
+} // namespace super
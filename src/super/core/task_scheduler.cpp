@@ -0,0 +1,305 @@
+#include "task_scheduler.hpp"
+#include "control_port.hpp"
+#include "../modules/time/master_clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace super {
+
+TaskScheduler &TaskScheduler::instance()
+{
+	static TaskScheduler scheduler;
+	return scheduler;
+}
+
+TaskScheduler::TaskScheduler() : QObject(nullptr)
+{
+	m_wheel.resize(kWheelSlots);
+	m_clock.start();
+	m_frame_timer.setInterval(kFrameMs);
+	connect(&m_frame_timer, &QTimer::timeout, this, &TaskScheduler::on_frame);
+
+	// Beat waits: no polling, just a timer aimed at the next target
+	m_beat_timer.setSingleShot(true);
+	m_beat_timer.setTimerType(Qt::PreciseTimer);
+	connect(&m_beat_timer, &QTimer::timeout, this, &TaskScheduler::service_beats);
+	auto &clock = MasterClock::instance();
+	connect(&clock, &MasterClock::beat_signal, this, &TaskScheduler::service_beats);
+	connect(&clock, &MasterClock::transport_started, this, &TaskScheduler::service_beats);
+	connect(&clock, &MasterClock::transport_stopped, this, &TaskScheduler::service_beats);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	for (auto &q : m_ports) {
+		disconnect(q.changed);
+		disconnect(q.destroyed);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Registering waits
+// ---------------------------------------------------------------------------
+
+TaskScheduler::WaitId TaskScheduler::add_live()
+{
+	WaitId id = ++m_last_id;
+	m_live.insert(id);
+	return id;
+}
+
+// A wait of `frames` lands in slot (now + frames) % kWheelSlots with as many
+// `rounds` as the wheel passes that slot before the target frame.
+void TaskScheduler::add_to_wheel(qint64 frames, WaitId id, Resume resume)
+{
+	const qint64 now = now_frame();
+	if (m_wheel_count == 0)
+		m_wheel_frame = now;	// Idle wheel: nothing to catch up on
+	const qint64 target = qMax(now, m_wheel_frame) + qMax<qint64>(1, frames);
+	const quint32 rounds = static_cast<quint32>((target - m_wheel_frame - 1) / kWheelSlots);
+	m_wheel[target % kWheelSlots].push_back({id, std::move(resume), rounds});
+	m_wheel_count++;
+	arm();
+}
+
+TaskScheduler::WaitId TaskScheduler::wait_ms(qint64 ms, Resume resume)
+{
+	WaitId id = add_live();
+	add_to_wheel((qMax<qint64>(0, ms) + kFrameMs - 1) / kFrameMs, id, std::move(resume));
+	return id;
+}
+
+TaskScheduler::WaitId TaskScheduler::wait_frames(int frames, Resume resume)
+{
+	WaitId id = add_live();
+	add_to_wheel(frames, id, std::move(resume));
+	return id;
+}
+
+TaskScheduler::WaitId TaskScheduler::wait_beats(double beats, Resume resume)
+{
+	WaitId id = add_live();
+	const double target = MasterClock::instance().beat_position() + qMax(0.0, beats);
+	m_beats.push_back({target, id, std::move(resume)});
+	std::push_heap(m_beats.begin(), m_beats.end(), later_beat);
+	service_beats();
+	return id;
+}
+
+// In-place compaction step: move `w` down to `keep` unless already there
+template <typename It, typename T>
+static void keep_waiter(It &keep, T &w)
+{
+	if (&*keep != &w)
+		*keep = std::move(w);
+	++keep;
+}
+
+static bool satisfied(WaitCompare cmp, double v, double ref)
+{
+	switch (cmp) {
+	case WaitCompare::Greater:      return v > ref;
+	case WaitCompare::GreaterEqual: return v >= ref;
+	case WaitCompare::Less:         return v < ref;
+	case WaitCompare::LessEqual:    return v <= ref;
+	case WaitCompare::Equal:        return qFuzzyCompare(v + 1.0, ref + 1.0);
+	case WaitCompare::NotEqual:     return !qFuzzyCompare(v + 1.0, ref + 1.0);
+	case WaitCompare::Changed:      return true;
+	}
+	return false;
+}
+
+TaskScheduler::WaitId TaskScheduler::wait_port(ControlPort *port, WaitCompare cmp, double value,
+											   Resume resume)
+{
+	WaitId id = add_live();
+	if (!port) {
+		make_ready(id, std::move(resume), false);
+		return id;
+	}
+	// Already true: no need to park on the port
+	if (cmp != WaitCompare::Changed && satisfied(cmp, port->as_double(), value)) {
+		make_ready(id, std::move(resume));
+		return id;
+	}
+
+	auto it = m_ports.find(port);
+	if (it == m_ports.end()) {
+		PortQueue q;
+		q.changed = connect(port, &ControlPort::value_changed, this,
+			[this, port]() { on_port_changed(port); });
+		q.destroyed = connect(port, &QObject::destroyed, this, &TaskScheduler::on_port_destroyed);
+		it = m_ports.insert(port, std::move(q));
+	}
+	it->waiters.push_back({id, cmp, value, std::move(resume)});
+	m_port_of.insert(id, port);
+	return id;
+}
+
+void TaskScheduler::cancel(WaitId id)
+{
+	if (!m_live.remove(id))
+		return;
+
+	// Port waits: drop the waiter (and its captured task) right away
+	if (ControlPort *port = m_port_of.take(id)) {
+		auto it = m_ports.find(port);
+		if (it != m_ports.end()) {
+			auto &waiters = it->waiters;
+			waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+				[id](const PortWaiter &w) { return w.id == id; }), waiters.end());
+			if (waiters.empty()) {
+				disconnect(it->changed);
+				disconnect(it->destroyed);
+				m_ports.erase(it);
+			}
+		}
+		return;
+	}
+
+	// Beat waits: may otherwise sit out a stopped transport indefinitely
+	auto beat = std::find_if(m_beats.begin(), m_beats.end(),
+		[id](const BeatWaiter &w) { return w.id == id; });
+	if (beat != m_beats.end()) {
+		m_beats.erase(beat);
+		std::make_heap(m_beats.begin(), m_beats.end(), later_beat);
+		service_beats();
+		return;
+	}
+
+	// Wheel or ready queue: skipped when reached
+	m_cancelled.insert(id);
+}
+
+// ---------------------------------------------------------------------------
+// Wakeups
+// ---------------------------------------------------------------------------
+
+void TaskScheduler::make_ready(WaitId id, Resume resume, bool ok)
+{
+	if (m_cancelled.remove(id))
+		return;
+	m_ready.push_back({id, std::move(resume), ok});
+	arm();
+}
+
+void TaskScheduler::on_port_changed(ControlPort *port)
+{
+	auto it = m_ports.find(port);
+	if (it == m_ports.end())
+		return;
+
+	const double v = port->as_double();
+	auto &waiters = it->waiters;
+	auto keep = waiters.begin();
+	for (auto &w : waiters) {
+		if (satisfied(w.cmp, v, w.value)) {
+			m_port_of.remove(w.id);
+			make_ready(w.id, std::move(w.resume));
+		} else {
+			keep_waiter(keep, w);
+		}
+	}
+	waiters.erase(keep, waiters.end());
+
+	if (waiters.empty()) {
+		disconnect(it->changed);
+		disconnect(it->destroyed);
+		m_ports.erase(it);
+	}
+}
+
+void TaskScheduler::on_port_destroyed(QObject *obj)
+{
+	// Only the pointer value is used; the port is already gone
+	auto it = m_ports.find(static_cast<ControlPort *>(obj));
+	if (it == m_ports.end())
+		return;
+	PortQueue q = std::move(it.value());
+	m_ports.erase(it);
+	for (auto &w : q.waiters) {
+		m_port_of.remove(w.id);
+		make_ready(w.id, std::move(w.resume), false);
+	}
+}
+
+// Releases beat waits that are due, then aims m_beat_timer at the next one.
+// While the transport is stopped the position can't advance on its own, so
+// nothing is scheduled until transport_started.
+void TaskScheduler::service_beats()
+{
+	auto &clock = MasterClock::instance();
+	if (m_beats.empty()) {
+		m_beat_timer.stop();
+		return;
+	}
+
+	const double pos = clock.beat_position();
+	while (!m_beats.empty() && m_beats.front().beat <= pos) {
+		std::pop_heap(m_beats.begin(), m_beats.end(), later_beat);
+		BeatWaiter w = std::move(m_beats.back());
+		m_beats.pop_back();
+		make_ready(w.id, std::move(w.resume));
+	}
+
+	if (m_beats.empty() || !clock.is_running()) {
+		m_beat_timer.stop();
+		return;
+	}
+	const double ms = (m_beats.front().beat - pos) * 60000.0 / qMax(1.0, clock.bpm());
+	m_beat_timer.start(qMax(1, static_cast<int>(std::ceil(ms))));
+}
+
+// ---------------------------------------------------------------------------
+// Frame batch
+// ---------------------------------------------------------------------------
+
+void TaskScheduler::arm()
+{
+	const bool needed = !m_ready.empty() || m_wheel_count > 0;
+	if (needed && !m_frame_timer.isActive())
+		m_frame_timer.start();
+	else if (!needed && m_frame_timer.isActive())
+		m_frame_timer.stop();
+}
+
+void TaskScheduler::on_frame()
+{
+	// Advance the wheel to the current frame, one slot per elapsed frame
+	const qint64 now = now_frame();
+	if (m_wheel_count == 0)
+		m_wheel_frame = now;
+	while (m_wheel_frame < now && m_wheel_count > 0) {
+		m_wheel_frame++;
+		auto &slot = m_wheel[m_wheel_frame % kWheelSlots];
+		auto keep = slot.begin();
+		for (auto &w : slot) {
+			if (w.rounds == 0) {
+				m_wheel_count--;
+				make_ready(w.id, std::move(w.resume));
+			} else {
+				w.rounds--;
+				keep_waiter(keep, w);
+			}
+		}
+		slot.erase(keep, slot.end());
+	}
+	if (m_wheel_count == 0)
+		m_wheel_frame = now;
+
+	// Resume this frame's batch; anything it schedules waits for the next
+	m_running.swap(m_ready);
+	for (auto &r : m_running) {
+		if (!m_live.remove(r.id)) {
+			m_cancelled.remove(r.id);
+			continue;
+		}
+		r.resume(r.ok);
+	}
+	m_running.clear();
+
+	arm();
+}
+
+} // namespace super
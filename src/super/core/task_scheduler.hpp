@@ -0,0 +1,196 @@
+#pragma once
+
+// ============================================================================
+// TaskScheduler — Frame-batched waits for automation tasks.
+//
+// Suspended tasks (C++20 coroutines here, Lua coroutines in LuaEngine) park
+// in one of three wait queues and are resumed together once per frame:
+//
+//   • Time   — a hashed timer wheel with frame-sized slots
+//   • Port   — per-ControlPort lists, checked only on that port's
+//              value_changed (one connection per port, not per waiter)
+//   • Beat   — a min-heap on MasterClock beat position, served by a
+//              one-shot timer aimed at the earliest target and re-aimed on
+//              MasterClock's beat and transport signals
+//
+// The frame timer runs only while something is due or time-bound, so any
+// number of tasks waiting on ports, or on beats while the transport is
+// stopped, costs nothing until a port or the clock moves.
+// ============================================================================
+
+#include <QHash>
+#include <QSet>
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <coroutine>
+#include <functional>
+#include <vector>
+
+namespace super {
+
+class ControlPort;
+
+// Condition for port waits
+enum class WaitCompare : quint8 { Greater, GreaterEqual, Less, LessEqual, Equal, NotEqual, Changed };
+
+// ---------------------------------------------------------------------------
+// TaskScheduler
+// ---------------------------------------------------------------------------
+class TaskScheduler : public QObject {
+	Q_OBJECT
+
+public:
+	// Resume callback. `ok` is false when the wait was abandoned because
+	// the port it watched was destroyed.
+	using Resume = std::function<void(bool ok)>;
+	using WaitId = quint64;
+
+	static TaskScheduler &instance();
+
+	static constexpr int kFrameMs = 16;
+	static constexpr int kWheelSlots = 512;		// ~8 s per revolution
+
+	WaitId wait_ms(qint64 ms, Resume resume);
+	WaitId wait_frames(int frames, Resume resume);
+	WaitId wait_beats(double beats, Resume resume);
+	WaitId wait_port(ControlPort *port, WaitCompare cmp, double value, Resume resume);
+
+	// Drop a pending wait without resuming it. Port and beat waits release
+	// their Resume immediately; time waits when their slot comes round.
+	void cancel(WaitId id);
+
+	// Waits registered and not yet resumed or cancelled.
+	int pending() const { return m_live.size(); }
+
+private:
+	TaskScheduler();
+	~TaskScheduler() override;
+
+	struct Waiter {
+		WaitId id;
+		Resume resume;
+		quint32 rounds = 0;		// Wheel revolutions still to go
+	};
+	struct BeatWaiter {
+		double beat;
+		WaitId id;
+		Resume resume;
+	};
+	// Heap order for m_beats: earliest target on top
+	static bool later_beat(const BeatWaiter &a, const BeatWaiter &b) { return a.beat > b.beat; }
+	struct PortWaiter {
+		WaitId id;
+		WaitCompare cmp;
+		double value;
+		Resume resume;
+	};
+	struct PortQueue {
+		QMetaObject::Connection changed;
+		QMetaObject::Connection destroyed;
+		std::vector<PortWaiter> waiters;
+	};
+
+	WaitId add_live();
+	qint64 now_frame() const { return m_clock.elapsed() / kFrameMs; }
+	void add_to_wheel(qint64 frames, WaitId id, Resume resume);
+	void make_ready(WaitId id, Resume resume, bool ok = true);
+	void on_port_changed(ControlPort *port);
+	void on_port_destroyed(QObject *port);
+	void service_beats();
+	void arm();
+	void on_frame();
+
+	// Timer wheel
+	std::vector<std::vector<Waiter>> m_wheel;
+	qint64 m_wheel_frame = 0;		// Frame index of the slot processed last
+	int m_wheel_count = 0;
+	QElapsedTimer m_clock;
+
+	std::vector<BeatWaiter> m_beats;	// Min-heap on beat
+	QTimer m_beat_timer;
+	QHash<ControlPort *, PortQueue> m_ports;
+	QHash<WaitId, ControlPort *> m_port_of;		// Parked port waits, for cancel()
+
+	struct Ready { WaitId id; Resume resume; bool ok; };
+	std::vector<Ready> m_ready;
+	std::vector<Ready> m_running;		// Batch being resumed (swapped with m_ready)
+
+	QSet<WaitId> m_live;
+	QSet<WaitId> m_cancelled;		// Still queued somewhere; dropped when reached
+	WaitId m_last_id = 0;
+	QTimer m_frame_timer;
+};
+
+// ===========================================================================
+// C++20 coroutines for native automations
+//
+//   super::Task blink(ControlPort *led) {
+//       for (;;) {
+//           led->set_value(true);
+//           co_await super::wait_beats(0.5);
+//           led->set_value(false);
+//           if (!co_await super::wait_until(gate, WaitCompare::Greater, 0.5))
+//               co_return;    // port destroyed
+//       }
+//   }
+//
+// A Task starts immediately and owns its own frame, which is freed when the
+// coroutine finishes. Waits resume on the Qt thread in the frame batch.
+// ===========================================================================
+
+struct Task {
+	struct promise_type {
+		Task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+// Awaitable wrapping one TaskScheduler wait; co_await yields `ok`.
+class TaskWait {
+public:
+	using Register = std::function<void(TaskScheduler::Resume)>;
+	explicit TaskWait(Register reg) : m_register(std::move(reg)) {}
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		m_register([this, h](bool ok) {
+			m_ok = ok;
+			h.resume();
+		});
+	}
+	bool await_resume() const noexcept { return m_ok; }
+
+private:
+	Register m_register;
+	bool m_ok = true;
+};
+
+inline TaskWait wait_ms(qint64 ms)
+{
+	return TaskWait([ms](TaskScheduler::Resume r) { TaskScheduler::instance().wait_ms(ms, std::move(r)); });
+}
+
+inline TaskWait next_frame()
+{
+	return TaskWait([](TaskScheduler::Resume r) { TaskScheduler::instance().wait_frames(1, std::move(r)); });
+}
+
+inline TaskWait wait_beats(double beats)
+{
+	return TaskWait([beats](TaskScheduler::Resume r) { TaskScheduler::instance().wait_beats(beats, std::move(r)); });
+}
+
+inline TaskWait wait_until(ControlPort *port, WaitCompare cmp, double value)
+{
+	return TaskWait([port, cmp, value](TaskScheduler::Resume r) {
+		TaskScheduler::instance().wait_port(port, cmp, value, std::move(r));
+	});
+}
+
+} // namespace super
@@ -0,0 +1,282 @@
+// ============================================================================
+// Undo/Redo System — Implementation
+// ============================================================================
+
+#include "undo_manager.hpp"
+
+#include <QJsonValue>
+
+namespace super {
+
+// Values stored inline in a PortDelta; anything else is pooled
+static bool is_inline(const QVariant &v)
+{
+	return v.typeId() == QMetaType::Double;
+}
+
+// ---------------------------------------------------------------------------
+// UndoEntry
+// ---------------------------------------------------------------------------
+
+void UndoEntry::merge(quint32 handle, const QVariant &old_val, const QVariant &new_val, qint64 time_ms)
+{
+	m_last_ms = time_ms;
+	for (PortDelta &d : m_deltas) {
+		if (d.handle != handle)
+			continue;
+		if (!d.boxed && is_inline(new_val)) {
+			d.new_val = new_val.toDouble();
+		} else if (d.boxed) {
+			m_variants[static_cast<size_t>(d.new_val)] = new_val;
+		} else {
+			// Type changed mid-gesture: move this delta into the pool
+			m_variants.push_back(QVariant(d.old_val));
+			d.old_val = static_cast<double>(m_variants.size() - 1);
+			m_variants.push_back(new_val);
+			d.new_val = static_cast<double>(m_variants.size() - 1);
+			d.boxed = 1;
+		}
+		return;
+	}
+
+	if (is_inline(old_val) && is_inline(new_val)) {
+		m_deltas.push_back({handle, 0, old_val.toDouble(), new_val.toDouble()});
+	} else {
+		m_variants.push_back(old_val);
+		m_variants.push_back(new_val);
+		const double i = static_cast<double>(m_variants.size());
+		m_deltas.push_back({handle, 1, i - 2, i - 1});
+	}
+}
+
+QVariant UndoEntry::value_at(const PortDelta &d, bool forward) const
+{
+	const double v = forward ? d.new_val : d.old_val;
+	return d.boxed ? m_variants[static_cast<size_t>(v)] : QVariant(v);
+}
+
+bool UndoEntry::is_noop() const
+{
+	for (const PortDelta &d : m_deltas) {
+		if (d.boxed ? value_at(d, false) != value_at(d, true) : d.old_val != d.new_val)
+			return false;
+	}
+	return true;
+}
+
+void UndoEntry::apply(bool forward, const QStringList &port_ids) const
+{
+	if (m_kind == Kind::Snapshot) {
+		QJsonObject partial;
+		for (const PortDelta &d : m_deltas)
+			partial.insert(port_ids[d.handle], QJsonValue::fromVariant(value_at(d, forward)));
+		ControlRegistry::instance().restore_snapshot(partial);
+		return;
+	}
+
+	// Undo in reverse so a port touched twice ends at its oldest value
+	auto &registry = ControlRegistry::instance();
+	const int n = size();
+	for (int k = 0; k < n; k++) {
+		const PortDelta &d = m_deltas[forward ? k : n - 1 - k];
+		if (auto *port = registry.find(port_ids[d.handle]))
+			port->set_value(value_at(d, forward));
+	}
+}
+
+qsizetype UndoEntry::bytes() const
+{
+	qsizetype b = sizeof(*this) + static_cast<qsizetype>(m_deltas.capacity() * sizeof(PortDelta)) +
+				  static_cast<qsizetype>(m_variants.capacity() * sizeof(QVariant));
+	for (const QVariant &v : m_variants) {
+		if (v.typeId() == QMetaType::QString)
+			b += v.toString().size() * static_cast<qsizetype>(sizeof(QChar));
+		else if (v.typeId() == QMetaType::QByteArray)
+			b += v.toByteArray().size();
+	}
+	return b;
+}
+
+QString UndoEntry::text(const QStringList &port_ids) const
+{
+	if (m_kind == Kind::Snapshot)
+		return "Snapshot";
+	if (m_deltas.size() == 1)
+		return "Change " + port_ids[m_deltas.front().handle];
+	return QString("Change %1 ports").arg(m_deltas.size());
+}
+
+// ---------------------------------------------------------------------------
+// UndoManager
+// ---------------------------------------------------------------------------
+
+UndoManager &UndoManager::instance()
+{
+	static UndoManager s;
+	return s;
+}
+
+UndoManager::UndoManager() : QObject(nullptr)
+{
+	m_clock.start();
+}
+
+quint32 UndoManager::handle_for(const QString &port_id)
+{
+	auto it = m_handles.constFind(port_id);
+	if (it != m_handles.constEnd())
+		return *it;
+	const quint32 h = static_cast<quint32>(m_port_ids.size());
+	m_port_ids.append(port_id);
+	m_handles.insert(port_id, h);
+	// String payload twice (list + hash key) plus rough node overhead
+	m_ids_bytes += 2 * (sizeof(QString) + port_id.size() * sizeof(QChar)) + 16;
+	return h;
+}
+
+void UndoManager::record(const QString &port_id,
+						 const QVariant &old_val, const QVariant &new_val)
+{
+	if (m_applying || old_val == new_val)
+		return;
+
+	const qint64 now = m_clock.elapsed();
+	const quint32 handle = handle_for(port_id);
+	truncate_redo();
+
+	UndoEntry *top = m_index > 0 ? m_entries[m_index - 1].get() : nullptr;
+	if (top && top->kind() == UndoEntry::Kind::Gesture && !top->sealed() &&
+		now - top->last_ms() <= m_window_ms) {
+		m_bytes -= top->bytes();
+		top->merge(handle, old_val, new_val, now);
+		if (top->is_noop()) {
+			// Dragged back to where it started: nothing to undo
+			m_entries.pop_back();
+			m_index--;
+		} else {
+			m_bytes += top->bytes();
+		}
+		enforce_limits();
+		emit history_changed();
+		return;
+	}
+
+	auto entry = std::make_unique<UndoEntry>(UndoEntry::Kind::Gesture, now);
+	entry->merge(handle, old_val, new_val, now);
+	push(std::move(entry));
+}
+
+void UndoManager::record_snapshot(const QJsonObject &before,
+								  const QJsonObject &after)
+{
+	if (m_applying)
+		return;
+	end_gesture();
+
+	const qint64 now = m_clock.elapsed();
+	auto entry = std::make_unique<UndoEntry>(UndoEntry::Kind::Snapshot, now);
+	for (auto it = after.constBegin(); it != after.constEnd(); ++it) {
+		const QJsonValue old = before.value(it.key());
+		if (old.isUndefined() || old == it.value())
+			continue;	// Unchanged, or no value to go back to
+		entry->merge(handle_for(it.key()), old.toVariant(), it.value().toVariant(), now);
+	}
+	if (entry->size() == 0)
+		return;
+	entry->seal();
+	push(std::move(entry));
+}
+
+void UndoManager::end_gesture()
+{
+	if (m_index > 0)
+		m_entries[m_index - 1]->seal();
+}
+
+void UndoManager::push(std::unique_ptr<UndoEntry> entry)
+{
+	truncate_redo();
+	m_bytes += entry->bytes();
+	m_entries.push_back(std::move(entry));
+	m_index = count();
+	enforce_limits();
+	emit history_changed();
+}
+
+void UndoManager::truncate_redo()
+{
+	while (count() > m_index) {
+		m_bytes -= m_entries.back()->bytes();
+		m_entries.pop_back();
+	}
+}
+
+// Evicts from the oldest end, never the only undoable entry
+void UndoManager::enforce_limits()
+{
+	while (m_index > 1 &&
+		   ((m_limit > 0 && count() > m_limit) || memory_used() > m_budget)) {
+		m_bytes -= m_entries.front()->bytes();
+		m_entries.pop_front();
+		m_index--;
+		m_evicted++;
+	}
+}
+
+void UndoManager::undo()
+{
+	if (!can_undo())
+		return;
+	end_gesture();
+	m_applying = true;
+	m_entries[--m_index]->apply(false, m_port_ids);
+	m_applying = false;
+	emit history_changed();
+}
+
+void UndoManager::redo()
+{
+	if (!can_redo())
+		return;
+	m_applying = true;
+	m_entries[m_index++]->apply(true, m_port_ids);
+	m_applying = false;
+	emit history_changed();
+}
+
+void UndoManager::clear()
+{
+	m_entries.clear();
+	m_index = 0;
+	m_bytes = 0;
+	m_port_ids.clear();
+	m_handles.clear();
+	m_ids_bytes = 0;
+	emit history_changed();
+}
+
+QString UndoManager::undo_text() const
+{
+	return can_undo() ? m_entries[m_index - 1]->text(m_port_ids) : QString();
+}
+
+QString UndoManager::redo_text() const
+{
+	return can_redo() ? m_entries[m_index]->text(m_port_ids) : QString();
+}
+
+void UndoManager::set_undo_limit(int limit)
+{
+	m_limit = qMax(0, limit);
+	enforce_limits();
+	emit history_changed();
+}
+
+void UndoManager::set_memory_budget(qsizetype bytes)
+{
+	m_budget = qMax<qsizetype>(0, bytes);
+	enforce_limits();
+	emit history_changed();
+}
+
+} // namespace super
@@ -1,135 +1,149 @@
 #pragma once
 
 // ============================================================================
-// Undo/Redo System — Transaction-based history for ControlPorts.
+// Undo/Redo System — Gesture-based history for ControlPorts.
 //
-// Uses Qt's QUndoStack with a custom QUndoCommand that captures
-// ControlPort value changes with coalescing support.
+// Port changes recorded within a short window of each other coalesce into
+// one gesture, however many ports they touch, so dragging several faders
+// at once is a single undo step. Entries store compact deltas
+// (port handle, old, new) and the history is bounded by a byte budget as
+// well as an entry count; the oldest entries are evicted first.
 // ============================================================================
 
 #include "control_port.hpp"
 #include "control_registry.hpp"
 
 #include <QObject>
-#include <QUndoStack>
-#include <QUndoCommand>
+#include <QElapsedTimer>
 #include <QVariant>
 #include <QHash>
 #include <QJsonObject>
+#include <QStringList>
+#include <deque>
+#include <memory>
+#include <vector>
 
 namespace super {
 
 // ---------------------------------------------------------------------------
-// PortChangeCommand — A single port value change, undoable.
-// Supports mergeWith() for coalescing rapid changes (e.g. fader drags).
+// PortDelta — One port's change inside an entry (24 bytes). Numeric values
+// are stored inline; other types go to the entry's variant pool and
+// old/new hold their indices.
 // ---------------------------------------------------------------------------
-class PortChangeCommand : public QUndoCommand {
-public:
-	PortChangeCommand(const QString &port_id,
-					   const QVariant &old_val,
-					   const QVariant &new_val,
-					   QUndoCommand *parent = nullptr)
-		: QUndoCommand(parent)
-		, m_port_id(port_id)
-		, m_old_val(old_val)
-		, m_new_val(new_val)
-		, m_coalesce_id(qHash(port_id))
-	{
-		setText("Change " + port_id);
-	}
-
-	void undo() override {
-		if (auto *port = ControlRegistry::instance().find(m_port_id))
-			port->set_value(m_old_val);
-	}
-
-	void redo() override {
-		if (auto *port = ControlRegistry::instance().find(m_port_id))
-			port->set_value(m_new_val);
-	}
-
-	int id() const override { return static_cast<int>(m_coalesce_id); }
-
-	bool mergeWith(const QUndoCommand *other) override {
-		auto *cmd = dynamic_cast<const PortChangeCommand *>(other);
-		if (!cmd || cmd->m_port_id != m_port_id)
-			return false;
-		m_new_val = cmd->m_new_val;
-		return true;
-	}
-
-private:
-	QString m_port_id;
-	QVariant m_old_val;
-	QVariant m_new_val;
-	uint m_coalesce_id;
+struct PortDelta {
+	quint32 handle;		// Index into UndoManager's port id table
+	quint32 boxed;		// 1 if old/new index the variant pool
+	double old_val;
+	double new_val;
 };
 
 // ---------------------------------------------------------------------------
-// SnapshotCommand — Captures/restores the entire registry state.
+// UndoEntry — One undo step: a port gesture or a snapshot restore.
 // ---------------------------------------------------------------------------
-class SnapshotCommand : public QUndoCommand {
+class UndoEntry {
 public:
-	SnapshotCommand(const QJsonObject &before, const QJsonObject &after,
-					 QUndoCommand *parent = nullptr)
-		: QUndoCommand("Snapshot", parent)
-		, m_before(before), m_after(after)
-	{
-	}
+	enum class Kind { Gesture, Snapshot };
+
+	UndoEntry(Kind kind, qint64 time_ms) : m_kind(kind), m_first_ms(time_ms), m_last_ms(time_ms) {}
 
-	void undo() override {
-		ControlRegistry::instance().restore_snapshot(m_before);
-	}
+	Kind kind() const { return m_kind; }
+	int size() const { return static_cast<int>(m_deltas.size()); }
+	qint64 last_ms() const { return m_last_ms; }
+	bool sealed() const { return m_sealed; }
+	void seal() { m_sealed = true; }
 
-	void redo() override {
-		ControlRegistry::instance().restore_snapshot(m_after);
-	}
+	// Adds or updates the delta for `handle`; the first old value is kept.
+	void merge(quint32 handle, const QVariant &old_val, const QVariant &new_val, qint64 time_ms);
+	// True if every port is back to its old value.
+	bool is_noop() const;
+
+	void apply(bool forward, const QStringList &port_ids) const;
+	qsizetype bytes() const;
+	QString text(const QStringList &port_ids) const;
 
 private:
-	QJsonObject m_before, m_after;
+	QVariant value_at(const PortDelta &d, bool forward) const;
+
+	Kind m_kind;
+	bool m_sealed = false;
+	qint64 m_first_ms;
+	qint64 m_last_ms;
+	std::vector<PortDelta> m_deltas;
+	std::vector<QVariant> m_variants;	// Pool for non-numeric values
 };
 
 // ---------------------------------------------------------------------------
-// UndoManager — Singleton wrapper around QUndoStack.
+// UndoManager — Singleton history.
 // ---------------------------------------------------------------------------
 class UndoManager : public QObject {
 	Q_OBJECT
 
 public:
-	static UndoManager &instance() {
-		static UndoManager s;
-		return s;
-	}
-
-	QUndoStack *stack() { return &m_stack; }
+	static UndoManager &instance();
 
-	// Record a port value change
+	// Record a port value change; joins the open gesture if the previous
+	// change was less than coalesce_window() ms ago.
 	void record(const QString &port_id,
-				const QVariant &old_val, const QVariant &new_val) {
-		m_stack.push(new PortChangeCommand(port_id, old_val, new_val));
-	}
+				const QVariant &old_val, const QVariant &new_val);
 
-	// Record a full snapshot change
+	// Record a full snapshot change (stored as the ports that differ).
 	void record_snapshot(const QJsonObject &before,
-						  const QJsonObject &after) {
-		m_stack.push(new SnapshotCommand(before, after));
-	}
+						  const QJsonObject &after);
 
-	void undo() { m_stack.undo(); }
-	void redo() { m_stack.redo(); }
-	bool can_undo() const { return m_stack.canUndo(); }
-	bool can_redo() const { return m_stack.canRedo(); }
-	void clear() { m_stack.clear(); }
+	// Close the open gesture (e.g. on mouse release).
+	void end_gesture();
 
-	int undo_limit() const { return m_stack.undoLimit(); }
-	void set_undo_limit(int limit) { m_stack.setUndoLimit(limit); }
+	void undo();
+	void redo();
+	bool can_undo() const { return m_index > 0; }
+	bool can_redo() const { return m_index < static_cast<int>(m_entries.size()); }
+	void clear();
 
-private:
-	UndoManager() : QObject(nullptr) {
-		m_stack.setUndoLimit(200);
-	}
+	int count() const { return static_cast<int>(m_entries.size()); }
+	QString undo_text() const;
+	QString redo_text() const;
 
-	QUndoStack m_stack;
+	// -- Limits --
+	int coalesce_window() const { return m_window_ms; }
+	void set_coalesce_window(int ms) { m_window_ms = qMax(0, ms); }
+
+	// Maximum entries; 0 = unlimited.
+	int undo_limit() const { return m_limit; }
+	void set_undo_limit(int limit);
+
+	qsizetype memory_budget() const { return m_budget; }
+	void set_memory_budget(qsizetype bytes);
+
+	// -- Stats --
+	// Bytes held by entries plus the port id table.
+	qsizetype memory_used() const { return m_bytes + m_ids_bytes; }
+	quint64 evicted() const { return m_evicted; }
+
+signals:
+	void history_changed();
+
+private:
+	UndoManager();
+
+	quint32 handle_for(const QString &port_id);
+	void push(std::unique_ptr<UndoEntry> entry);
+	void truncate_redo();
+	void enforce_limits();
+
+	std::deque<std::unique_ptr<UndoEntry>> m_entries;
+	int m_index = 0;			// Entries [0, m_index) are undoable
+	qsizetype m_bytes = 0;		// Sum of entry bytes()
+
+	QStringList m_port_ids;		// Handle → port id
+	QHash<QString, quint32> m_handles;
+	qsizetype m_ids_bytes = 0;
+
+	QElapsedTimer m_clock;
+	int m_window_ms = 400;
+	int m_limit = 200;
+	qsizetype m_budget = 1024 * 1024;
+	quint64 m_evicted = 0;
+	bool m_applying = false;	// Ignore record() while undoing/redoing
 };
 
 } // namespace super
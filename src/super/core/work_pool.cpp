@@ -0,0 +1,186 @@
+#include "work_pool.hpp"
+
+#include <QThread>
+#include <algorithm>
+
+namespace super {
+
+WorkPool &WorkPool::instance()
+{
+	static WorkPool pool;
+	return pool;
+}
+
+WorkPool::WorkPool()
+{
+	start_threads(qMax(0, QThread::idealThreadCount() - 1));
+}
+
+WorkPool::~WorkPool()
+{
+	stop_threads();
+}
+
+void WorkPool::set_worker_count(int count)
+{
+	count = qMax(0, count);
+	if (count == worker_count() || m_busy.exchange(true))
+		return;
+	stop_threads();
+	start_threads(count);
+	m_busy = false;
+}
+
+void WorkPool::start_threads(int count)
+{
+	m_quit = false;
+	m_slots.clear();
+	for (int i = 0; i <= count; i++)
+		m_slots.push_back(std::make_unique<Slot>());
+	for (int i = 0; i < count; i++) {
+		QThread *t = QThread::create([this, i]() { worker_main(i + 1); });
+		t->setObjectName(QString("super-work-%1").arg(i + 1));
+		t->start();
+		m_threads.push_back(t);
+	}
+}
+
+void WorkPool::stop_threads()
+{
+	{
+		QMutexLocker lock(&m_wake_mutex);
+		m_quit = true;
+		m_wake.wakeAll();
+	}
+	for (QThread *t : m_threads) {
+		t->wait();
+		delete t;
+	}
+	m_threads.clear();
+}
+
+// ---------------------------------------------------------------------------
+// parallel_for
+// ---------------------------------------------------------------------------
+
+void WorkPool::parallel_for(int count, const std::function<void(int)> &fn, int grain)
+{
+	if (count <= 0)
+		return;
+	grain = qMax(1, grain);
+	if (m_threads.empty() || count <= grain || m_busy.exchange(true)) {
+		for (int i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	m_fn = &fn;
+	m_grain = grain;
+	m_remaining = count;
+
+	// Seed every slot with an equal share
+	int slots = static_cast<int>(m_slots.size());
+	int share = (count + slots - 1) / slots;
+	for (int s = 0, begin = 0; s < slots && begin < count; s++, begin += share) {
+		QMutexLocker lock(&m_slots[s]->mutex);
+		m_slots[s]->queue.push_back({begin, std::min(count, begin + share)});
+	}
+
+	m_open = true;
+	{
+		QMutexLocker lock(&m_wake_mutex);
+		m_job_serial++;
+		m_wake.wakeAll();
+	}
+
+	run_job(0);
+	while (m_remaining.load(std::memory_order_acquire) > 0)
+		QThread::yieldCurrentThread();
+
+	// Workers that woke late must leave before `fn` goes out of scope
+	m_open = false;
+	while (m_active.load(std::memory_order_acquire) > 0)
+		QThread::yieldCurrentThread();
+
+	m_fn = nullptr;
+	m_busy = false;
+}
+
+// ---------------------------------------------------------------------------
+// Workers
+// ---------------------------------------------------------------------------
+
+void WorkPool::worker_main(int slot)
+{
+	quint64 seen = 0;
+	for (;;) {
+		{
+			QMutexLocker lock(&m_wake_mutex);
+			while (!m_quit && m_job_serial == seen)
+				m_wake.wait(&m_wake_mutex);
+			if (m_quit)
+				return;
+			seen = m_job_serial;
+		}
+
+		m_active.fetch_add(1);
+		if (m_open.load())
+			run_job(slot);
+		m_active.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void WorkPool::run_job(int slot)
+{
+	Range r;
+	while (m_remaining.load(std::memory_order_acquire) > 0) {
+		if (pop_local(slot, r) || steal(slot, r))
+			execute(slot, r);
+		else
+			QThread::yieldCurrentThread();
+	}
+}
+
+void WorkPool::execute(int slot, Range r)
+{
+	// Keep the front half, expose the back half to thieves
+	while (r.end - r.begin > m_grain) {
+		int mid = r.begin + (r.end - r.begin) / 2;
+		{
+			QMutexLocker lock(&m_slots[slot]->mutex);
+			m_slots[slot]->queue.push_back({mid, r.end});
+		}
+		r.end = mid;
+	}
+	for (int i = r.begin; i < r.end; i++)
+		(*m_fn)(i);
+	m_remaining.fetch_sub(r.end - r.begin, std::memory_order_release);
+}
+
+bool WorkPool::pop_local(int slot, Range &r)
+{
+	Slot &s = *m_slots[slot];
+	QMutexLocker lock(&s.mutex);
+	if (s.queue.empty())
+		return false;
+	r = s.queue.back();  // Newest (smallest, cache-warm) first
+	s.queue.pop_back();
+	return true;
+}
+
+bool WorkPool::steal(int slot, Range &r)
+{
+	int n = static_cast<int>(m_slots.size());
+	for (int k = 1; k < n; k++) {
+		Slot &victim = *m_slots[(slot + k) % n];
+		QMutexLocker lock(&victim.mutex);
+		if (victim.queue.empty())
+			continue;
+		r = victim.queue.front();  // Oldest (largest) chunk
+		victim.queue.pop_front();
+		return true;
+	}
+	return false;
+}
+
+} // namespace super
@@ -0,0 +1,84 @@
+#pragma once
+
+// ============================================================================
+// WorkPool — Small work-stealing thread pool for data-parallel loops.
+// ============================================================================
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// WorkPool
+//
+// parallel_for() hands each worker a slice of the index range. A worker
+// splits its slice in half repeatedly, keeping the front and pushing the
+// back onto its own deque; idle workers steal from the far end of other
+// deques, so large chunks move first and imbalance evens out. The calling
+// thread works as slot 0 and returns once every index has run.
+//
+// One loop runs at a time. Nested or concurrent calls fall back to running
+// serially on the caller.
+// ---------------------------------------------------------------------------
+class WorkPool {
+public:
+	static WorkPool &instance();
+
+	~WorkPool();
+
+	// Background threads (the caller is an extra participant). 0 = serial.
+	int worker_count() const { return static_cast<int>(m_threads.size()); }
+	void set_worker_count(int count);
+
+	// Run fn(i) for every i in [0, count). Ranges of `grain` indices or
+	// fewer are never split further.
+	void parallel_for(int count, const std::function<void(int)> &fn, int grain = 1);
+
+private:
+	WorkPool();
+
+	struct Range {
+		int begin;
+		int end;
+	};
+
+	struct Slot {
+		QMutex mutex;
+		std::deque<Range> queue;
+	};
+
+	void start_threads(int count);
+	void stop_threads();
+	void worker_main(int slot);
+	void run_job(int slot);
+	void execute(int slot, Range r);
+	bool pop_local(int slot, Range &r);
+	bool steal(int slot, Range &r);
+
+	std::vector<QThread *> m_threads;
+	std::vector<std::unique_ptr<Slot>> m_slots;	// [0] = caller
+
+	// Current job
+	const std::function<void(int)> *m_fn = nullptr;
+	int m_grain = 1;
+	std::atomic<int> m_remaining{0};
+	std::atomic<int> m_active{0};
+	std::atomic<bool> m_open{false};
+	std::atomic<bool> m_busy{false};
+
+	// Wake-up
+	QMutex m_wake_mutex;
+	QWaitCondition m_wake;
+	quint64 m_job_serial = 0;
+	bool m_quit = false;
+};
+
+} // namespace super
@@ -0,0 +1,364 @@
+#include "debug_monitor.hpp"
+
+#include <QVarLengthArray>
+#include <algorithm>
+#include <limits>
+
+namespace super {
+
+static constexpr quint64 kNoBlock = std::numeric_limits<quint64>::max();
+
+// ---------------------------------------------------------------------------
+// SignalTrace
+// ---------------------------------------------------------------------------
+
+SignalTrace::SignalTrace(ControlPort *port, int max_entries, QObject *parent)
+	: QObject(parent), m_port(port), m_cap(qMax(1, max_entries))
+{
+	m_ring.resize(m_cap);
+	m_min_dq.buf.resize(m_cap);
+	m_max_dq.buf.resize(m_cap);
+
+	// Enough slots per level for every block that can overlap the window
+	for (int shift = kFanoutBits; shift < 63 && (qint64(1) << shift) <= m_cap; shift += kFanoutBits) {
+		Level level;
+		level.shift = shift;
+		const size_t slots = static_cast<size_t>(m_cap >> shift) + 2;
+		level.tag.assign(slots, kNoBlock);
+		level.blocks.resize(slots);
+		m_levels.push_back(std::move(level));
+	}
+
+	m_timer.start();
+	connect(port, &ControlPort::value_changed, this,
+		[this](const QVariant &val) { record(val.toDouble()); });
+}
+
+void SignalTrace::push_extreme(MonoDeque &dq, quint64 seq, bool keep_min)
+{
+	const double v = m_ring[slot(seq)].value;
+	while (dq.count > 0) {
+		const double back = m_ring[slot(dq.back())].value;
+		if (keep_min ? back < v : back > v)
+			break;
+		dq.pop_back();
+	}
+	dq.push_back(seq);
+}
+
+void SignalTrace::record(double value)
+{
+	const quint64 seq = m_next++;
+	if (m_size == m_cap)
+		m_first++;
+	else
+		m_size++;
+
+	// Drop evicted indexes before their ring slot is reused
+	while (m_min_dq.count > 0 && m_min_dq.front() < m_first)
+		m_min_dq.pop_front();
+	while (m_max_dq.count > 0 && m_max_dq.front() < m_first)
+		m_max_dq.pop_front();
+
+	TraceEntry &e = m_ring[slot(seq)];
+	e.timestamp_ms = m_timer.elapsed();
+	e.value = value;
+	e.source.clear();
+
+	push_extreme(m_min_dq, seq, true);
+	push_extreme(m_max_dq, seq, false);
+
+	for (auto &level : m_levels) {
+		const quint64 block = seq >> level.shift;
+		const size_t i = block % level.tag.size();
+		if (level.tag[i] != block) {
+			level.tag[i] = block;
+			level.blocks[i] = {value, value};
+		} else {
+			level.blocks[i].min = qMin(level.blocks[i].min, value);
+			level.blocks[i].max = qMax(level.blocks[i].max, value);
+		}
+	}
+
+	emit entry_added(e);
+}
+
+QList<TraceEntry> SignalTrace::entries() const
+{
+	QList<TraceEntry> out;
+	out.reserve(m_size);
+	for (int i = 0; i < m_size; i++)
+		out.append(at(i));
+	return out;
+}
+
+void SignalTrace::clear()
+{
+	// Sequence numbers keep counting so stale pyramid tags can't match
+	m_first = m_next;
+	m_size = 0;
+	m_min_dq.count = 0;
+	m_max_dq.count = 0;
+	for (auto &level : m_levels)
+		std::fill(level.tag.begin(), level.tag.end(), kNoBlock);
+	m_timer.restart();
+}
+
+double SignalTrace::min_value() const
+{
+	return m_size ? m_ring[slot(m_min_dq.front())].value : 0.0;
+}
+
+double SignalTrace::max_value() const
+{
+	return m_size ? m_ring[slot(m_max_dq.front())].value : 0.0;
+}
+
+// Walks [from, to) taking the largest aligned pyramid block that fits at each
+// step, so at most kFanout - 1 steps per level on either side of the peak.
+SignalTrace::Range SignalTrace::range(int from, int to) const
+{
+	from = qMax(0, from);
+	to = qMin(m_size, to);
+	if (from >= to)
+		return {0.0, 0.0};
+	if (from == 0 && to == m_size)
+		return {min_value(), max_value()};
+
+	quint64 a = m_first + from;
+	const quint64 b = m_first + to;
+	Range r{std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+
+	while (a < b) {
+		const Range *block = nullptr;
+		quint64 span = 1;
+		for (auto level = m_levels.rbegin(); level != m_levels.rend(); ++level) {
+			const quint64 size = quint64(1) << level->shift;
+			if ((a & (size - 1)) != 0 || a + size > b)
+				continue;
+			const quint64 n = a >> level->shift;
+			const size_t i = n % level->tag.size();
+			if (level->tag[i] != n)
+				continue;
+			block = &level->blocks[i];
+			span = size;
+			break;
+		}
+		if (block) {
+			r.min = qMin(r.min, block->min);
+			r.max = qMax(r.max, block->max);
+		} else {
+			const double v = m_ring[slot(a)].value;
+			r.min = qMin(r.min, v);
+			r.max = qMax(r.max, v);
+		}
+		a += span;
+	}
+	return r;
+}
+
+QVector<SignalTrace::Range> SignalTrace::envelope(int columns, int from, int to) const
+{
+	from = qMax(0, from);
+	to = to < 0 ? m_size : qMin(m_size, to);
+	const qint64 n = to - from;
+	QVector<Range> out;
+	if (n <= 0 || columns <= 0)
+		return out;
+
+	columns = static_cast<int>(qMin<qint64>(columns, n));
+	out.reserve(columns);
+	for (int c = 0; c < columns; c++) {
+		const int a = from + static_cast<int>(n * c / columns);
+		const int b = from + static_cast<int>(n * (c + 1) / columns);
+		out.append(range(a, b));
+	}
+	return out;
+}
+
+// ---------------------------------------------------------------------------
+// DebugMonitor — Breakpoints
+// ---------------------------------------------------------------------------
+
+int DebugMonitor::add_breakpoint(const PortBreakpoint &bp)
+{
+	auto *port = ControlRegistry::instance().find(bp.port_id);
+	if (!port)
+		return 0;
+
+	auto it = m_watches.find(port);
+	if (it == m_watches.end()) {
+		PortWatch w;
+		w.changed = connect(port, &ControlPort::value_changed, this,
+			[this, port](const QVariant &val) { on_port_changed(port, val.toDouble()); });
+		w.destroyed = connect(port, &QObject::destroyed, this, &DebugMonitor::on_port_destroyed);
+		it = m_watches.insert(port, std::move(w));
+	}
+
+	const int id = m_next_bp_id++;
+	const bool range = bp.condition == BreakCondition::OnRange;
+	const quint32 every = static_cast<quint32>(qMax(1, bp.sample_every));
+	it->points.push_back({id, bp.condition, bp.enabled, port->as_double() >= bp.threshold,
+						  range ? bp.range_min : bp.threshold, bp.range_max, every, every, 0});
+	m_bp_port.insert(id, port);
+	if (bp.callback)
+		m_callbacks.insert(id, bp.callback);
+	return id;
+}
+
+void DebugMonitor::remove_breakpoint(int id)
+{
+	ControlPort *port = m_bp_port.take(id);
+	m_callbacks.remove(id);
+	auto it = m_watches.find(port);
+	if (it == m_watches.end())
+		return;
+	std::erase_if(it->points, [id](const BreakSlot &s) { return s.id == id; });
+	if (it->points.empty())
+		drop_watch(port);
+}
+
+void DebugMonitor::set_breakpoint_enabled(int id, bool enabled)
+{
+	if (BreakSlot *s = find_slot(id))
+		s->enabled = enabled;
+}
+
+void DebugMonitor::set_breakpoint_sampling(int id, int every_nth)
+{
+	if (BreakSlot *s = find_slot(id)) {
+		s->every = static_cast<quint32>(qMax(1, every_nth));
+		s->countdown = s->every;
+	}
+}
+
+PortBreakpoint DebugMonitor::breakpoint(int id) const
+{
+	const BreakSlot *s = find_slot(id);
+	return s ? describe(m_bp_port.value(id), *s) : PortBreakpoint{};
+}
+
+QList<PortBreakpoint> DebugMonitor::breakpoints() const
+{
+	QList<PortBreakpoint> out;
+	for (auto it = m_watches.cbegin(); it != m_watches.cend(); ++it)
+		for (const BreakSlot &s : it->points)
+			out.append(describe(it.key(), s));
+	std::sort(out.begin(), out.end(),
+		[](const PortBreakpoint &a, const PortBreakpoint &b) { return a.id < b.id; });
+	return out;
+}
+
+void DebugMonitor::reset_hits()
+{
+	for (auto &w : m_watches)
+		for (BreakSlot &s : w.points)
+			s.hits = 0;
+}
+
+DebugMonitor::BreakSlot *DebugMonitor::find_slot(int id)
+{
+	return const_cast<BreakSlot *>(std::as_const(*this).find_slot(id));
+}
+
+const DebugMonitor::BreakSlot *DebugMonitor::find_slot(int id) const
+{
+	auto it = m_watches.constFind(m_bp_port.value(id));
+	if (it == m_watches.constEnd())
+		return nullptr;
+	for (const BreakSlot &s : it->points)
+		if (s.id == id)
+			return &s;
+	return nullptr;
+}
+
+PortBreakpoint DebugMonitor::describe(ControlPort *port, const BreakSlot &s) const
+{
+	PortBreakpoint bp;
+	bp.id = s.id;
+	bp.port_id = port ? port->id() : QString();
+	bp.condition = s.condition;
+	if (s.condition == BreakCondition::OnRange) {
+		bp.range_min = s.a;
+		bp.range_max = s.b;
+	} else {
+		bp.threshold = s.a;
+	}
+	bp.enabled = s.enabled;
+	bp.sample_every = static_cast<int>(s.every);
+	bp.hits = s.hits;
+	bp.callback = m_callbacks.value(s.id);
+	return bp;
+}
+
+void DebugMonitor::on_port_changed(ControlPort *port, double value)
+{
+	auto it = m_watches.find(port);
+	if (it == m_watches.end())
+		return;
+
+	// Callbacks may add or remove breakpoints, so fire them after the pass
+	QVarLengthArray<int, 8> fired;
+	for (BreakSlot &s : it->points) {
+		if (!s.enabled || --s.countdown > 0)
+			continue;
+		s.countdown = s.every;
+
+		bool hit = false;
+		switch (s.condition) {
+		case BreakCondition::OnChange:
+			hit = true;
+			break;
+		case BreakCondition::OnThreshold:
+			hit = value >= s.a;
+			break;
+		case BreakCondition::OnRange:
+			hit = value >= s.a && value <= s.b;
+			break;
+		case BreakCondition::OnCrossing: {
+			const bool above = value >= s.a;
+			hit = above != s.above;
+			s.above = above;
+			break;
+		}
+		}
+		if (hit) {
+			s.hits++;
+			fired.append(s.id);
+		}
+	}
+
+	for (int id : fired) {
+		if (!m_bp_port.contains(id))
+			continue;		// Removed by an earlier callback
+		if (auto cb = m_callbacks.constFind(id); cb != m_callbacks.constEnd() && *cb)
+			(*cb)(value);
+		emit breakpoint_hit(id, value);
+	}
+}
+
+void DebugMonitor::on_port_destroyed(QObject *obj)
+{
+	// The port is gone; only its address is used as the key
+	auto *port = static_cast<ControlPort *>(obj);
+	auto it = m_watches.constFind(port);
+	if (it == m_watches.constEnd())
+		return;
+	for (const BreakSlot &s : it->points) {
+		m_bp_port.remove(s.id);
+		m_callbacks.remove(s.id);
+	}
+	drop_watch(port);
+}
+
+void DebugMonitor::drop_watch(ControlPort *port)
+{
+	auto it = m_watches.find(port);
+	if (it == m_watches.end())
+		return;
+	disconnect(it->changed);
+	disconnect(it->destroyed);
+	m_watches.erase(it);
+}
+
+} // namespace super
@@ -4,20 +4,23 @@
 // Integrated Debugger — Signal Tracing & Breakpoints
 //
 // Provides:
-//   • SignalTrace: Records value changes on watched ports.
+//   • SignalTrace: Records value changes on watched ports (ring buffer
+//     with incremental min/max and a min/max pyramid for plotting).
 //   • PortBreakpoint: Pauses graph evaluation when a condition is met.
 //   • DebugMonitor: Singleton that manages traces and breakpoints.
 // ============================================================================
 
-#include "../core/control_port.hpp"
-#include "../core/control_registry.hpp"
+#include "../../core/control_port.hpp"
+#include "../../core/control_registry.hpp"
 
 #include <QObject>
 #include <QList>
 #include <QHash>
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QVector>
 #include <functional>
+#include <vector>
 
 namespace super {
 
@@ -32,52 +35,84 @@ struct TraceEntry {
 
 // ---------------------------------------------------------------------------
 // SignalTrace — Records value history for a single port.
+//
+// Samples live in a fixed-capacity ring, so recording never allocates or
+// shifts once the trace is full. The window's min/max are kept in two
+// monotonic deques (O(1) amortized per sample), and a min/max pyramid over
+// blocks of 8, 64, 512, ... samples answers range queries in a few dozen
+// steps, which lets a plot draw a million samples as a few hundred columns.
+//
+// Sample indexes are 0 = oldest retained, size()-1 = newest.
 // ---------------------------------------------------------------------------
 class SignalTrace : public QObject {
 	Q_OBJECT
 
 public:
+	struct Range {
+		double min;
+		double max;
+	};
+
 	explicit SignalTrace(ControlPort *port, int max_entries = 1000,
-						  QObject *parent = nullptr)
-		: QObject(parent), m_port(port), m_max(max_entries)
-	{
-		m_timer.start();
-		connect(port, &ControlPort::value_changed, this,
-			[this](const QVariant &val) {
-				TraceEntry e;
-				e.timestamp_ms = m_timer.elapsed();
-				e.value = val.toDouble();
-				m_entries.append(e);
-				if (m_entries.size() > m_max)
-					m_entries.removeFirst();
-				emit entry_added(e);
-			});
-	}
+						  QObject *parent = nullptr);
 
 	const QString &port_id() const { return m_port->id(); }
-	const QList<TraceEntry> &entries() const { return m_entries; }
-	void clear() { m_entries.clear(); m_timer.restart(); }
 
-	double min_value() const {
-		double v = 1e9;
-		for (const auto &e : m_entries) v = qMin(v, e.value);
-		return m_entries.isEmpty() ? 0.0 : v;
-	}
+	int size() const { return m_size; }
+	int capacity() const { return m_cap; }
+	const TraceEntry &at(int i) const { return m_ring[slot(m_first + i)]; }
+	// Copy of the retained samples, oldest first.
+	QList<TraceEntry> entries() const;
+	void clear();
 
-	double max_value() const {
-		double v = -1e9;
-		for (const auto &e : m_entries) v = qMax(v, e.value);
-		return m_entries.isEmpty() ? 0.0 : v;
-	}
+	// Over the whole window, O(1). 0 when empty.
+	double min_value() const;
+	double max_value() const;
+
+	// Min/max of samples [from, to) without visiting each one.
+	Range range(int from, int to) const;
+	// Samples [from, to) folded into `columns` min/max pairs for plotting.
+	QVector<Range> envelope(int columns, int from = 0, int to = -1) const;
 
 signals:
 	void entry_added(const TraceEntry &entry);
 
 private:
+	static constexpr int kFanout = 8;		// Pyramid block growth per level
+	static constexpr int kFanoutBits = 3;
+
+	// Index deque over a fixed ring; holds sequence numbers
+	struct MonoDeque {
+		std::vector<quint64> buf;
+		int head = 0;
+		int count = 0;
+		quint64 front() const { return buf[head]; }
+		quint64 back() const { return buf[(head + count - 1) % buf.size()]; }
+		void pop_front() { head = (head + 1) % buf.size(); count--; }
+		void pop_back() { count--; }
+		void push_back(quint64 v) { buf[(head + count++) % buf.size()] = v; }
+	};
+
+	struct Level {
+		int shift;				// Block size = 1 << shift samples
+		std::vector<quint64> tag;	// Block number held by each slot
+		std::vector<Range> blocks;
+	};
+
+	int slot(quint64 seq) const { return static_cast<int>(seq % m_cap); }
+	void record(double value);
+	void push_extreme(MonoDeque &dq, quint64 seq, bool keep_min);
+
 	ControlPort *m_port;
 	QElapsedTimer m_timer;
-	QList<TraceEntry> m_entries;
-	int m_max;
+	std::vector<TraceEntry> m_ring;
+	int m_cap;
+	int m_size = 0;
+	quint64 m_first = 0;		// Sequence number of the oldest sample
+	quint64 m_next = 0;			// Sequence number of the next sample
+	MonoDeque m_min_dq;
+	MonoDeque m_max_dq;
+	std::vector<Level> m_levels;
 };
 
 // ---------------------------------------------------------------------------
@@ -85,8 +120,9 @@ private:
 // ---------------------------------------------------------------------------
 enum class BreakCondition {
 	OnChange,		// Any value change
-	OnThreshold,	// Value crosses a threshold
-	OnRange			// Value enters/exits a range
+	OnThreshold,	// Value at or above a threshold
+	OnRange,		// Value inside [range_min, range_max]
+	OnCrossing		// Value crosses the threshold (either direction)
 };
 
 // ---------------------------------------------------------------------------
@@ -100,11 +136,17 @@ struct PortBreakpoint {
 	double range_min = 0.0;
 	double range_max = 1.0;
 	bool enabled = true;
+	int sample_every = 1;		// Evaluate only every Nth change
+	quint64 hits = 0;			// Read-only: times the condition fired
 	std::function<void(double)> callback;
 };
 
 // ---------------------------------------------------------------------------
 // DebugMonitor — Central debugging hub.
+//
+// Breakpoints are indexed by port: each watched port has one value_changed
+// subscription and a compact array of conditions evaluated in place, so a
+// change costs one pass over that port's breakpoints only.
 // ---------------------------------------------------------------------------
 class DebugMonitor : public QObject {
 	Q_OBJECT
@@ -137,42 +179,25 @@ public:
 	QStringList active_traces() const { return m_traces.keys(); }
 
 	// -- Breakpoints --
+	// Return the breakpoint id, or 0 if the port does not exist.
 	int add_breakpoint(const QString &port_id, BreakCondition cond,
 					   std::function<void(double)> callback = {}) {
 		PortBreakpoint bp;
-		bp.id = m_next_bp_id++;
 		bp.port_id = port_id;
 		bp.condition = cond;
 		bp.callback = std::move(callback);
-		m_breakpoints.append(bp);
-
-		// Connect to port
-		auto *port = ControlRegistry::instance().find(port_id);
-		if (port) {
-			connect(port, &ControlPort::value_changed, this,
-				[this, bpid = bp.id](const QVariant &val) {
-					check_breakpoint(bpid, val.toDouble());
-				});
-		}
-
-		return bp.id;
+		return add_breakpoint(bp);
 	}
+	int add_breakpoint(const PortBreakpoint &bp);
 
-	void remove_breakpoint(int id) {
-		m_breakpoints.erase(
-			std::remove_if(m_breakpoints.begin(), m_breakpoints.end(),
-				[id](const PortBreakpoint &bp) { return bp.id == id; }),
-			m_breakpoints.end());
-	}
+	void remove_breakpoint(int id);
+	void set_breakpoint_enabled(int id, bool enabled);
+	void set_breakpoint_sampling(int id, int every_nth);
 
-	void set_breakpoint_enabled(int id, bool enabled) {
-		for (auto &bp : m_breakpoints) {
-			if (bp.id == id) {
-				bp.enabled = enabled;
-				return;
-			}
-		}
-	}
+	// Current state of one breakpoint / all breakpoints (with hit counts).
+	PortBreakpoint breakpoint(int id) const;
+	QList<PortBreakpoint> breakpoints() const;
+	void reset_hits();
 
 signals:
 	void breakpoint_hit(int breakpoint_id, double value);
@@ -180,34 +205,35 @@ signals:
 private:
 	DebugMonitor() : QObject(nullptr) {}
 
-	void check_breakpoint(int id, double value) {
-		for (const auto &bp : m_breakpoints) {
-			if (bp.id != id || !bp.enabled)
-				continue;
-
-			bool hit = false;
-			switch (bp.condition) {
-			case BreakCondition::OnChange:
-				hit = true;
-				break;
-			case BreakCondition::OnThreshold:
-				hit = (value >= bp.threshold);
-				break;
-			case BreakCondition::OnRange:
-				hit = (value >= bp.range_min && value <= bp.range_max);
-				break;
-			}
-
-			if (hit) {
-				if (bp.callback)
-					bp.callback(value);
-				emit breakpoint_hit(bp.id, value);
-			}
-		}
-	}
+	// One breakpoint as evaluated on the hot path
+	struct BreakSlot {
+		int id;
+		BreakCondition condition;
+		bool enabled;
+		bool above;				// OnCrossing: side of the threshold last seen
+		double a;				// threshold or range_min
+		double b;				// range_max
+		quint32 every;
+		quint32 countdown;		// Changes left until the next evaluation
+		quint64 hits;
+	};
+	struct PortWatch {
+		QMetaObject::Connection changed;
+		QMetaObject::Connection destroyed;
+		std::vector<BreakSlot> points;
+	};
+
+	BreakSlot *find_slot(int id);
+	const BreakSlot *find_slot(int id) const;
+	PortBreakpoint describe(ControlPort *port, const BreakSlot &s) const;
+	void on_port_changed(ControlPort *port, double value);
+	void on_port_destroyed(QObject *port);
+	void drop_watch(ControlPort *port);
 
 	QHash<QString, SignalTrace *> m_traces;
-	QList<PortBreakpoint> m_breakpoints;
+	QHash<ControlPort *, PortWatch> m_watches;
+	QHash<int, ControlPort *> m_bp_port;		// Breakpoint id → port
+	QHash<int, std::function<void(double)>> m_callbacks;
 	int m_next_bp_id = 1;
 };
 
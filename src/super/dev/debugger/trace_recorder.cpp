@@ -0,0 +1,278 @@
+#include "trace_recorder.hpp"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QSaveFile>
+#include <QThread>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// Per-thread buffers
+//
+// The owning thread writes events[head] and then publishes head with a
+// release store. The flusher (under m_mutex) reads [consumed, head); only
+// the owner resets head, and only while holding m_mutex.
+// ---------------------------------------------------------------------------
+struct TraceRecorder::ThreadBuffer {
+	static constexpr int kSize = 256;
+	TraceEvent events[kSize];
+	std::atomic<int> head{0};
+	int consumed = 0;		// Guarded by m_mutex
+	quint32 tid = 0;
+};
+
+struct ThreadBufferHolder {
+	TraceRecorder::ThreadBuffer *buf = nullptr;
+	~ThreadBufferHolder()
+	{
+		if (buf)
+			TraceRecorder::instance().retire(buf);
+	}
+};
+
+static thread_local ThreadBufferHolder t_buffer;
+
+TraceRecorder &TraceRecorder::instance()
+{
+	static TraceRecorder recorder;
+	return recorder;
+}
+
+TraceRecorder::ThreadBuffer *TraceRecorder::attach()
+{
+	auto *b = new ThreadBuffer;
+	QByteArray name;
+	if (QThread *t = QThread::currentThread()) {
+		name = t->objectName().toUtf8();
+		if (name.isEmpty() && QCoreApplication::instance() &&
+			t == QCoreApplication::instance()->thread())
+			name = "Qt main";
+	}
+
+	std::lock_guard lock(m_mutex);
+	b->tid = m_next_tid++;
+	if (name.isEmpty())
+		name = "Thread " + QByteArray::number(b->tid);
+	b->consumed = b->head.load(std::memory_order_relaxed);
+	m_threads.push_back(b);
+	m_thread_names.emplace_back(b->tid, name);
+	return b;
+}
+
+void TraceRecorder::retire(ThreadBuffer *b)
+{
+	std::lock_guard lock(m_mutex);
+	if (recording())
+		append_locked(b->events + b->consumed, b->head.load(std::memory_order_acquire) - b->consumed);
+	std::erase(m_threads, b);
+	delete b;
+}
+
+void TraceRecorder::record(const TraceEvent &e)
+{
+	ThreadBuffer *b = t_buffer.buf;
+	if (!b)
+		b = t_buffer.buf = instance().attach();
+
+	const int i = b->head.load(std::memory_order_relaxed);
+	TraceEvent &slot = b->events[i];
+	slot = e;
+	slot.tid = b->tid;
+	b->head.store(i + 1, std::memory_order_release);
+	if (i + 1 == ThreadBuffer::kSize)
+		instance().flush(*b);
+}
+
+void TraceRecorder::flush(ThreadBuffer &b)
+{
+	std::lock_guard lock(m_mutex);
+	// Events recorded across a stop() are dropped, not carried into the next run
+	if (recording())
+		append_locked(b.events + b.consumed, b.head.load(std::memory_order_acquire) - b.consumed);
+	b.consumed = 0;
+	b.head.store(0, std::memory_order_release);
+}
+
+void TraceRecorder::collect_locked()
+{
+	for (ThreadBuffer *b : m_threads) {
+		const int n = b->head.load(std::memory_order_acquire);
+		append_locked(b->events + b->consumed, n - b->consumed);
+		b->consumed = n;
+	}
+}
+
+void TraceRecorder::append_locked(const TraceEvent *events, int n)
+{
+	const int cap = static_cast<int>(m_ring.size());
+	if (cap == 0 || n <= 0)
+		return;
+	for (int i = 0; i < n; i++) {
+		m_ring[m_head] = events[i];
+		m_head = (m_head + 1) % cap;
+	}
+	const int total = m_count + n;
+	if (total > cap)
+		m_dropped += total - cap;
+	m_count = qMin(total, cap);
+}
+
+// ---------------------------------------------------------------------------
+// Control
+// ---------------------------------------------------------------------------
+
+void TraceRecorder::start(int capacity)
+{
+	std::lock_guard lock(m_mutex);
+	m_ring.assign(static_cast<size_t>(qMax(1, capacity)), TraceEvent{});
+	m_head = 0;
+	m_count = 0;
+	m_dropped = 0;
+	for (ThreadBuffer *b : m_threads)
+		b->consumed = b->head.load(std::memory_order_acquire);
+	m_epoch_ns = now_ns();
+	s_recording.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::stop()
+{
+	if (!recording())
+		return;
+	std::lock_guard lock(m_mutex);
+	collect_locked();
+	s_recording.store(false, std::memory_order_relaxed);
+}
+
+int TraceRecorder::event_count()
+{
+	std::lock_guard lock(m_mutex);
+	if (recording())
+		collect_locked();
+	return m_count;
+}
+
+quint64 TraceRecorder::dropped()
+{
+	std::lock_guard lock(m_mutex);
+	return m_dropped;
+}
+
+const char *TraceRecorder::intern(const QString &label)
+{
+	static std::mutex mutex;
+	static QHash<QString, QByteArray> strings;
+	thread_local QHash<QString, const char *> cache;
+
+	if (const char *s = cache.value(label, nullptr))
+		return s;
+	std::lock_guard lock(mutex);
+	auto it = strings.find(label);
+	if (it == strings.end())
+		it = strings.insert(label, label.toUtf8());
+	// QByteArray data is shared, not moved, when the hash rehashes
+	const char *s = it->constData();
+	cache.insert(label, s);
+	return s;
+}
+
+// ---------------------------------------------------------------------------
+// Chrome Trace Event export
+// ---------------------------------------------------------------------------
+
+static void append_json_string(QByteArray &out, const char *s)
+{
+	out += '"';
+	for (; *s; s++) {
+		const unsigned char c = static_cast<unsigned char>(*s);
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += char(c);
+		} else if (c < 0x20) {
+			out += "\\u00";
+			out += "0123456789abcdef"[c >> 4];
+			out += "0123456789abcdef"[c & 0xF];
+		} else {
+			out += char(c);
+		}
+	}
+	out += '"';
+}
+
+// Microseconds with ns precision, as Chrome expects
+static QByteArray us(qint64 ns)
+{
+	return QByteArray::number(static_cast<double>(ns) / 1000.0, 'f', 3);
+}
+
+QByteArray TraceRecorder::chrome_json()
+{
+	std::lock_guard lock(m_mutex);
+	if (recording())
+		collect_locked();
+
+	QByteArray out;
+	out.reserve(64 + m_count * 112);
+	out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	bool first = true;
+	for (const auto &[tid, name] : m_thread_names) {
+		out += first ? "\n" : ",\n";
+		first = false;
+		out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+		out += QByteArray::number(tid);
+		out += ",\"args\":{\"name\":";
+		append_json_string(out, name.constData());
+		out += "}}";
+	}
+
+	const int cap = static_cast<int>(m_ring.size());
+	for (int k = 0; k < m_count; k++) {
+		const TraceEvent &e = m_ring[(m_head - m_count + k + cap) % cap];
+		out += first ? "\n" : ",\n";
+		first = false;
+		out += "{\"cat\":";
+		append_json_string(out, e.cat);
+		out += ",\"name\":";
+		append_json_string(out, e.name);
+		out += ",\"ph\":\"";
+		out += e.phase;
+		out += "\",\"ts\":";
+		out += us(qMax<qint64>(0, e.ts_ns - m_epoch_ns));
+		out += ",\"pid\":1,\"tid\":";
+		out += QByteArray::number(e.tid);
+		switch (e.phase) {
+		case 'X':
+			out += ",\"dur\":";
+			out += us(e.dur_ns);
+			if (e.detail) {
+				out += ",\"args\":{\"detail\":";
+				append_json_string(out, e.detail);
+				out += '}';
+			}
+			break;
+		case 'i':
+			out += ",\"s\":\"t\"";
+			break;
+		case 'C':
+			out += ",\"args\":{\"value\":";
+			out += QByteArray::number(e.value, 'g', 12);
+			out += '}';
+			break;
+		}
+		out += '}';
+	}
+	out += "\n]}\n";
+	return out;
+}
+
+bool TraceRecorder::write_chrome_json(const QString &path)
+{
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	file.write(chrome_json());
+	return file.commit();
+}
+
+} // namespace super
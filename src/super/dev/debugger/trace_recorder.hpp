@@ -0,0 +1,168 @@
+#pragma once
+
+// ============================================================================
+// Trace Recorder — Cross-subsystem timeline in Chrome Trace Event format.
+//
+// Trace points record into a small per-thread buffer; full buffers are
+// flushed under one mutex into a global ring that keeps the most recent
+// events. The result opens in chrome://tracing or ui.perfetto.dev.
+//
+// A thread's first event allocates its buffer and every 256th takes the
+// mutex (which chrome_json() holds while exporting), so trace points do
+// not belong on real-time threads such as OBS audio callbacks.
+//
+//   SUPER_TRACE_SCOPE("graph", "evaluate");            // duration event
+//   SUPER_TRACE_SCOPE_DETAIL("port", "commit", id);    // + interned label
+//   SUPER_TRACE_INSTANT("midi", "receive");
+//   SUPER_TRACE_COUNTER("tween", "active", n);
+//
+// Trace points compile to nothing unless built with ENABLE_TRACING
+// (SUPER_TRACING=1); when compiled in but not recording they cost one
+// relaxed atomic load. Category and name must be string literals.
+// ============================================================================
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// TraceEvent — One recorded event (trivially copyable).
+// ---------------------------------------------------------------------------
+struct TraceEvent {
+	const char *cat;
+	const char *name;
+	const char *detail;		// Interned label or null
+	qint64 ts_ns;			// steady_clock
+	qint64 dur_ns;			// Complete events only
+	double value;			// Counter events only
+	quint32 tid;
+	char phase;				// 'X' complete, 'i' instant, 'C' counter
+};
+
+// ---------------------------------------------------------------------------
+// TraceRecorder
+// ---------------------------------------------------------------------------
+class TraceRecorder {
+public:
+	static TraceRecorder &instance();
+
+	static bool recording() { return s_recording.load(std::memory_order_relaxed); }
+	static qint64 now_ns()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Clears previous events and starts recording. `capacity` bounds the
+	// global ring; the oldest events are dropped past it.
+	void start(int capacity = 1 << 20);
+	void stop();
+
+	// Events recorded so far, including those still in thread buffers.
+	int event_count();
+	// Events lost to ring overflow since start().
+	quint64 dropped();
+
+	// Chrome Trace Event JSON ({"traceEvents": [...]}).
+	QByteArray chrome_json();
+	bool write_chrome_json(const QString &path);
+
+	// Stable C string for a runtime label (port ids etc.). Cached per thread.
+	static const char *intern(const QString &label);
+
+	static void record(const TraceEvent &e);
+
+	struct ThreadBuffer;
+
+private:
+	TraceRecorder() = default;
+
+	ThreadBuffer *attach();
+	void retire(ThreadBuffer *b);
+	void flush(ThreadBuffer &b);
+	void collect_locked();
+	void append_locked(const TraceEvent *events, int n);
+
+	static inline std::atomic<bool> s_recording{false};
+
+	std::mutex m_mutex;
+	std::vector<ThreadBuffer *> m_threads;
+	std::vector<std::pair<quint32, QByteArray>> m_thread_names;
+	quint32 m_next_tid = 1;
+	std::vector<TraceEvent> m_ring;
+	int m_head = 0;			// Next write
+	int m_count = 0;
+	quint64 m_dropped = 0;
+	qint64 m_epoch_ns = 0;
+
+	friend struct ThreadBufferHolder;
+};
+
+// ---------------------------------------------------------------------------
+// TraceScope — RAII duration event.
+// ---------------------------------------------------------------------------
+class TraceScope {
+public:
+	TraceScope(const char *cat, const char *name, const char *detail = nullptr)
+		: m_cat(cat), m_name(name), m_detail(detail),
+		  m_start(TraceRecorder::recording() ? TraceRecorder::now_ns() : 0)
+	{
+	}
+	~TraceScope()
+	{
+		if (m_start)
+			TraceRecorder::record({m_cat, m_name, m_detail, m_start,
+								   TraceRecorder::now_ns() - m_start, 0.0, 0, 'X'});
+	}
+	TraceScope(const TraceScope &) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+	const char *m_cat;
+	const char *m_name;
+	const char *m_detail;
+	qint64 m_start;
+};
+
+} // namespace super
+
+// ---------------------------------------------------------------------------
+// Trace point macros
+// ---------------------------------------------------------------------------
+#if SUPER_TRACING
+#define SUPER_TRACE_CONCAT2(a, b) a##b
+#define SUPER_TRACE_CONCAT(a, b) SUPER_TRACE_CONCAT2(a, b)
+
+#define SUPER_TRACE_SCOPE(cat, name) \
+	::super::TraceScope SUPER_TRACE_CONCAT(super_trace_, __LINE__)(cat, name)
+
+#define SUPER_TRACE_SCOPE_DETAIL(cat, name, label)                              \
+	::super::TraceScope SUPER_TRACE_CONCAT(super_trace_, __LINE__)(            \
+		cat, name, ::super::TraceRecorder::recording()                        \
+			? ::super::TraceRecorder::intern(label) : nullptr)
+
+#define SUPER_TRACE_INSTANT(cat, name)                                          \
+	do {                                                                        \
+		if (::super::TraceRecorder::recording())                               \
+			::super::TraceRecorder::record({cat, name, nullptr,                \
+				::super::TraceRecorder::now_ns(), 0, 0.0, 0, 'i'});            \
+	} while (0)
+
+#define SUPER_TRACE_COUNTER(cat, name, value)                                   \
+	do {                                                                        \
+		if (::super::TraceRecorder::recording())                               \
+			::super::TraceRecorder::record({cat, name, nullptr,                \
+				::super::TraceRecorder::now_ns(), 0, double(value), 0, 'C');   \
+	} while (0)
+#else
+#define SUPER_TRACE_SCOPE(cat, name) ((void)0)
+#define SUPER_TRACE_SCOPE_DETAIL(cat, name, label) ((void)0)
+#define SUPER_TRACE_INSTANT(cat, name) ((void)0)
+#define SUPER_TRACE_COUNTER(cat, name, value) ((void)0)
+#endif
@@ -0,0 +1,209 @@
+#include "metrics.hpp"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// Histogram
+// ---------------------------------------------------------------------------
+
+int Histogram::bucket_of(quint64 v)
+{
+	if (v < kSub)
+		return static_cast<int>(v);
+	const int shift = std::bit_width(v) - 1 - kSubBits;
+	return (shift + 1) * kSub + static_cast<int>((v >> shift) - kSub);
+}
+
+quint64 Histogram::bucket_low(int i)
+{
+	if (i < kSub)
+		return static_cast<quint64>(i);
+	const int shift = i / kSub - 1;
+	return static_cast<quint64>(kSub + i % kSub) << shift;
+}
+
+quint64 Histogram::bucket_mid(int i)
+{
+	if (i < kSub)
+		return static_cast<quint64>(i);
+	const int shift = i / kSub - 1;
+	return bucket_low(i) + ((quint64(1) << shift) >> 1);
+}
+
+void Histogram::record(quint64 v)
+{
+	m_buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(v, std::memory_order_relaxed);
+	quint64 prev = m_max.load(std::memory_order_relaxed);
+	while (v > prev && !m_max.compare_exchange_weak(prev, v, std::memory_order_relaxed)) {
+	}
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+	Snapshot s;
+	s.buckets.resize(kBuckets);
+	for (int i = 0; i < kBuckets; i++)
+		s.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+	s.count = m_count.load(std::memory_order_relaxed);
+	s.sum = m_sum.load(std::memory_order_relaxed);
+	s.max = m_max.load(std::memory_order_relaxed);
+	return s;
+}
+
+Histogram::Snapshot Histogram::Snapshot::since(const Snapshot &earlier) const
+{
+	if (earlier.buckets.size() != buckets.size())
+		return *this;
+
+	Snapshot d;
+	d.buckets.resize(buckets.size());
+	int top = -1;
+	for (size_t i = 0; i < buckets.size(); i++) {
+		d.buckets[i] = buckets[i] - earlier.buckets[i];
+		if (d.buckets[i])
+			top = static_cast<int>(i);
+	}
+	d.count = count - earlier.count;
+	d.sum = sum - earlier.sum;
+	// The all-time max may predate the interval; bound it by the top bucket
+	if (top >= 0)
+		d.max = qMin(max, bucket_low(top + 1) - 1);
+	return d;
+}
+
+quint64 Histogram::Snapshot::percentile(double q) const
+{
+	if (!count)
+		return 0;
+	const quint64 rank = qMax<quint64>(1, static_cast<quint64>(std::ceil(qBound(0.0, q, 1.0) * count)));
+	quint64 seen = 0;
+	for (size_t i = 0; i < buckets.size(); i++) {
+		seen += buckets[i];
+		if (seen >= rank)
+			return max ? qMin(bucket_mid(static_cast<int>(i)), max) : bucket_mid(static_cast<int>(i));
+	}
+	return max;
+}
+
+// ---------------------------------------------------------------------------
+// MetricsRegistry
+// ---------------------------------------------------------------------------
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+	static MetricsRegistry registry;
+	return registry;
+}
+
+template <typename T>
+static T &find_or_create(QHash<QString, std::shared_ptr<T>> &map, const QString &name)
+{
+	auto &slot = map[name];
+	if (!slot)
+		slot = std::make_shared<T>();
+	return *slot;
+}
+
+Counter &MetricsRegistry::counter(const QString &name)
+{
+	std::lock_guard lock(m_mutex);
+	return find_or_create(m_counters, name);
+}
+
+Gauge &MetricsRegistry::gauge(const QString &name)
+{
+	std::lock_guard lock(m_mutex);
+	return find_or_create(m_gauges, name);
+}
+
+Histogram &MetricsRegistry::histogram(const QString &name)
+{
+	std::lock_guard lock(m_mutex);
+	return find_or_create(m_histograms, name);
+}
+
+template <typename T>
+static QStringList sorted_keys(const QHash<QString, std::shared_ptr<T>> &map)
+{
+	QStringList keys = map.keys();
+	keys.sort();
+	return keys;
+}
+
+QStringList MetricsRegistry::counter_names() const
+{
+	std::lock_guard lock(m_mutex);
+	return sorted_keys(m_counters);
+}
+
+QStringList MetricsRegistry::gauge_names() const
+{
+	std::lock_guard lock(m_mutex);
+	return sorted_keys(m_gauges);
+}
+
+QStringList MetricsRegistry::histogram_names() const
+{
+	std::lock_guard lock(m_mutex);
+	return sorted_keys(m_histograms);
+}
+
+const Counter *MetricsRegistry::find_counter(const QString &name) const
+{
+	std::lock_guard lock(m_mutex);
+	return m_counters.value(name).get();
+}
+
+const Gauge *MetricsRegistry::find_gauge(const QString &name) const
+{
+	std::lock_guard lock(m_mutex);
+	return m_gauges.value(name).get();
+}
+
+const Histogram *MetricsRegistry::find_histogram(const QString &name) const
+{
+	std::lock_guard lock(m_mutex);
+	return m_histograms.value(name).get();
+}
+
+QByteArray MetricsRegistry::to_json() const
+{
+	std::lock_guard lock(m_mutex);
+
+	QJsonObject counters;
+	for (auto it = m_counters.cbegin(); it != m_counters.cend(); ++it)
+		counters[it.key()] = static_cast<qint64>(it.value()->value());
+
+	QJsonObject gauges;
+	for (auto it = m_gauges.cbegin(); it != m_gauges.cend(); ++it)
+		gauges[it.key()] = it.value()->value();
+
+	QJsonObject histograms;
+	for (auto it = m_histograms.cbegin(); it != m_histograms.cend(); ++it) {
+		const Histogram::Snapshot s = it.value()->snapshot();
+		QJsonObject h;
+		h["count"] = static_cast<qint64>(s.count);
+		h["mean_ns"] = s.mean();
+		h["p50_ns"] = static_cast<qint64>(s.percentile(0.50));
+		h["p90_ns"] = static_cast<qint64>(s.percentile(0.90));
+		h["p99_ns"] = static_cast<qint64>(s.percentile(0.99));
+		h["max_ns"] = static_cast<qint64>(s.max);
+		histograms[it.key()] = h;
+	}
+
+	QJsonObject root;
+	root["counters"] = counters;
+	root["gauges"] = gauges;
+	root["histograms"] = histograms;
+	return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+} // namespace super
@@ -0,0 +1,172 @@
+#pragma once
+
+// ============================================================================
+// Metrics — Runtime cost counters for the plugin itself.
+//
+// Provides:
+//   • Counter: monotonically increasing event count.
+//   • Gauge: last-written value.
+//   • Histogram: log-linear buckets (HDR-style, ~3% relative error) for
+//     durations in nanoseconds.
+//   • MetricsRegistry: name → metric, registered once from any thread.
+//
+// Updates are relaxed atomics and never lock; only the first lookup of a
+// name takes the registry mutex. Metrics live until unload, so references
+// can be cached in function-local statics (the SUPER_METRIC_* macros do).
+//
+//   SUPER_METRIC_TIME("graph.evaluate");      // times the enclosing scope
+//   SUPER_METRIC_COUNT("midi.messages");
+//   SUPER_METRIC_GAUGE("tween.active", n);
+// ============================================================================
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// Counter
+// ---------------------------------------------------------------------------
+class Counter {
+public:
+	void add(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+	quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<quint64> m_value{0};
+};
+
+// ---------------------------------------------------------------------------
+// Gauge
+// ---------------------------------------------------------------------------
+class Gauge {
+public:
+	void set(double v) { m_value.store(v, std::memory_order_relaxed); }
+	double value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<double> m_value{0.0};
+};
+
+// ---------------------------------------------------------------------------
+// Histogram — Log-linear buckets over quint64 (values below 2^kSubBits are
+// exact; above, each power of two is split into 2^kSubBits buckets).
+// ---------------------------------------------------------------------------
+class Histogram {
+public:
+	static constexpr int kSubBits = 5;
+	static constexpr int kSub = 1 << kSubBits;
+	static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+	// Point-in-time copy; subtract two to get an interval.
+	struct Snapshot {
+		std::vector<quint64> buckets;
+		quint64 count = 0;
+		quint64 sum = 0;
+		quint64 max = 0;
+
+		Snapshot since(const Snapshot &earlier) const;
+		double mean() const { return count ? double(sum) / double(count) : 0.0; }
+		// Representative value at quantile q in [0, 1].
+		quint64 percentile(double q) const;
+	};
+
+	void record(quint64 v);
+	Snapshot snapshot() const;
+
+	static int bucket_of(quint64 v);
+	static quint64 bucket_low(int i);
+	static quint64 bucket_mid(int i);
+
+private:
+	std::array<std::atomic<quint64>, kBuckets> m_buckets{};
+	std::atomic<quint64> m_count{0};
+	std::atomic<quint64> m_sum{0};
+	std::atomic<quint64> m_max{0};
+};
+
+// ---------------------------------------------------------------------------
+// MetricTimer — Records the lifetime of a scope into a histogram (ns).
+// ---------------------------------------------------------------------------
+class MetricTimer {
+public:
+	explicit MetricTimer(Histogram &h) : m_hist(h), m_start(std::chrono::steady_clock::now()) {}
+	~MetricTimer()
+	{
+		m_hist.record(static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - m_start).count()));
+	}
+	MetricTimer(const MetricTimer &) = delete;
+	MetricTimer &operator=(const MetricTimer &) = delete;
+
+private:
+	Histogram &m_hist;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// ---------------------------------------------------------------------------
+// MetricsRegistry
+// ---------------------------------------------------------------------------
+class MetricsRegistry {
+public:
+	static MetricsRegistry &instance();
+
+	// Find or create. The returned reference stays valid until unload.
+	Counter &counter(const QString &name);
+	Gauge &gauge(const QString &name);
+	Histogram &histogram(const QString &name);
+
+	QStringList counter_names() const;
+	QStringList gauge_names() const;
+	QStringList histogram_names() const;
+	// Null if not registered.
+	const Counter *find_counter(const QString &name) const;
+	const Gauge *find_gauge(const QString &name) const;
+	const Histogram *find_histogram(const QString &name) const;
+
+	// All metrics; histograms as count/mean/p50/p90/p99/max in ns.
+	QByteArray to_json() const;
+
+private:
+	MetricsRegistry() = default;
+
+	mutable std::mutex m_mutex;
+	QHash<QString, std::shared_ptr<Counter>> m_counters;
+	QHash<QString, std::shared_ptr<Gauge>> m_gauges;
+	QHash<QString, std::shared_ptr<Histogram>> m_histograms;
+};
+
+} // namespace super
+
+// ---------------------------------------------------------------------------
+// Instrumentation macros (name must be a constant)
+// ---------------------------------------------------------------------------
+#define SUPER_METRIC_CONCAT2(a, b) a##b
+#define SUPER_METRIC_CONCAT(a, b) SUPER_METRIC_CONCAT2(a, b)
+
+#define SUPER_METRIC_TIME(name)                                                          \
+	static ::super::Histogram &SUPER_METRIC_CONCAT(super_metric_h_, __LINE__) =         \
+		::super::MetricsRegistry::instance().histogram(QStringLiteral(name));           \
+	::super::MetricTimer SUPER_METRIC_CONCAT(super_metric_t_, __LINE__)(                 \
+		SUPER_METRIC_CONCAT(super_metric_h_, __LINE__))
+
+#define SUPER_METRIC_COUNT(name)                                                         \
+	do {                                                                                 \
+		static ::super::Counter &c_ = ::super::MetricsRegistry::instance().counter(     \
+			QStringLiteral(name));                                                       \
+		c_.add();                                                                        \
+	} while (0)
+
+#define SUPER_METRIC_GAUGE(name, value)                                                  \
+	do {                                                                                 \
+		static ::super::Gauge &g_ = ::super::MetricsRegistry::instance().gauge(         \
+			QStringLiteral(name));                                                       \
+		g_.set(double(value));                                                           \
+	} while (0)
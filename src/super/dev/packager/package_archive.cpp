@@ -0,0 +1,213 @@
+#include "package_archive.hpp"
+
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+static void set_error(QString *error, const QString &msg)
+{
+	if (error)
+		*error = msg;
+}
+
+std::unique_ptr<PackageArchive> PackageArchive::open(const QString &path, QString *error)
+{
+	std::unique_ptr<PackageArchive> a(new PackageArchive);
+	a->m_path = path;
+	a->m_file.setFileName(path);
+	if (!a->m_file.open(QIODevice::ReadOnly)) {
+		set_error(error, QString("Cannot open %1").arg(path));
+		return nullptr;
+	}
+	a->m_map_size = static_cast<quint64>(a->m_file.size());
+	if (a->m_map_size < kHeaderSize) {
+		set_error(error, QString("%1: truncated header").arg(path));
+		return nullptr;
+	}
+	a->m_map = a->m_file.map(0, a->m_file.size());
+	if (!a->m_map) {
+		set_error(error, QString("%1: mmap failed").arg(path));
+		return nullptr;
+	}
+
+	const uchar *h = a->m_map;
+	if (std::memcmp(h, kMagic, 4) != 0) {
+		set_error(error, QString("%1: not a package archive").arg(path));
+		return nullptr;
+	}
+	const quint16 version = qFromLittleEndian<quint16>(h + 4);
+	if (version > kVersion) {
+		set_error(error, QString("%1: unsupported version %2").arg(path).arg(version));
+		return nullptr;
+	}
+	const quint32 count = qFromLittleEndian<quint32>(h + 8);
+	const quint64 toc_offset = qFromLittleEndian<quint64>(h + 12);
+	const quint32 toc_size = qFromLittleEndian<quint32>(h + 20);
+	if (toc_offset < kHeaderSize || toc_offset > a->m_map_size || toc_size > a->m_map_size - toc_offset) {
+		set_error(error, QString("%1: TOC out of bounds").arg(path));
+		return nullptr;
+	}
+
+	const QByteArray toc = QByteArray::fromRawData(reinterpret_cast<const char *>(h + toc_offset),
+												   static_cast<qsizetype>(toc_size));
+	QDataStream in(toc);
+	in.setByteOrder(QDataStream::LittleEndian);
+	a->m_order.reserve(static_cast<qsizetype>(count));
+	for (quint32 i = 0; i < count; i++) {
+		quint16 len;
+		in >> len;
+		QByteArray name(len, Qt::Uninitialized);
+		if (in.readRawData(name.data(), len) != len)
+			break;
+		quint8 codec;
+		Entry e;
+		in >> codec >> e.offset >> e.stored_size >> e.size;
+		if (in.status() != QDataStream::Ok)
+			break;
+		if (e.offset > toc_offset || e.stored_size > toc_offset - e.offset) {
+			set_error(error, QString("%1: entry %2 out of bounds").arg(path, QString::fromUtf8(name)));
+			return nullptr;
+		}
+		e.path = QString::fromUtf8(name);
+		e.codec = static_cast<Codec>(codec);
+		a->m_order.append(e.path);
+		a->m_index.insert(e.path, e);
+	}
+	if (a->m_order.size() != static_cast<qsizetype>(count)) {
+		set_error(error, QString("%1: truncated TOC").arg(path));
+		return nullptr;
+	}
+	return a;
+}
+
+PackageArchive::~PackageArchive()
+{
+	if (m_map)
+		m_file.unmap(const_cast<uchar *>(m_map));
+}
+
+const PackageArchive::Entry *PackageArchive::entry_info(const QString &path) const
+{
+	auto it = m_index.constFind(path);
+	return it != m_index.constEnd() ? &*it : nullptr;
+}
+
+QByteArray PackageArchive::read(const QString &path)
+{
+	auto it = m_index.constFind(path);
+	if (it == m_index.constEnd())
+		return {};
+	const Entry &e = *it;
+	const auto *data = reinterpret_cast<const char *>(m_map + e.offset);
+
+	switch (e.codec) {
+	case Codec::Stored:
+		// Zero-copy view into the mapping
+		return QByteArray::fromRawData(data, static_cast<qsizetype>(e.stored_size));
+	case Codec::Zlib: {
+		auto cached = m_inflated.constFind(path);
+		if (cached != m_inflated.constEnd())
+			return *cached;
+		QByteArray out = qUncompress(reinterpret_cast<const uchar *>(data),
+									 static_cast<qsizetype>(e.stored_size));
+		if (static_cast<quint64>(out.size()) != e.size)
+			return {};
+		m_inflated.insert(path, out);
+		return out;
+	}
+	}
+	return {};
+}
+
+// ---------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------
+
+bool PackageArchive::write(const QString &source_dir, const QString &out_path, bool compress,
+						   QString *error)
+{
+	QDir root(source_dir);
+	if (!root.exists()) {
+		set_error(error, QString("No such directory: %1").arg(source_dir));
+		return false;
+	}
+
+	QStringList files;
+	QDirIterator it(source_dir, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext())
+		files.append(root.relativeFilePath(it.next()));
+	files.sort();	// Deterministic output
+
+	QSaveFile out(out_path);
+	if (!out.open(QIODevice::WriteOnly)) {
+		set_error(error, QString("Cannot write %1").arg(out_path));
+		return false;
+	}
+	out.write(QByteArray(kHeaderSize, '\0'));	// Patched below
+
+	QList<Entry> toc;
+	quint64 offset = kHeaderSize;
+	for (const QString &rel : std::as_const(files)) {
+		QFile f(root.filePath(rel));
+		if (!f.open(QIODevice::ReadOnly)) {
+			set_error(error, QString("Cannot read %1").arg(f.fileName()));
+			return false;
+		}
+		const QByteArray raw = f.readAll();
+		Entry e;
+		e.path = QDir::fromNativeSeparators(rel);
+		e.offset = offset;
+		e.size = static_cast<quint64>(raw.size());
+
+		QByteArray payload = raw;
+		if (compress && raw.size() > 64) {
+			QByteArray packed = qCompress(raw, 9);
+			if (packed.size() < raw.size()) {
+				payload = std::move(packed);
+				e.codec = Codec::Zlib;
+			}
+		}
+		e.stored_size = static_cast<quint64>(payload.size());
+		out.write(payload);
+		offset += e.stored_size;
+		toc.append(e);
+	}
+
+	QByteArray toc_bytes;
+	{
+		QDataStream s(&toc_bytes, QIODevice::WriteOnly);
+		s.setByteOrder(QDataStream::LittleEndian);
+		for (const Entry &e : std::as_const(toc)) {
+			const QByteArray name = e.path.toUtf8();
+			s << static_cast<quint16>(name.size());
+			s.writeRawData(name.constData(), static_cast<int>(name.size()));
+			s << static_cast<quint8>(e.codec) << e.offset << e.stored_size << e.size;
+		}
+	}
+	out.write(toc_bytes);
+
+	uchar header[kHeaderSize] = {};
+	std::memcpy(header, kMagic, 4);
+	qToLittleEndian<quint16>(kVersion, header + 4);
+	qToLittleEndian<quint16>(0, header + 6);
+	qToLittleEndian<quint32>(static_cast<quint32>(toc.size()), header + 8);
+	qToLittleEndian<quint64>(offset, header + 12);
+	qToLittleEndian<quint32>(static_cast<quint32>(toc_bytes.size()), header + 20);
+	if (!out.seek(0) || out.write(reinterpret_cast<const char *>(header), kHeaderSize) != kHeaderSize ||
+		!out.commit()) {
+		set_error(error, QString("Cannot write %1").arg(out_path));
+		return false;
+	}
+	return true;
+}
+
+} // namespace super
@@ -0,0 +1,81 @@
+#pragma once
+
+// ============================================================================
+// Package Archive — Single-file .obs-pack container.
+//
+// Layout (little-endian):
+//
+//   Header   "SPAK" | u16 version | u16 flags | u32 entry count
+//            | u64 TOC offset | u32 TOC size                      (24 bytes)
+//   Data     entry payloads, back to back
+//   TOC      per entry: u16 path length | path (UTF-8) | u8 codec
+//            | u64 offset | u64 stored size | u64 original size
+//
+// The file is memory-mapped; opening reads only the header and TOC.
+// Stored entries are returned without copying, compressed ones are inflated
+// on first access and kept. The manifest is the "manifest.json" entry.
+// ============================================================================
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+namespace super {
+
+class PackageArchive {
+public:
+	static constexpr char kMagic[4] = {'S', 'P', 'A', 'K'};
+	static constexpr quint16 kVersion = 1;
+	static constexpr int kHeaderSize = 24;
+
+	enum class Codec : quint8 {
+		Stored = 0,
+		Zlib = 1,		// qCompress framing
+	};
+
+	struct Entry {
+		QString path;
+		Codec codec = Codec::Stored;
+		quint64 offset = 0;
+		quint64 stored_size = 0;
+		quint64 size = 0;
+	};
+
+	// Maps `path` and reads its TOC. Null (with `error` set) on failure.
+	static std::unique_ptr<PackageArchive> open(const QString &path, QString *error = nullptr);
+
+	// Packs every file under `source_dir` into `out_path`. Entries that
+	// shrink are compressed when `compress` is set.
+	static bool write(const QString &source_dir, const QString &out_path, bool compress = true,
+					  QString *error = nullptr);
+
+	~PackageArchive();
+	PackageArchive(const PackageArchive &) = delete;
+	PackageArchive &operator=(const PackageArchive &) = delete;
+
+	const QString &file_path() const { return m_path; }
+	QStringList entries() const { return m_order; }
+	bool contains(const QString &path) const { return m_index.contains(path); }
+	const Entry *entry_info(const QString &path) const;
+
+	// Entry contents; empty if missing or corrupt. The data stays valid
+	// while the archive is open.
+	QByteArray read(const QString &path);
+
+private:
+	PackageArchive() = default;
+
+	QString m_path;
+	QFile m_file;
+	const uchar *m_map = nullptr;
+	quint64 m_map_size = 0;
+
+	QStringList m_order;
+	QHash<QString, Entry> m_index;
+	QHash<QString, QByteArray> m_inflated;	// Lazily decompressed entries
+};
+
+} // namespace super
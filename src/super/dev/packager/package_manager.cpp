@@ -0,0 +1,145 @@
+#include "package_manager.hpp"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// Scan cache — <packages_dir>/.scan_cache.json
+// ---------------------------------------------------------------------------
+
+void PackageManager::load_scan_cache() const
+{
+	m_cache_loaded = true;
+	m_scan_cache.clear();
+
+	QFile f(QDir(m_packages_dir).filePath(kScanCacheFile));
+	if (!f.open(QIODevice::ReadOnly))
+		return;
+	const QJsonObject root = QJsonDocument::fromJson(f.readAll()).object();
+	if (root["version"].toInt() != 1)
+		return;
+
+	const QJsonObject entries = root["entries"].toObject();
+	for (auto it = entries.begin(); it != entries.end(); ++it) {
+		const QJsonObject e = it.value().toObject();
+		ScanCacheEntry c;
+		c.size = e["size"].toInteger();
+		c.mtime_ms = e["mtime"].toInteger();
+		c.manifest = e["manifest"].toObject();
+		m_scan_cache.insert(it.key(), c);
+	}
+}
+
+void PackageManager::save_scan_cache() const
+{
+	QJsonObject entries;
+	for (auto it = m_scan_cache.cbegin(); it != m_scan_cache.cend(); ++it) {
+		QJsonObject e;
+		e["size"] = it->size;
+		e["mtime"] = it->mtime_ms;
+		e["manifest"] = it->manifest;
+		entries[it.key()] = e;
+	}
+	QJsonObject root;
+	root["version"] = 1;
+	root["entries"] = entries;
+
+	QSaveFile f(QDir(m_packages_dir).filePath(kScanCacheFile));
+	if (f.open(QIODevice::WriteOnly)) {
+		f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+		f.commit();
+	}
+}
+
+PackageManifest PackageManager::cached_manifest(const QString &file, bool is_archive, bool &dirty) const
+{
+	const QFileInfo info(file);
+	const qint64 size = info.size();
+	const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+	auto it = m_scan_cache.constFind(file);
+	if (it != m_scan_cache.constEnd() && it->size == size && it->mtime_ms == mtime)
+		return PackageManifest::from_json(it->manifest);
+
+	PackageManifest m;
+	if (is_archive) {
+		m_archives.remove(file);	// Changed on disk: drop the old mapping
+		if (auto a = archive(file))
+			m = PackageManifest::load(*a);
+	} else {
+		m = PackageManifest::load(file);
+	}
+	m_scan_cache.insert(file, {size, mtime, m.to_json()});
+	dirty = true;
+	return m;
+}
+
+// ---------------------------------------------------------------------------
+// Discovery
+// ---------------------------------------------------------------------------
+
+QList<PackageManifest> PackageManager::scan() const
+{
+	QList<PackageManifest> result;
+	QDir dir(m_packages_dir);
+	if (!dir.exists())
+		return result;
+
+	if (!m_cache_loaded)
+		load_scan_cache();
+	bool dirty = false;
+	QSet<QString> seen;
+
+	// Single-file archives
+	const QStringList archives =
+		dir.entryList({QString("*.") + kArchiveSuffix}, QDir::Files, QDir::Name);
+	for (const auto &entry : archives) {
+		const QString path = dir.filePath(entry);
+		seen.insert(path);
+		PackageManifest m = cached_manifest(path, true, dirty);
+		m.path = path;
+		result.append(m);
+	}
+
+	// Unpacked package directories
+	for (const auto &entry : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+		const QString manifest_path = dir.filePath(entry + "/manifest.json");
+		if (!QFile::exists(manifest_path))
+			continue;
+		seen.insert(manifest_path);
+		PackageManifest m = cached_manifest(manifest_path, false, dirty);
+		m.path = dir.filePath(entry);
+		result.append(m);
+	}
+
+	// Forget packages that were removed
+	for (auto it = m_scan_cache.begin(); it != m_scan_cache.end();) {
+		if (!seen.contains(it.key())) {
+			it = m_scan_cache.erase(it);
+			dirty = true;
+		} else {
+			++it;
+		}
+	}
+
+	if (dirty)
+		save_scan_cache();
+	return result;
+}
+
+std::shared_ptr<PackageArchive> PackageManager::archive(const QString &path) const
+{
+	auto it = m_archives.constFind(path);
+	if (it != m_archives.constEnd())
+		return *it;
+
+	std::shared_ptr<PackageArchive> a = PackageArchive::open(path);
+	if (a)
+		m_archives.insert(path, a);
+	return a;
+}
+
+} // namespace super
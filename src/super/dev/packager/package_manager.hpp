@@ -10,7 +10,8 @@
 //   • Lua Scripts
 //   • Presets (Snapshots)
 //
-// Format: ZIP archive with manifest.json at root.
+// Format: single-file archive with manifest.json as an entry (see
+// package_archive.hpp), or an unpacked directory with manifest.json.
 // ============================================================================
 
 #include <QObject>
@@ -22,6 +23,10 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QHash>
+#include <memory>
+
+#include "package_archive.hpp"
 
 namespace super {
 
@@ -41,6 +46,8 @@ struct PackageManifest {
 	QStringList lua_scripts;		// "scripts/*.lua"
 	QStringList presets;			// "presets/*.json"
 
+	QString path;					// Archive file or package directory (not serialized)
+
 	QJsonObject to_json() const {
 		QJsonObject obj;
 		obj["name"] = name;
@@ -95,6 +102,10 @@ struct PackageManifest {
 		return from_json(QJsonDocument::fromJson(f.readAll()).object());
 	}
 
+	static PackageManifest load(PackageArchive &archive) {
+		return from_json(QJsonDocument::fromJson(archive.read("manifest.json")).object());
+	}
+
 	bool save(const QString &path) const {
 		QFile f(path);
 		if (!f.open(QIODevice::WriteOnly))
@@ -119,22 +130,22 @@ public:
 	// Set the root directory where packages are stored.
 	void set_packages_dir(const QString &dir) {
 		m_packages_dir = dir;
+		m_cache_loaded = false;
+		m_scan_cache.clear();
 	}
 
-	// Scan for installed packages (directories with manifest.json).
-	QList<PackageManifest> scan() const {
-		QList<PackageManifest> result;
-		QDir dir(m_packages_dir);
-		if (!dir.exists())
-			return result;
-
-		for (const auto &entry : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-			QString manifest_path = dir.filePath(entry + "/manifest.json");
-			if (QFile::exists(manifest_path))
-				result.append(PackageManifest::load(manifest_path));
-		}
-		return result;
-	}
+	static constexpr const char *kArchiveSuffix = "obs-pack";
+	static constexpr const char *kScanCacheFile = ".scan_cache.json";
+
+	// Scan for installed packages: *.obs-pack archives and directories with
+	// manifest.json. Manifests of packages whose file size and mtime are
+	// unchanged since the last scan come from the scan cache.
+	QList<PackageManifest> scan() const;
+
+	// Open (or reuse) the archive at `path`. Entries decompressed through
+	// it stay cached until release_archives().
+	std::shared_ptr<PackageArchive> archive(const QString &path) const;
+	void release_archives() { m_archives.clear(); }
 
 	// Get the packages directory.
 	QString packages_dir() const { return m_packages_dir; }
@@ -145,7 +156,22 @@ signals:
 
 private:
 	PackageManager() : QObject(nullptr) {}
+
+	struct ScanCacheEntry {
+		qint64 size = 0;
+		qint64 mtime_ms = 0;
+		QJsonObject manifest;
+	};
+
+	void load_scan_cache() const;
+	void save_scan_cache() const;
+	// Manifest for `file` (archive or manifest.json), via the cache.
+	PackageManifest cached_manifest(const QString &file, bool is_archive, bool &dirty) const;
+
 	QString m_packages_dir;
+	mutable QHash<QString, ScanCacheEntry> m_scan_cache;	// Keyed by file name
+	mutable bool m_cache_loaded = false;
+	mutable QHash<QString, std::shared_ptr<PackageArchive>> m_archives;
 };
 
 } // namespace super
@@ -11,6 +11,8 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QFile>
+#include <QStringList>
+#include <vector>
 
 namespace super {
 
@@ -60,13 +62,57 @@ struct HardwareControl {
 	}
 };
 
+// ---------------------------------------------------------------------------
+// ControlIndex — O(1) (status, data1) → control lookup.
+//
+// A flat table over channel-voice messages (0x80–0xEF × 128 data1 values),
+// 28 KB per profile; built only for profiles that are in use.
+// ---------------------------------------------------------------------------
+class ControlIndex {
+public:
+	void build(const QList<HardwareControl> &controls) {
+		m_table.assign(kSize, -1);
+		for (int i = 0; i < controls.size() && i < 0x7FFF; i++) {
+			const int k = key(controls[i].midi_status, controls[i].midi_data1);
+			if (k >= 0 && m_table[k] < 0)
+				m_table[k] = static_cast<qint16>(i);
+		}
+	}
+	bool is_built() const { return !m_table.empty(); }
+
+	// Index into the profile's controls, or -1.
+	int find(int status, int data1) const {
+		const int k = key(status, data1);
+		return (k >= 0 && !m_table.empty()) ? m_table[k] : -1;
+	}
+
+private:
+	static constexpr int kSize = (0xF0 - 0x80) * 128;
+	static int key(int status, int data1) {
+		if (status < 0x80 || status >= 0xF0 || data1 < 0 || data1 > 127)
+			return -1;
+		return (status - 0x80) * 128 + data1;
+	}
+	std::vector<qint16> m_table;
+};
+
 // ---------------------------------------------------------------------------
 // HardwareProfile — A device descriptor loaded from JSON.
 // ---------------------------------------------------------------------------
 struct HardwareProfile {
 	QString vendor;
 	QString model;
+	QStringList device_names;	// MIDI port names that identify the device
 	QList<HardwareControl> controls;
+	ControlIndex index;			// Built by build_index()
+
+	void build_index() { index.build(controls); }
+
+	// Control for an incoming message; needs build_index().
+	const HardwareControl *find_control(int status, int data1) const {
+		const int i = index.find(status, data1);
+		return i >= 0 ? &controls[i] : nullptr;
+	}
 
 	// Full device ID: "vendor.model" (lowercased, spaces replaced)
 	QString device_id() const {
@@ -81,6 +127,8 @@ struct HardwareProfile {
 		HardwareProfile p;
 		p.vendor = obj["vendor"].toString();
 		p.model = obj["model"].toString();
+		for (const auto &v : obj["devices"].toArray())
+			p.device_names.append(v.toString());
 
 		auto arr = obj["controls"].toArray();
 		for (const auto &v : arr)
@@ -0,0 +1,153 @@
+#include "profile_database.hpp"
+#include "../dev/packager/package_manager.hpp"
+
+#include <QDirIterator>
+#include <QFileInfo>
+
+namespace super {
+
+ProfileDatabase &ProfileDatabase::instance()
+{
+	static ProfileDatabase db;
+	return db;
+}
+
+// ---------------------------------------------------------------------------
+// Loading
+// ---------------------------------------------------------------------------
+
+int ProfileDatabase::add(HardwareProfile profile)
+{
+	profile.index = {};		// Rebuilt lazily for the stored copy
+	const QString id = profile.device_id();
+	m_device_matches.clear();
+
+	auto it = m_by_device_id.constFind(id);
+	if (it != m_by_device_id.constEnd()) {
+		m_profiles[*it] = std::move(profile);
+		return *it;
+	}
+	const int index = static_cast<int>(m_profiles.size());
+	m_profiles.push_back(std::move(profile));
+	m_by_device_id.insert(id, index);
+	return index;
+}
+
+int ProfileDatabase::load_directory(const QString &dir)
+{
+	int added = 0;
+	QDirIterator it(dir, {"*.json"}, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext()) {
+		HardwareProfile p = HardwareProfile::load(it.next());
+		if (p.controls.isEmpty())
+			continue;	// Not a profile (or unreadable)
+		add(std::move(p));
+		added++;
+	}
+	if (added)
+		emit profiles_changed();
+	return added;
+}
+
+int ProfileDatabase::load_packages()
+{
+	auto &pm = PackageManager::instance();
+	int added = 0;
+	for (const PackageManifest &m : pm.scan()) {
+		if (m.hardware_profiles.isEmpty())
+			continue;
+		const bool archive = QFileInfo(m.path).isFile();
+		auto a = archive ? pm.archive(m.path) : nullptr;
+		for (const QString &entry : m.hardware_profiles) {
+			QByteArray json;
+			if (a) {
+				json = a->read(entry);
+			} else if (!archive) {
+				QFile f(QDir(m.path).filePath(entry));
+				if (f.open(QIODevice::ReadOnly))
+					json = f.readAll();
+			}
+			HardwareProfile p = HardwareProfile::from_json(QJsonDocument::fromJson(json).object());
+			if (p.controls.isEmpty())
+				continue;
+			add(std::move(p));
+			added++;
+		}
+	}
+	if (added)
+		emit profiles_changed();
+	return added;
+}
+
+void ProfileDatabase::clear()
+{
+	m_profiles.clear();
+	m_by_device_id.clear();
+	m_device_matches.clear();
+	emit profiles_changed();
+}
+
+// ---------------------------------------------------------------------------
+// Lookup
+// ---------------------------------------------------------------------------
+
+const HardwareProfile *ProfileDatabase::profile(int id) const
+{
+	return (id >= 0 && id < count()) ? &m_profiles[id] : nullptr;
+}
+
+int ProfileDatabase::find(const QString &device_id) const
+{
+	return m_by_device_id.value(device_id, -1);
+}
+
+void ProfileDatabase::ensure_index(int id)
+{
+	HardwareProfile &p = m_profiles[id];
+	if (!p.index.is_built())
+		p.build_index();
+}
+
+int ProfileDatabase::match_device(const QString &device_name)
+{
+	auto cached = m_device_matches.constFind(device_name);
+	if (cached != m_device_matches.constEnd())
+		return *cached;
+
+	// Exact device name, then device name contained in the port name
+	// (ports often carry a suffix such as " MIDI 1"), then the model.
+	int found = -1;
+	for (int pass = 0; pass < 3 && found < 0; pass++) {
+		for (int i = 0; i < count() && found < 0; i++) {
+			const HardwareProfile &p = m_profiles[i];
+			if (pass == 2) {
+				if (!p.model.isEmpty() && device_name.contains(p.model, Qt::CaseInsensitive))
+					found = i;
+				continue;
+			}
+			for (const QString &n : p.device_names) {
+				const bool hit = pass == 0 ? n.compare(device_name, Qt::CaseInsensitive) == 0
+										   : device_name.contains(n, Qt::CaseInsensitive);
+				if (hit) {
+					found = i;
+					break;
+				}
+			}
+		}
+	}
+
+	if (found >= 0)
+		ensure_index(found);
+	m_device_matches.insert(device_name, found);
+	return found;
+}
+
+const HardwareControl *ProfileDatabase::control(int id, int status, int data1)
+{
+	if (id < 0 || id >= count())
+		return nullptr;
+	ensure_index(id);
+	return m_profiles[id].find_control(status, data1);
+}
+
+} // namespace super
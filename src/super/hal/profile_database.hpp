@@ -0,0 +1,61 @@
+#pragma once
+
+// ============================================================================
+// Profile Database — All known HardwareProfiles, matched to MIDI devices.
+//
+// Profiles are loaded from loose JSON files and from installed packages.
+// A device is matched by its port name: first against a profile's
+// "devices" list (case-insensitive, exact then substring), then against the
+// model name. Matches are cached per device name, and a matched profile's
+// ControlIndex is built on first use, so learn and dispatch resolve a
+// (status, data1) pair in O(1).
+// ============================================================================
+
+#include "hardware_profile.hpp"
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <vector>
+
+namespace super {
+
+class ProfileDatabase : public QObject {
+	Q_OBJECT
+
+public:
+	static ProfileDatabase &instance();
+
+	// -- Loading --
+	// Every *.json under `dir` (recursively). Returns profiles added.
+	int load_directory(const QString &dir);
+	// hardware_profiles of every package PackageManager finds.
+	int load_packages();
+	// Adds or replaces (by device_id()) a profile. Returns its id.
+	int add(HardwareProfile profile);
+	void clear();
+
+	// -- Lookup --
+	int count() const { return static_cast<int>(m_profiles.size()); }
+	const HardwareProfile *profile(int id) const;
+	int find(const QString &device_id) const;		// -1 if unknown
+
+	// Profile for a MIDI port name (index built), or -1.
+	int match_device(const QString &device_name);
+
+	// Control of profile `id` for an incoming message, O(1).
+	const HardwareControl *control(int id, int status, int data1);
+
+signals:
+	void profiles_changed();
+
+private:
+	ProfileDatabase() : QObject(nullptr) {}
+	void ensure_index(int id);
+
+	std::vector<HardwareProfile> m_profiles;
+	QHash<QString, int> m_by_device_id;
+	QHash<QString, int> m_device_matches;	// Port name → profile id (or -1)
+};
+
+} // namespace super
@@ -1,9 +1,14 @@
 #include "midi_adapter.hpp"
 #include "../core/control_port.hpp"
 #include "../core/control_registry.hpp"
+#include "../core/expression.hpp"
+#include "../hal/profile_database.hpp"
+#include "../dev/debugger/trace_recorder.hpp"
+#include "../dev/metrics/metrics.hpp"
 #include "../../utils/midi/midi_backend.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 namespace super {
 
@@ -78,10 +83,46 @@ double FilterStage::process(double val) const
 
 	case Scale:
 		return val * param1 + param2;
+
+	case Expression: {
+		const ExpressionProgram *prog = program();
+		if (!prog) return val;
+		ExpressionProgram::Inputs in;
+		in.x = val;
+		in.prev = rt_init ? rt_last : val;
+		// Nanosecond resolution: bursts inside 1 ms must not see dt == 0
+		if (rt_init) {
+			in.dt = rt_timer.nsecsElapsed() / 1e9;
+			rt_timer.restart();
+		} else {
+			in.dt = 0.0;
+			rt_init = true;
+			rt_timer.start();
+		}
+		double ports[ExpressionProgram::kMaxPorts];
+		rt_ports.read(ports);
+		in.ports = ports;
+		double out = prog->evaluate(in);
+		// NaN / inf (log of 0, 0/0, ...) holds the last good output
+		if (!std::isfinite(out)) return in.prev;
+		rt_last = out;
+		return out;
+	}
 	}
 	return val;
 }
 
+const ExpressionProgram *FilterStage::program() const
+{
+	if (!rt_compiled || rt_compiled_expr != expr) {
+		rt_program = ExpressionProgram::compile(expr);
+		rt_ports.bind(rt_program.get());
+		rt_compiled_expr = expr;
+		rt_compiled = true;
+	}
+	return rt_program.get();
+}
+
 bool FilterStage::needs_convergence() const
 {
 	if (!enabled) return false;
@@ -100,9 +141,9 @@ bool FilterStage::needs_convergence() const
 QString FilterStage::type_name() const
 {
 	static const char *names[] = {
-		"Delay", "Debounce", "Rate Limit", "Deadzone", "Clamp", "Scale"
+		"Delay", "Debounce", "Rate Limit", "Deadzone", "Clamp", "Scale", "Expression"
 	};
-	return names[qBound(0, type, 5)];
+	return names[qBound(0, type, 6)];
 }
 
 QJsonObject FilterStage::to_json() const
@@ -112,6 +153,7 @@ QJsonObject FilterStage::to_json() const
 	if (!enabled) o["e"] = false;
 	if (param1 != 0.0) o["p1"] = param1;
 	if (param2 != 0.0) o["p2"] = param2;
+	if (!expr.isEmpty()) o["x"] = expr;
 	return o;
 }
 
@@ -122,6 +164,7 @@ FilterStage FilterStage::from_json(const QJsonObject &o)
 	s.enabled = o["e"].toBool(true);
 	s.param1 = o["p1"].toDouble(0.0);
 	s.param2 = o["p2"].toDouble(0.0);
+	s.expr = o["x"].toString();
 	return s;
 }
 
@@ -203,6 +246,7 @@ QJsonObject MidiOutputBinding::to_json() const
 	QJsonObject o;
 	o["port_id"] = port_id;
 	o["device"] = device_index;
+	if (!device_id.isEmpty()) o["device_id"] = device_id;
 	o["channel"] = channel;
 	o["cc"] = cc;
 	o["in_min"] = input_min; o["in_max"] = input_max;
@@ -217,6 +261,7 @@ MidiOutputBinding MidiOutputBinding::from_json(const QJsonObject &o)
 	MidiOutputBinding b;
 	b.port_id = o["port_id"].toString();
 	b.device_index = o["device"].toInt(-1);
+	b.device_id = o["device_id"].toString();
 	b.channel = o["channel"].toInt(0);
 	b.cc = o["cc"].toInt(0);
 	b.input_min = o["in_min"].toDouble(0.0);
@@ -228,6 +273,59 @@ MidiOutputBinding MidiOutputBinding::from_json(const QJsonObject &o)
 	return b;
 }
 
+// ===== MidiSysExBinding / MidiSysExOutput =================================
+
+bool MidiSysExBinding::matches(int device, const SysExBuffer &msg) const
+{
+	if (!enabled) return false;
+	if (device_index != -1 && device_index != device) return false;
+	if (static_cast<size_t>(prefix.size()) > msg.size()) return false;
+	return std::memcmp(msg.data(), prefix.constData(),
+		static_cast<size_t>(prefix.size())) == 0;
+}
+
+QJsonObject MidiSysExBinding::to_json() const
+{
+	QJsonObject o;
+	o["port_id"] = port_id;
+	o["device"] = device_index;
+	if (!device_id.isEmpty()) o["device_id"] = device_id;
+	if (!prefix.isEmpty()) o["prefix"] = QString::fromLatin1(prefix.toHex());
+	if (!enabled) o["enabled"] = false;
+	return o;
+}
+
+MidiSysExBinding MidiSysExBinding::from_json(const QJsonObject &o)
+{
+	MidiSysExBinding b;
+	b.port_id = o["port_id"].toString();
+	b.device_index = o["device"].toInt(-1);
+	b.device_id = o["device_id"].toString();
+	b.prefix = QByteArray::fromHex(o["prefix"].toString().toLatin1());
+	b.enabled = o["enabled"].toBool(true);
+	return b;
+}
+
+QJsonObject MidiSysExOutput::to_json() const
+{
+	QJsonObject o;
+	o["port_id"] = port_id;
+	o["device"] = device_index;
+	if (!device_id.isEmpty()) o["device_id"] = device_id;
+	if (!enabled) o["enabled"] = false;
+	return o;
+}
+
+MidiSysExOutput MidiSysExOutput::from_json(const QJsonObject &o)
+{
+	MidiSysExOutput s;
+	s.port_id = o["port_id"].toString();
+	s.device_index = o["device"].toInt(-1);
+	s.device_id = o["device_id"].toString();
+	s.enabled = o["enabled"].toBool(true);
+	return s;
+}
+
 // ===== MidiPortBinding — Pipeline =========================================
 
 static double eval_curve(const QVector<ValueMapPoint> &pts, int raw, bool invert)
@@ -405,6 +503,7 @@ QJsonObject MidiPortBinding::to_json() const
 {
 	QJsonObject obj;
 	obj["device"] = device_index;
+	if (!device_id.isEmpty()) obj["device_id"] = device_id;
 	obj["channel"] = channel;
 	obj["data1"] = data1;
 	obj["msg_type"] = static_cast<int>(msg_type);
@@ -459,6 +558,7 @@ MidiPortBinding MidiPortBinding::from_json(const QJsonObject &obj)
 {
 	MidiPortBinding b;
 	b.device_index = obj["device"].toInt(-1);
+	b.device_id = obj["device_id"].toString();
 	b.channel = obj["channel"].toInt(0);
 	b.data1 = obj["data1"].toInt(0);
 	b.msg_type = static_cast<MidiPortBinding::MsgType>(obj["msg_type"].toInt(0));
@@ -511,6 +611,29 @@ MidiAdapter::MidiAdapter(QObject *parent) : QObject(parent)
 	connect(m_convergence_timer, &QTimer::timeout,
 			this, &MidiAdapter::on_convergence_tick);
 	m_convergence_timer->start();
+
+	// SysEx pacing timer: only runs while messages are queued
+	m_sysex_timer = new QTimer(this);
+	m_sysex_timer->setTimerType(Qt::PreciseTimer);
+	m_sysex_timer->setInterval(5);
+	connect(m_sysex_timer, &QTimer::timeout, this, &MidiAdapter::on_sysex_tick);
+
+	connect(&ProfileDatabase::instance(), &ProfileDatabase::profiles_changed,
+			this, &MidiAdapter::remap_devices);
+
+	// SysEx outputs may be bound (or loaded) before their Blob port exists
+	auto &reg = ControlRegistry::instance();
+	connect(&reg, &ControlRegistry::port_added, this, [this](const QString &id) {
+		for (const auto &o : m_sysex_outputs) {
+			if (o.port_id == id) {
+				connect_sysex_output(o);
+				break;
+			}
+		}
+	});
+	connect(&reg, &ControlRegistry::port_removed, this, [this](const QString &id) {
+		disconnect(m_sysex_output_connections.take(id));
+	});
 }
 
 MidiAdapter::~MidiAdapter()
@@ -518,6 +641,7 @@ MidiAdapter::~MidiAdapter()
 	if (m_convergence_timer) m_convergence_timer->stop();
 	for (auto *t : m_continuous_timers) delete t;
 	m_continuous_timers.clear();
+	for (const auto &c : m_sysex_output_connections) disconnect(c);
 	detach();
 }
 
@@ -525,9 +649,15 @@ void MidiAdapter::attach(MidiBackend *backend)
 {
 	if (m_backend) detach();
 	m_backend = backend;
-	if (m_backend)
+	if (m_backend) {
 		connect(m_backend, &MidiBackend::midi_message,
 				this, &MidiAdapter::on_midi_message);
+		connect(m_backend, &MidiBackend::sysex_message,
+				this, &MidiAdapter::on_sysex_message);
+		connect(m_backend, &MidiBackend::devices_changed,
+				this, &MidiAdapter::remap_devices);
+		remap_devices();
+	}
 }
 
 void MidiAdapter::detach()
@@ -535,16 +665,52 @@ void MidiAdapter::detach()
 	if (m_backend) {
 		disconnect(m_backend, &MidiBackend::midi_message,
 				   this, &MidiAdapter::on_midi_message);
+		disconnect(m_backend, &MidiBackend::sysex_message,
+				   this, &MidiAdapter::on_sysex_message);
+		disconnect(m_backend, &MidiBackend::devices_changed,
+				   this, &MidiAdapter::remap_devices);
 		m_backend = nullptr;
+		m_sysex_queue.clear();
+		m_sysex_timer->stop();
 	}
 }
 
+// Bindings keep the device's stable id; after a rescan (or when attaching /
+// loading) their indices are re-resolved from it so reordering or hot-plug
+// doesn't retarget them. Bindings without an id adopt the current one.
+// Each input device is also matched to a profile by name.
+void MidiAdapter::remap_devices()
+{
+	if (!m_backend) return;
+	auto &db = ProfileDatabase::instance();
+	const QStringList inputs = m_backend->available_input_devices();
+	m_input_profiles.resize(inputs.size());
+	for (int i = 0; i < inputs.size(); i++)
+		m_input_profiles[i] = db.match_device(inputs[i]);
+
+	for (auto &b : m_bindings)
+		b.device_index = m_backend->remap_input_index(b.device_index, b.device_id);
+	for (auto &b : m_sysex_bindings)
+		b.device_index = m_backend->remap_input_index(b.device_index, b.device_id);
+	for (auto &o : m_outputs)
+		o.device_index = m_backend->remap_output_index(o.device_index, o.device_id);
+	for (auto &o : m_sysex_outputs)
+		o.device_index = m_backend->remap_output_index(o.device_index, o.device_id);
+}
+
 bool MidiAdapter::is_attached() const { return m_backend != nullptr; }
 MidiBackend *MidiAdapter::backend() const { return m_backend; }
 
 // --- Input Binding Management ---
 
-void MidiAdapter::add_binding(const MidiPortBinding &b) { m_bindings.append(b); }
+void MidiAdapter::add_binding(const MidiPortBinding &b)
+{
+	m_bindings.append(b);
+	auto &added = m_bindings.last();
+	// The caller's index is authoritative (UI picks devices by index)
+	if (m_backend && m_backend->devices_ready() && added.device_index >= 0)
+		added.device_id = m_backend->input_device_id(added.device_index);
+}
 
 void MidiAdapter::remove_binding(const QString &port_id)
 {
@@ -574,7 +740,13 @@ const QVector<MidiPortBinding> &MidiAdapter::all_bindings() const { return m_bin
 
 // --- Output Binding Management ---
 
-void MidiAdapter::add_output(const MidiOutputBinding &o) { m_outputs.append(o); }
+void MidiAdapter::add_output(const MidiOutputBinding &o)
+{
+	m_outputs.append(o);
+	auto &added = m_outputs.last();
+	if (m_backend && m_backend->devices_ready() && added.device_index >= 0)
+		added.device_id = m_backend->output_device_id(added.device_index);
+}
 
 void MidiAdapter::remove_output(const QString &port_id)
 {
@@ -595,6 +767,116 @@ QVector<MidiOutputBinding> MidiAdapter::outputs_for(const QString &port_id) cons
 
 const QVector<MidiOutputBinding> &MidiAdapter::all_outputs() const { return m_outputs; }
 
+// --- SysEx Routing ---
+
+void MidiAdapter::add_sysex_binding(const MidiSysExBinding &b)
+{
+	m_sysex_bindings.append(b);
+	auto &added = m_sysex_bindings.last();
+	if (m_backend && m_backend->devices_ready() && added.device_index >= 0)
+		added.device_id = m_backend->input_device_id(added.device_index);
+}
+
+void MidiAdapter::remove_sysex_binding(const QString &port_id)
+{
+	m_sysex_bindings.erase(std::remove_if(m_sysex_bindings.begin(), m_sysex_bindings.end(),
+		[&](const MidiSysExBinding &b) { return b.port_id == port_id; }),
+		m_sysex_bindings.end());
+}
+
+const QVector<MidiSysExBinding> &MidiAdapter::all_sysex_bindings() const { return m_sysex_bindings; }
+
+void MidiAdapter::add_sysex_output(const MidiSysExOutput &o)
+{
+	m_sysex_outputs.append(o);
+	auto &added = m_sysex_outputs.last();
+	if (m_backend && m_backend->devices_ready() && added.device_index >= 0)
+		added.device_id = m_backend->output_device_id(added.device_index);
+	connect_sysex_output(o);
+}
+
+void MidiAdapter::remove_sysex_output(const QString &port_id)
+{
+	m_sysex_outputs.erase(std::remove_if(m_sysex_outputs.begin(), m_sysex_outputs.end(),
+		[&](const MidiSysExOutput &o) { return o.port_id == port_id; }),
+		m_sysex_outputs.end());
+	disconnect(m_sysex_output_connections.take(port_id));
+}
+
+const QVector<MidiSysExOutput> &MidiAdapter::all_sysex_outputs() const { return m_sysex_outputs; }
+
+void MidiAdapter::connect_sysex_output(const MidiSysExOutput &o)
+{
+	if (m_sysex_output_connections.contains(o.port_id)) return;
+	auto *port = ControlRegistry::instance().find(o.port_id);
+	if (!port) return;  // Connected from port_added once it is registered
+
+	// One connection per port; every output bound to it is served from here
+	QString port_id = o.port_id;
+	m_sysex_output_connections.insert(port_id,
+		connect(port, &ControlPort::value_changed, this,
+			[this, port_id](const QVariant &val) {
+				if (!val.canConvert<SysExBuffer>()) return;
+				SysExBuffer msg = val.value<SysExBuffer>();
+				for (const auto &out : m_sysex_outputs)
+					if (out.enabled && out.port_id == port_id)
+						send_sysex(out.device_index, msg);
+			}));
+}
+
+void MidiAdapter::on_sysex_message(int device, const SysExBuffer &msg)
+{
+	SUPER_METRIC_COUNT("midi.sysex_messages");
+	for (const auto &b : m_sysex_bindings) {
+		if (!b.matches(device, msg)) continue;
+		auto *port = ControlRegistry::instance().find(b.port_id);
+		if (!port) continue;
+		// QVariant holds another reference to the pooled block — no copy
+		port->set_value(QVariant::fromValue(msg));
+	}
+}
+
+void MidiAdapter::send_sysex(int device, const SysExBuffer &msg)
+{
+	if (!m_backend || msg.is_empty()) return;
+	m_sysex_queue.append({device, msg});
+	if (!m_sysex_timer->isActive()) {
+		// Fresh burst: allow one message immediately
+		m_sysex_budget = static_cast<double>(msg.size());
+		m_sysex_clock.start();
+		on_sysex_tick();
+		if (!m_sysex_queue.isEmpty())
+			m_sysex_timer->start();
+	}
+}
+
+void MidiAdapter::set_sysex_rate(int bytes_per_sec) { m_sysex_rate = qMax(100, bytes_per_sec); }
+int MidiAdapter::sysex_rate() const { return m_sysex_rate; }
+int MidiAdapter::pending_sysex() const { return m_sysex_queue.size(); }
+
+// Whole messages are released while the byte budget allows; the budget
+// refills at m_sysex_rate. CC feedback goes straight to the backend, so it
+// interleaves between queued messages instead of waiting behind a dump.
+void MidiAdapter::on_sysex_tick()
+{
+	if (!m_backend) { m_sysex_queue.clear(); m_sysex_timer->stop(); return; }
+
+	double elapsed_s = m_sysex_clock.nsecsElapsed() / 1e9;
+	m_sysex_clock.restart();
+	// Cap the refill so an idle period doesn't turn into a burst
+	double cap = qMax(m_sysex_rate * 0.05, 1.0);
+	m_sysex_budget = qMin(m_sysex_budget + elapsed_s * m_sysex_rate, qMax(cap, m_sysex_budget));
+
+	while (!m_sysex_queue.isEmpty() && m_sysex_budget > 0.0) {
+		PendingSysEx next = m_sysex_queue.takeFirst();
+		m_backend->send_sysex(next.device, next.msg);
+		m_sysex_budget -= static_cast<double>(next.msg.size());
+	}
+
+	if (m_sysex_queue.isEmpty())
+		m_sysex_timer->stop();
+}
+
 // --- MIDI Learn ---
 
 void MidiAdapter::start_learn(const QString &port_id)
@@ -612,7 +894,24 @@ bool MidiAdapter::is_learning() const { return m_learning; }
 
 // --- Hardware Profile ---
 
-void MidiAdapter::load_profile(const HardwareProfile &profile) { m_profile = profile; }
+void MidiAdapter::load_profile(const HardwareProfile &profile)
+{
+	m_profile = profile;
+	m_profile.build_index();
+}
+
+int MidiAdapter::device_profile(int device) const
+{
+	return (device >= 0 && device < m_input_profiles.size()) ? m_input_profiles[device] : -1;
+}
+
+const HardwareControl *MidiAdapter::control_for(int device, int status, int data1) const
+{
+	const int id = device_profile(device);
+	if (id >= 0)
+		return ProfileDatabase::instance().control(id, status, data1);
+	return m_profile.find_control(status, data1);
+}
 const HardwareProfile &MidiAdapter::active_profile() const { return m_profile; }
 
 // --- Continuous Fire ---
@@ -699,6 +998,9 @@ void MidiAdapter::on_convergence_tick()
 
 void MidiAdapter::on_midi_message(int device, int status, int data1, int data2)
 {
+	SUPER_TRACE_SCOPE("midi", "receive");
+	SUPER_METRIC_TIME("midi.dispatch");
+	SUPER_METRIC_COUNT("midi.messages");
 	int msg_type = status & 0xF0;
 	int channel = status & 0x0F;
 
@@ -709,13 +1011,10 @@ void MidiAdapter::on_midi_message(int device, int status, int data1, int data2)
 		binding.data1 = data1;
 		binding.msg_type = MidiPortBinding::CC;
 		binding.port_id = m_learn_port_id;
-		for (const auto &ctrl : m_profile.controls) {
-			if (ctrl.midi_status == (msg_type | channel) &&
-				ctrl.midi_data1 == data1 && ctrl.type == "encoder") {
-				binding.is_encoder = true;
-				binding.encoder_mode = ctrl.encoder_mode;
-				break;
-			}
+		const HardwareControl *ctrl = control_for(device, status, data1);
+		if (ctrl && ctrl->type == "encoder") {
+			binding.is_encoder = true;
+			binding.encoder_mode = ctrl->encoder_mode;
 		}
 		m_learning = false; m_learn_port_id.clear();
 		emit binding_learned(binding);
@@ -827,6 +1126,16 @@ QJsonObject MidiAdapter::save() const
 		for (const auto &o : m_outputs) outputs_arr.append(o.to_json());
 		obj["outputs"] = outputs_arr;
 	}
+	if (!m_sysex_bindings.isEmpty()) {
+		QJsonArray arr;
+		for (const auto &b : m_sysex_bindings) arr.append(b.to_json());
+		obj["sysex_in"] = arr;
+	}
+	if (!m_sysex_outputs.isEmpty()) {
+		QJsonArray arr;
+		for (const auto &o : m_sysex_outputs) arr.append(o.to_json());
+		obj["sysex_out"] = arr;
+	}
 	return obj;
 }
 
@@ -840,6 +1149,21 @@ void MidiAdapter::load(const QJsonObject &obj)
 	if (obj.contains("outputs"))
 		for (const auto &v : obj["outputs"].toArray())
 			m_outputs.append(MidiOutputBinding::from_json(v.toObject()));
+
+	m_sysex_bindings.clear();
+	for (const auto &v : obj["sysex_in"].toArray())
+		m_sysex_bindings.append(MidiSysExBinding::from_json(v.toObject()));
+
+	for (const auto &c : m_sysex_output_connections) disconnect(c);
+	m_sysex_output_connections.clear();
+	m_sysex_outputs.clear();
+	for (const auto &v : obj["sysex_out"].toArray())
+		m_sysex_outputs.append(MidiSysExOutput::from_json(v.toObject()));
+	for (const auto &o : m_sysex_outputs)
+		connect_sysex_output(o);
+
+	// Saved ids win over saved indices
+	remap_devices();
 }
 
 } // namespace super
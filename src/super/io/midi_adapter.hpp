@@ -1,7 +1,11 @@
 #pragma once
 #include "../hal/hardware_profile.hpp"
 #include "../core/control_types.hpp"
+#include "../core/expression.hpp"
+#include "../../utils/midi/sysex_buffer.hpp"
 #include <QObject>
+#include <QList>
+#include <QByteArray>
 #include <QString>
 #include <QVector>
 #include <QJsonObject>
@@ -11,6 +15,7 @@
 #include <QElapsedTimer>
 #include <QEasingCurve>
 #include <cmath>
+#include <memory>
 
 class MidiBackend;
 
@@ -31,21 +36,29 @@ struct FilterStage {
 		Deadzone  = 3, // param1 = threshold
 		Clamp     = 4, // param1 = min, param2 = max
 		Scale     = 5, // param1 = factor, param2 = offset
+		Expression = 6, // expr (see ExpressionProgram); prev = last output
 	};
 
 	int type = Deadzone;
 	bool enabled = true;
 	double param1 = 0.0;
 	double param2 = 0.0;
+	QString expr;
 
 	mutable double rt_last = 0.0;
 	mutable double rt_target = 0.0;  // For convergence (RateLimit, Delay)
 	mutable bool rt_init = false;
 	mutable QElapsedTimer rt_timer;
+	// Compiled on first use and whenever expr changes (failures cached too)
+	mutable std::shared_ptr<const ExpressionProgram> rt_program;
+	mutable ExpressionPorts rt_ports;
+	mutable QString rt_compiled_expr;
+	mutable bool rt_compiled = false;
 
 	double process(double val) const;
 	bool needs_convergence() const;
 	QString type_name() const;
+	const ExpressionProgram *program() const;
 
 	QJsonObject to_json() const;
 	static FilterStage from_json(const QJsonObject &o);
@@ -138,6 +151,7 @@ enum class ActionMode {
 struct MidiOutputBinding {
 	QString port_id;
 	int device_index = -1;
+	QString device_id;
 	int channel = 0;
 	int cc = 0;
 	double input_min = 0.0;   // Port value → output_min MIDI
@@ -155,6 +169,39 @@ struct MidiOutputBinding {
 	static MidiOutputBinding from_json(const QJsonObject &o);
 };
 
+// ---------------------------------------------------------------------------
+// MidiSysExBinding — Routes incoming SysEx to a Blob port.
+// A message matches when it starts with `prefix` (e.g. F0 00 20 29 for one
+// manufacturer); an empty prefix matches every SysEx message.
+// The port receives the pooled SysExBuffer itself, not a copy.
+// ---------------------------------------------------------------------------
+struct MidiSysExBinding {
+	QString port_id;
+	int device_index = -1;
+	QString device_id;
+	QByteArray prefix;
+	bool enabled = true;
+
+	bool matches(int device, const SysExBuffer &msg) const;
+
+	QJsonObject to_json() const;
+	static MidiSysExBinding from_json(const QJsonObject &o);
+};
+
+// ---------------------------------------------------------------------------
+// MidiSysExOutput — Sends a Blob port's SysExBuffer to a device when the
+// port value changes (scribble strips, displays, firmware feedback).
+// ---------------------------------------------------------------------------
+struct MidiSysExOutput {
+	QString port_id;
+	int device_index = -1;
+	QString device_id;
+	bool enabled = true;
+
+	QJsonObject to_json() const;
+	static MidiSysExOutput from_json(const QJsonObject &o);
+};
+
 // ---------------------------------------------------------------------------
 // MidiPortBinding — Maps a MIDI input to a ControlPort.
 //
@@ -164,6 +211,7 @@ struct MidiOutputBinding {
 // ---------------------------------------------------------------------------
 struct MidiPortBinding {
 	int device_index = -1;
+	QString device_id;    // Stable identity; device_index is remapped from it
 	int channel = 0;
 	int data1 = 0;
 
@@ -261,14 +309,36 @@ public:
 	QVector<MidiOutputBinding> outputs_for(const QString &port_id) const;
 	const QVector<MidiOutputBinding> &all_outputs() const;
 
+	// SysEx routing (Blob ports)
+	void add_sysex_binding(const MidiSysExBinding &b);
+	void remove_sysex_binding(const QString &port_id);
+	const QVector<MidiSysExBinding> &all_sysex_bindings() const;
+
+	void add_sysex_output(const MidiSysExOutput &o);
+	void remove_sysex_output(const QString &port_id);
+	const QVector<MidiSysExOutput> &all_sysex_outputs() const;
+
+	// Queue a SysEx message for paced output. Messages are released at
+	// most `sysex_rate()` bytes/sec so short CC feedback keeps flowing
+	// between them.
+	void send_sysex(int device, const SysExBuffer &msg);
+	void set_sysex_rate(int bytes_per_sec);
+	int sysex_rate() const;
+	int pending_sysex() const;
+
 	// MIDI Learn
 	void start_learn(const QString &port_id);
 	void cancel_learn();
 	bool is_learning() const;
 
 	// Hardware Profiles
+	// Fallback profile for devices ProfileDatabase can't match.
 	void load_profile(const HardwareProfile &profile);
 	const HardwareProfile &active_profile() const;
+	// Profile matched to an input device (ProfileDatabase id), or -1.
+	int device_profile(int device) const;
+	// Profile control for an incoming message on `device`, O(1).
+	const HardwareControl *control_for(int device, int status, int data1) const;
 
 	// Persistence
 	QJsonObject save() const;
@@ -285,11 +355,30 @@ private:
 	void start_continuous_fire(int binding_index);
 	void stop_continuous_fire(int binding_index);
 	void send_feedback(const QString &port_id, double value);
+	void on_sysex_message(int device, const SysExBuffer &msg);
+	void connect_sysex_output(const MidiSysExOutput &o);
+	void on_sysex_tick();
+	void remap_devices();
 
 	MidiBackend *m_backend = nullptr;
 	QVector<MidiPortBinding> m_bindings;
 	QVector<MidiOutputBinding> m_outputs;
+	QVector<MidiSysExBinding> m_sysex_bindings;
+	QVector<MidiSysExOutput> m_sysex_outputs;
+	QHash<QString, QMetaObject::Connection> m_sysex_output_connections;
+
+	// Paced SysEx output queue
+	struct PendingSysEx {
+		int device;
+		SysExBuffer msg;
+	};
+	QList<PendingSysEx> m_sysex_queue;
+	QTimer *m_sysex_timer = nullptr;
+	QElapsedTimer m_sysex_clock;
+	double m_sysex_budget = 0.0;  // Bytes allowed to go out right now
+	int m_sysex_rate = 3125;      // MIDI 1.0 DIN wire rate
 	HardwareProfile m_profile;
+	QVector<int> m_input_profiles;	// Input device index → ProfileDatabase id
 
 	bool m_learning = false;
 	QString m_learn_port_id;
@@ -0,0 +1,909 @@
+#include "osc_adapter.hpp"
+#include "../core/control_port.hpp"
+#include "../core/control_registry.hpp"
+
+#include <QThread>
+#include <QUdpSocket>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace super {
+
+// Keep feedback bundles under a typical Wi-Fi MTU so tablets don't drop them
+static constexpr int kMaxDatagram = 1400;
+static constexpr int kResolveCacheLimit = 4096;
+
+// ===== OSC Codec ==========================================================
+
+namespace osc {
+
+static int padded(int n) { return (n + 3) & ~3; }
+
+static bool read_string(const char *data, int size, int &pos, const char *&str, int &len)
+{
+	if (pos >= size) return false;
+	const char *start = data + pos;
+	const void *nul = std::memchr(start, 0, static_cast<size_t>(size - pos));
+	if (!nul) return false;
+	len = static_cast<int>(static_cast<const char *>(nul) - start);
+	int next = pos + padded(len + 1);
+	if (next > size) return false;
+	str = start;
+	pos = next;
+	return true;
+}
+
+static bool decode_message(const char *data, int size,
+						   const std::function<void(OscMessage &&)> &sink)
+{
+	int pos = 0;
+	const char *addr;
+	int addr_len;
+	if (!read_string(data, size, pos, addr, addr_len)) return false;
+
+	OscMessage msg;
+	msg.address = QByteArray(addr, addr_len);
+
+	// Pre-1.0 senders may omit the type tag string entirely
+	if (pos >= size) {
+		sink(std::move(msg));
+		return true;
+	}
+
+	const char *tags;
+	int tag_len;
+	if (!read_string(data, size, pos, tags, tag_len) || tag_len == 0 || tags[0] != ',')
+		return false;
+
+	msg.args.reserve(tag_len - 1);
+	for (int i = 1; i < tag_len; i++) {
+		const char *p = data + pos;
+		switch (tags[i]) {
+		case 'i':
+			if (pos + 4 > size) return false;
+			msg.args.append(qFromBigEndian<qint32>(p));
+			pos += 4;
+			break;
+		case 'f': {
+			if (pos + 4 > size) return false;
+			quint32 bits = qFromBigEndian<quint32>(p);
+			float f;
+			std::memcpy(&f, &bits, sizeof(f));
+			msg.args.append(static_cast<double>(f));
+			pos += 4;
+			break;
+		}
+		case 'h':
+			if (pos + 8 > size) return false;
+			msg.args.append(static_cast<qlonglong>(qFromBigEndian<qint64>(p)));
+			pos += 8;
+			break;
+		case 'd': {
+			if (pos + 8 > size) return false;
+			quint64 bits = qFromBigEndian<quint64>(p);
+			double d;
+			std::memcpy(&d, &bits, sizeof(d));
+			msg.args.append(d);
+			pos += 8;
+			break;
+		}
+		case 't':
+			if (pos + 8 > size) return false;
+			msg.args.append(static_cast<qulonglong>(qFromBigEndian<quint64>(p)));
+			pos += 8;
+			break;
+		case 'c':
+		case 'r':
+			if (pos + 4 > size) return false;
+			if (tags[i] == 'c')
+				msg.args.append(QString(QChar(qFromBigEndian<qint32>(p))));
+			else
+				msg.args.append(qFromBigEndian<quint32>(p));
+			pos += 4;
+			break;
+		case 'm':
+			if (pos + 4 > size) return false;
+			msg.args.append(QByteArray(p, 4));
+			pos += 4;
+			break;
+		case 's':
+		case 'S': {
+			const char *str;
+			int len;
+			if (!read_string(data, size, pos, str, len)) return false;
+			msg.args.append(QString::fromUtf8(str, len));
+			break;
+		}
+		case 'b': {
+			if (pos + 4 > size) return false;
+			qint32 len = qFromBigEndian<qint32>(p);
+			if (len < 0 || pos + 4 + padded(len) > size) return false;
+			msg.args.append(QByteArray(p + 4, len));
+			pos += 4 + padded(len);
+			break;
+		}
+		case 'T': msg.args.append(true); break;
+		case 'F': msg.args.append(false); break;
+		case 'N':
+		case 'I': msg.args.append(QVariant()); break;
+		case '[':
+		case ']': break;	// Arrays are flattened
+		default:
+			return false;	// Unknown tag: argument size unknown
+		}
+	}
+
+	sink(std::move(msg));
+	return true;
+}
+
+bool decode_packet(const char *data, int size,
+				   const std::function<void(OscMessage &&)> &sink)
+{
+	if (size < 4 || (size & 3) != 0)
+		return false;
+
+	if (data[0] == '#') {
+		if (size < 16 || std::memcmp(data, "#bundle\0", 8) != 0)
+			return false;
+		// Timetag (bytes 8..15) is ignored: bundles apply on arrival
+		int pos = 16;
+		while (pos + 4 <= size) {
+			qint32 len = qFromBigEndian<qint32>(data + pos);
+			pos += 4;
+			if (len < 0 || len > size - pos)
+				return false;
+			if (!decode_packet(data + pos, len, sink))
+				return false;
+			pos += len;
+		}
+		return pos == size;
+	}
+
+	if (data[0] != '/')
+		return false;
+	return decode_message(data, size, sink);
+}
+
+static void append_string(QByteArray &out, const char *str, int len)
+{
+	out.append(str, len);
+	int pad = padded(len + 1) - len;
+	out.append(pad, '\0');
+}
+
+static void append_u32(QByteArray &out, quint32 v)
+{
+	char buf[4];
+	qToBigEndian(v, buf);
+	out.append(buf, 4);
+}
+
+static void append_u64(QByteArray &out, quint64 v)
+{
+	char buf[8];
+	qToBigEndian(v, buf);
+	out.append(buf, 8);
+}
+
+void append_message(QByteArray &out, const QByteArray &address, const QVariantList &args)
+{
+	append_string(out, address.constData(), address.size());
+
+	QByteArray tags(",");
+	for (const auto &a : args) {
+		switch (a.typeId()) {
+		case QMetaType::Bool: tags.append(a.toBool() ? 'T' : 'F'); break;
+		case QMetaType::Int:
+		case QMetaType::UInt: tags.append('i'); break;
+		case QMetaType::LongLong:
+		case QMetaType::ULongLong: tags.append('h'); break;
+		case QMetaType::Double:
+		case QMetaType::Float: tags.append('f'); break;
+		case QMetaType::QString: tags.append('s'); break;
+		case QMetaType::QByteArray: tags.append('b'); break;
+		default: tags.append('N'); break;
+		}
+	}
+	append_string(out, tags.constData(), tags.size());
+
+	for (const auto &a : args) {
+		switch (a.typeId()) {
+		case QMetaType::Int:
+		case QMetaType::UInt:
+			append_u32(out, static_cast<quint32>(a.toInt()));
+			break;
+		case QMetaType::LongLong:
+		case QMetaType::ULongLong:
+			append_u64(out, static_cast<quint64>(a.toLongLong()));
+			break;
+		case QMetaType::Double:
+		case QMetaType::Float: {
+			float f = a.toFloat();
+			quint32 bits;
+			std::memcpy(&bits, &f, sizeof(bits));
+			append_u32(out, bits);
+			break;
+		}
+		case QMetaType::QString: {
+			QByteArray utf8 = a.toString().toUtf8();
+			append_string(out, utf8.constData(), utf8.size());
+			break;
+		}
+		case QMetaType::QByteArray: {
+			QByteArray blob = a.toByteArray();
+			append_u32(out, static_cast<quint32>(blob.size()));
+			out.append(blob);
+			out.append(padded(blob.size()) - blob.size(), '\0');
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+void begin_bundle(QByteArray &out)
+{
+	out.append("#bundle\0", 8);
+	append_u64(out, 1);
+}
+
+void append_bundle_element(QByteArray &out, const QByteArray &message)
+{
+	append_u32(out, static_cast<quint32>(message.size()));
+	out.append(message);
+}
+
+} // namespace osc
+
+// ===== OscPattern =========================================================
+
+bool OscPattern::is_pattern(const char *addr, int len)
+{
+	for (int i = 0; i < len; i++) {
+		char c = addr[i];
+		if (c == '?' || c == '*' || c == '[' || c == '{')
+			return true;
+	}
+	return false;
+}
+
+bool OscPattern::compile(const QByteArray &pattern)
+{
+	m_tokens.clear();
+	const char *p = pattern.constData();
+	int n = pattern.size();
+	int i = 0;
+
+	while (i < n) {
+		char c = p[i];
+		if (c == '?') {
+			Token t;
+			t.kind = Token::AnyChar;
+			m_tokens.append(t);
+			i++;
+		} else if (c == '*') {
+			if (m_tokens.isEmpty() || m_tokens.last().kind != Token::AnySeq) {
+				Token t;
+				t.kind = Token::AnySeq;
+				m_tokens.append(t);
+			}
+			i++;
+		} else if (c == '[') {
+			Token t;
+			t.kind = Token::CharSet;
+			int j = i + 1;
+			if (j < n && p[j] == '!') {
+				t.negate = true;
+				j++;
+			}
+			while (j < n && p[j] != ']') {
+				auto a = static_cast<unsigned char>(p[j]);
+				if (j + 2 < n && p[j + 1] == '-' && p[j + 2] != ']') {
+					auto b = static_cast<unsigned char>(p[j + 2]);
+					for (int x = qMin(a, b); x <= qMax(a, b); x++)
+						t.set.set(static_cast<size_t>(x));
+					j += 3;
+				} else {
+					t.set.set(a);
+					j++;
+				}
+			}
+			if (j >= n) return false;
+			m_tokens.append(t);
+			i = j + 1;
+		} else if (c == '{') {
+			int j = pattern.indexOf('}', i);
+			if (j < 0) return false;
+			Token t;
+			t.kind = Token::Alternatives;
+			t.alts = pattern.mid(i + 1, j - i - 1).split(',');
+			m_tokens.append(t);
+			i = j + 1;
+		} else {
+			int j = i;
+			while (j < n && p[j] != '?' && p[j] != '*' && p[j] != '[' && p[j] != '{')
+				j++;
+			Token t;
+			t.kind = Token::Literal;
+			t.text = pattern.mid(i, j - i);
+			m_tokens.append(t);
+			i = j;
+		}
+	}
+	return true;
+}
+
+bool OscPattern::matches(const char *addr, int len) const
+{
+	return match_from(0, addr, len);
+}
+
+bool OscPattern::match_from(int ti, const char *addr, int len) const
+{
+	if (ti == m_tokens.size())
+		return len == 0;
+
+	const Token &t = m_tokens[ti];
+	switch (t.kind) {
+	case Token::Literal: {
+		int n = t.text.size();
+		if (len < n || std::memcmp(addr, t.text.constData(), static_cast<size_t>(n)) != 0)
+			return false;
+		return match_from(ti + 1, addr + n, len - n);
+	}
+	case Token::AnyChar:
+		if (len == 0 || addr[0] == '/') return false;
+		return match_from(ti + 1, addr + 1, len - 1);
+	case Token::AnySeq:
+		// Never crosses a path separator
+		for (int k = 0;; k++) {
+			if (match_from(ti + 1, addr + k, len - k))
+				return true;
+			if (k == len || addr[k] == '/')
+				return false;
+		}
+	case Token::CharSet:
+		if (len == 0 || addr[0] == '/') return false;
+		if (t.set.test(static_cast<unsigned char>(addr[0])) == t.negate) return false;
+		return match_from(ti + 1, addr + 1, len - 1);
+	case Token::Alternatives:
+		for (const auto &alt : t.alts) {
+			int n = alt.size();
+			if (len >= n && std::memcmp(addr, alt.constData(), static_cast<size_t>(n)) == 0 &&
+				match_from(ti + 1, addr + n, len - n))
+				return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+// ===== OscAddressTable ====================================================
+
+void OscAddressTable::resolve(const char *addr, int len, QVector<int> &out) const
+{
+	if (OscPattern::is_pattern(addr, len)) {
+		// Sender-side pattern (e.g. "/mixer/*/mute"): fan out over exact entries
+		OscPattern pat;
+		if (!pat.compile(QByteArray(addr, len))) return;
+		for (auto it = exact.cbegin(); it != exact.cend(); ++it)
+			if (pat.matches(it.key().constData(), it.key().size()))
+				out += it.value();
+		return;
+	}
+
+	auto it = exact.constFind(QByteArray::fromRawData(addr, len));
+	if (it != exact.cend())
+		out += it.value();
+	for (const auto &p : patterns)
+		if (p.first.matches(addr, len))
+			out += p.second;
+}
+
+// ===== OscBinding / OscOutput =============================================
+
+QJsonObject OscBinding::to_json() const
+{
+	QJsonObject o;
+	o["address"] = address;
+	o["port_id"] = port_id;
+	if (arg_index != 0) o["arg"] = arg_index;
+	o["scale"] = scale;
+	o["in_min"] = in_min;
+	o["in_max"] = in_max;
+	if (!enabled) o["enabled"] = false;
+	return o;
+}
+
+OscBinding OscBinding::from_json(const QJsonObject &o)
+{
+	OscBinding b;
+	b.address = o["address"].toString();
+	b.port_id = o["port_id"].toString();
+	b.arg_index = o["arg"].toInt(0);
+	b.scale = o["scale"].toBool(true);
+	b.in_min = o["in_min"].toDouble(0.0);
+	b.in_max = o["in_max"].toDouble(1.0);
+	b.enabled = o["enabled"].toBool(true);
+	return b;
+}
+
+QJsonObject OscOutput::to_json() const
+{
+	QJsonObject o;
+	o["port_id"] = port_id;
+	o["address"] = address;
+	o["scale"] = scale;
+	o["out_min"] = out_min;
+	o["out_max"] = out_max;
+	if (!enabled) o["enabled"] = false;
+	return o;
+}
+
+OscOutput OscOutput::from_json(const QJsonObject &o)
+{
+	OscOutput out;
+	out.port_id = o["port_id"].toString();
+	out.address = o["address"].toString();
+	out.scale = o["scale"].toBool(true);
+	out.out_min = o["out_min"].toDouble(0.0);
+	out.out_max = o["out_max"].toDouble(1.0);
+	out.enabled = o["enabled"].toBool(true);
+	return out;
+}
+
+// ===== OscAdapter =========================================================
+
+OscAdapter::OscAdapter(QObject *parent) : QObject(parent)
+{
+	m_feedback_timer = new QTimer(this);
+	m_feedback_timer->setSingleShot(true);
+	m_feedback_timer->setTimerType(Qt::PreciseTimer);
+	m_feedback_timer->setInterval(16);
+	connect(m_feedback_timer, &QTimer::timeout, this, &OscAdapter::flush_feedback);
+
+	auto &reg = ControlRegistry::instance();
+	auto on_ports_changed = [this]() {
+		resolve_ports();
+		connect_outputs();
+	};
+	connect(&reg, &ControlRegistry::port_added, this, on_ports_changed);
+	connect(&reg, &ControlRegistry::port_removed, this, on_ports_changed);
+
+	rebuild_table();
+}
+
+OscAdapter::~OscAdapter()
+{
+	close();
+	for (const auto &c : m_output_connections) disconnect(c);
+}
+
+// --- Socket ---
+
+bool OscAdapter::open(quint16 listen_port, const QHostAddress &bind)
+{
+	close();
+
+	m_thread = new QThread(this);
+	m_thread->setObjectName("super-osc");
+	m_io = new QObject;
+	m_io->moveToThread(m_thread);
+	m_thread->start();
+
+	bool ok = false;
+	quint16 bound_port = 0;
+	QMetaObject::invokeMethod(m_io, [&]() {
+		m_socket = new QUdpSocket(m_io);
+		if (!m_socket->bind(bind, listen_port)) {
+			delete m_socket;
+			m_socket = nullptr;
+			return;
+		}
+		m_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1 << 20);
+		connect(m_socket, &QUdpSocket::readyRead, m_io, [this]() { on_datagrams(); });
+		bound_port = m_socket->localPort();
+		ok = true;
+	}, Qt::BlockingQueuedConnection);
+
+	if (!ok) {
+		close();
+		return false;
+	}
+	m_listen_port = bound_port;
+	emit opened(m_listen_port);
+	return true;
+}
+
+void OscAdapter::close()
+{
+	if (!m_thread)
+		return;
+
+	QMetaObject::invokeMethod(m_io, [this]() {
+		delete m_socket;
+		m_socket = nullptr;
+	}, Qt::BlockingQueuedConnection);
+	m_thread->quit();
+	m_thread->wait();
+	delete m_io;
+	m_io = nullptr;
+	delete m_thread;
+	m_thread = nullptr;
+
+	m_feedback_timer->stop();
+	m_dirty_outputs.clear();
+	bool was_open = m_listen_port != 0;
+	m_listen_port = 0;
+	if (was_open)
+		emit closed();
+}
+
+bool OscAdapter::is_open() const { return m_listen_port != 0; }
+quint16 OscAdapter::listen_port() const { return m_listen_port; }
+
+void OscAdapter::set_remote(const QHostAddress &host, quint16 port)
+{
+	QMutexLocker lock(&m_mutex);
+	m_remote_host = host;
+	m_remote_port = port;
+}
+
+QHostAddress OscAdapter::remote_host() const
+{
+	QMutexLocker lock(&m_mutex);
+	return m_remote_host;
+}
+
+quint16 OscAdapter::remote_port() const
+{
+	QMutexLocker lock(&m_mutex);
+	return m_remote_port;
+}
+
+// --- Bindings ---
+
+void OscAdapter::add_binding(const OscBinding &b)
+{
+	m_bindings.append(b);
+	rebuild_table();
+}
+
+void OscAdapter::remove_binding(const QString &port_id)
+{
+	m_bindings.erase(std::remove_if(m_bindings.begin(), m_bindings.end(),
+		[&](const OscBinding &b) { return b.port_id == port_id; }),
+		m_bindings.end());
+	rebuild_table();
+}
+
+void OscAdapter::remove_all_bindings()
+{
+	m_bindings.clear();
+	rebuild_table();
+}
+
+const QVector<OscBinding> &OscAdapter::all_bindings() const { return m_bindings; }
+
+void OscAdapter::add_output(const OscOutput &o)
+{
+	m_outputs.append(o);
+	connect_outputs();
+}
+
+void OscAdapter::remove_output(const QString &port_id)
+{
+	m_outputs.erase(std::remove_if(m_outputs.begin(), m_outputs.end(),
+		[&](const OscOutput &o) { return o.port_id == port_id; }),
+		m_outputs.end());
+	connect_outputs();
+}
+
+void OscAdapter::remove_all_outputs()
+{
+	m_outputs.clear();
+	connect_outputs();
+}
+
+const QVector<OscOutput> &OscAdapter::all_outputs() const { return m_outputs; }
+
+// Publish a new immutable table; the socket thread picks it up on its next
+// batch and drops resolve results tagged with an older generation.
+void OscAdapter::rebuild_table()
+{
+	auto table = std::make_shared<OscAddressTable>();
+	table->generation = ++m_generation;
+	table->bindings = m_bindings;
+
+	for (int i = 0; i < m_bindings.size(); i++) {
+		QByteArray addr = m_bindings[i].address.toUtf8();
+		if (OscPattern::is_pattern(addr.constData(), addr.size())) {
+			OscPattern pat;
+			if (pat.compile(addr))
+				table->patterns.append({pat, {i}});
+		} else {
+			table->exact[addr].append(i);
+		}
+	}
+
+	{
+		QMutexLocker lock(&m_mutex);
+		m_table = std::move(table);
+		m_inbound.clear();
+	}
+	resolve_ports();
+}
+
+void OscAdapter::resolve_ports()
+{
+	auto &reg = ControlRegistry::instance();
+	m_ports.resize(m_bindings.size());
+	for (int i = 0; i < m_bindings.size(); i++)
+		m_ports[i] = reg.find(m_bindings[i].port_id);
+}
+
+void OscAdapter::connect_outputs()
+{
+	for (const auto &c : m_output_connections) disconnect(c);
+	m_output_connections.clear();
+	m_dirty_outputs.clear();
+
+	auto &reg = ControlRegistry::instance();
+	for (int i = 0; i < m_outputs.size(); i++) {
+		auto *port = reg.find(m_outputs[i].port_id);
+		if (!port) continue;
+		m_output_connections.append(connect(port, &ControlPort::value_changed, this,
+			[this, i](const QVariant &) { queue_feedback(i); }));
+	}
+}
+
+// --- Input (socket thread) ---
+
+void OscAdapter::on_datagrams()
+{
+	std::shared_ptr<const OscAddressTable> table;
+	{
+		QMutexLocker lock(&m_mutex);
+		table = m_table;
+	}
+	if (table->generation != m_cache_generation) {
+		m_resolve_cache.clear();
+		m_cache_generation = table->generation;
+	}
+
+	QVector<Inbound> batch;
+	QSet<QByteArray> unmatched;
+
+	auto sink = [&](OscMessage &&msg) {
+		auto cached = m_resolve_cache.constFind(msg.address);
+		if (cached == m_resolve_cache.cend()) {
+			QVector<int> hits;
+			table->resolve(msg.address.constData(), msg.address.size(), hits);
+			if (m_resolve_cache.size() >= kResolveCacheLimit)
+				m_resolve_cache.clear();
+			cached = m_resolve_cache.insert(msg.address, hits);
+		}
+		if (cached->isEmpty()) {
+			unmatched.insert(msg.address);
+			return;
+		}
+		for (int b : *cached) {
+			const auto &binding = table->bindings[b];
+			if (!binding.enabled) continue;
+			// Argument-less messages act as triggers
+			QVariant value = binding.arg_index < msg.args.size()
+				? msg.args[binding.arg_index] : QVariant();
+			batch.append({table->generation, b, value});
+		}
+	};
+
+	while (m_socket && m_socket->hasPendingDatagrams()) {
+		qint64 size = m_socket->pendingDatagramSize();
+		if (size < 0) break;
+		if (m_rx_buffer.size() < size)
+			m_rx_buffer.resize(static_cast<qsizetype>(size));
+		qint64 got = m_socket->readDatagram(m_rx_buffer.data(), size);
+		if (got <= 0) continue;
+
+		m_packets_received.fetch_add(1, std::memory_order_relaxed);
+		if (!osc::decode_packet(m_rx_buffer.constData(), static_cast<int>(got), sink))
+			m_packets_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (batch.isEmpty() && unmatched.isEmpty())
+		return;
+
+	{
+		QMutexLocker lock(&m_mutex);
+		m_inbound += batch;
+		m_unmatched.unite(unmatched);
+	}
+	// One queued call per burst, however many datagrams it carried
+	if (!m_drain_pending.exchange(true))
+		QMetaObject::invokeMethod(this, [this]() { drain_inbound(); }, Qt::QueuedConnection);
+}
+
+// --- Input (owner thread) ---
+
+void OscAdapter::drain_inbound()
+{
+	m_drain_pending = false;
+
+	QVector<Inbound> batch;
+	QSet<QByteArray> unmatched;
+	{
+		QMutexLocker lock(&m_mutex);
+		batch.swap(m_inbound);
+		unmatched.swap(m_unmatched);
+	}
+
+	// Only the newest value per binding is applied; commands fire every time
+	QVector<int> last(m_ports.size(), -1);
+	for (int i = 0; i < batch.size(); i++)
+		if (batch[i].generation == m_generation && batch[i].binding < last.size())
+			last[batch[i].binding] = i;
+
+	for (int i = 0; i < batch.size(); i++) {
+		const Inbound &in = batch[i];
+		if (in.generation != m_generation || in.binding >= m_ports.size())
+			continue;
+		ControlPort *port = m_ports[in.binding];
+		if (!port) continue;
+		if (last[in.binding] != i && port->type() != ControlType::Command)
+			continue;
+
+		const OscBinding &b = m_bindings[in.binding];
+		QVariant value = in.value.isValid() ? in.value : QVariant(true);
+		int type_id = value.typeId();
+		bool numeric = type_id == QMetaType::Int || type_id == QMetaType::LongLong ||
+					   type_id == QMetaType::Double;
+		if (b.scale && numeric) {
+			double span = b.in_max - b.in_min;
+			double t = span != 0.0 ? (value.toDouble() - b.in_min) / span : 0.0;
+			value = port->range_min() + t * (port->range_max() - port->range_min());
+		}
+
+		m_echo_guard = b.address;
+		port->set_value(value, true);
+	}
+	m_echo_guard.clear();
+
+	for (const auto &addr : unmatched)
+		emit unmatched_message(QString::fromUtf8(addr));
+}
+
+// --- Output ---
+
+void OscAdapter::queue_feedback(int output_index)
+{
+	if (!is_open() || output_index >= m_outputs.size())
+		return;
+	const OscOutput &o = m_outputs[output_index];
+	if (!o.enabled)
+		return;
+	// Don't bounce a value straight back to the control that sent it
+	if (!m_echo_guard.isEmpty() && m_echo_guard == o.address)
+		return;
+
+	m_dirty_outputs.insert(output_index);
+	if (!m_feedback_timer->isActive())
+		m_feedback_timer->start();
+}
+
+void OscAdapter::flush_feedback()
+{
+	if (m_dirty_outputs.isEmpty())
+		return;
+
+	auto &reg = ControlRegistry::instance();
+	QByteArray bundle;
+	QByteArray msg;
+	int elements = 0;
+	osc::begin_bundle(bundle);
+
+	for (int index : m_dirty_outputs) {
+		if (index >= m_outputs.size()) continue;
+		const OscOutput &o = m_outputs[index];
+		auto *port = reg.find(o.port_id);
+		if (!port) continue;
+
+		QVariant arg;
+		switch (port->type()) {
+		case ControlType::String: arg = port->as_string(); break;
+		case ControlType::Toggle: arg = port->as_bool(); break;
+		default:
+			arg = o.scale
+				? o.out_min + port->normalized_value() * (o.out_max - o.out_min)
+				: port->as_double();
+			break;
+		}
+
+		msg.clear();
+		osc::append_message(msg, o.address.toUtf8(), {arg});
+		if (elements > 0 && bundle.size() + 4 + msg.size() > kMaxDatagram) {
+			write_datagram(bundle);
+			bundle.clear();
+			osc::begin_bundle(bundle);
+			elements = 0;
+		}
+		osc::append_bundle_element(bundle, msg);
+		elements++;
+	}
+	m_dirty_outputs.clear();
+
+	if (elements > 0)
+		write_datagram(bundle);
+}
+
+void OscAdapter::send(const QByteArray &address, const QVariantList &args)
+{
+	QByteArray msg;
+	osc::append_message(msg, address, args);
+	write_datagram(msg);
+}
+
+void OscAdapter::write_datagram(const QByteArray &bytes)
+{
+	if (!m_io)
+		return;
+	QHostAddress host;
+	quint16 port;
+	{
+		QMutexLocker lock(&m_mutex);
+		host = m_remote_host;
+		port = m_remote_port;
+	}
+	QMetaObject::invokeMethod(m_io, [this, bytes, host, port]() {
+		if (m_socket)
+			m_socket->writeDatagram(bytes, host, port);
+	}, Qt::QueuedConnection);
+}
+
+// --- Persistence ---
+
+QJsonObject OscAdapter::save() const
+{
+	QJsonObject obj;
+	obj["listen_port"] = static_cast<int>(m_listen_port);
+	obj["remote_host"] = remote_host().toString();
+	obj["remote_port"] = static_cast<int>(remote_port());
+
+	QJsonArray bindings_arr;
+	for (const auto &b : m_bindings) bindings_arr.append(b.to_json());
+	obj["bindings"] = bindings_arr;
+
+	if (!m_outputs.isEmpty()) {
+		QJsonArray outputs_arr;
+		for (const auto &o : m_outputs) outputs_arr.append(o.to_json());
+		obj["outputs"] = outputs_arr;
+	}
+	return obj;
+}
+
+void OscAdapter::load(const QJsonObject &obj)
+{
+	m_bindings.clear();
+	for (const auto &v : obj["bindings"].toArray())
+		m_bindings.append(OscBinding::from_json(v.toObject()));
+	rebuild_table();
+
+	m_outputs.clear();
+	for (const auto &v : obj["outputs"].toArray())
+		m_outputs.append(OscOutput::from_json(v.toObject()));
+	connect_outputs();
+
+	QHostAddress host(obj["remote_host"].toString());
+	set_remote(host.isNull() ? QHostAddress(QHostAddress::LocalHost) : host,
+			   static_cast<quint16>(obj["remote_port"].toInt(9000)));
+
+	int port = obj["listen_port"].toInt(0);
+	if (port > 0)
+		open(static_cast<quint16>(port));
+}
+
+} // namespace super
@@ -0,0 +1,231 @@
+#pragma once
+#include "../core/control_types.hpp"
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QVariant>
+#include <QHash>
+#include <QSet>
+#include <QPointer>
+#include <QPair>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHostAddress>
+#include <QTimer>
+#include <QMutex>
+#include <atomic>
+#include <bitset>
+#include <functional>
+#include <memory>
+
+class QThread;
+class QUdpSocket;
+
+namespace super {
+
+class ControlPort;
+
+// ---------------------------------------------------------------------------
+// OscMessage — One decoded OSC message.
+// Arguments map to QVariant: i/h → int/qlonglong, f/d → double, s/S → QString,
+// b → QByteArray, T/F → bool, N/I → invalid QVariant.
+// ---------------------------------------------------------------------------
+struct OscMessage {
+	QByteArray address;
+	QVariantList args;
+};
+
+// ---------------------------------------------------------------------------
+// OscCodec — OSC 1.0 packet encoding / decoding.
+// decode_packet walks a datagram once, descending into nested bundles in
+// place; messages are handed to `sink` as they are reached.
+// ---------------------------------------------------------------------------
+namespace osc {
+
+bool decode_packet(const char *data, int size,
+				   const std::function<void(OscMessage &&)> &sink);
+
+void append_message(QByteArray &out, const QByteArray &address, const QVariantList &args);
+void begin_bundle(QByteArray &out);	// Immediate timetag
+void append_bundle_element(QByteArray &out, const QByteArray &message);
+
+} // namespace osc
+
+// ---------------------------------------------------------------------------
+// OscPattern — Precompiled OSC address pattern.
+// Supports ? (one char), * (run within a path segment), [abc] / [a-z] /
+// [!abc] character sets and {foo,bar} alternatives.
+// ---------------------------------------------------------------------------
+class OscPattern {
+public:
+	static bool is_pattern(const char *addr, int len);
+
+	bool compile(const QByteArray &pattern);
+	bool matches(const char *addr, int len) const;
+
+private:
+	struct Token {
+		enum Kind { Literal, AnyChar, AnySeq, CharSet, Alternatives } kind = Literal;
+		QByteArray text;
+		std::bitset<256> set;
+		bool negate = false;
+		QList<QByteArray> alts;
+	};
+	bool match_from(int ti, const char *addr, int len) const;
+
+	QVector<Token> m_tokens;
+};
+
+// ---------------------------------------------------------------------------
+// OscBinding — Maps an OSC address (or pattern) to a ControlPort.
+// Numeric arguments are mapped from [in_min, in_max] onto the port's range
+// when `scale` is set; other arguments are passed through unchanged.
+// ---------------------------------------------------------------------------
+struct OscBinding {
+	QString address;
+	QString port_id;
+	int arg_index = 0;
+	bool scale = true;
+	double in_min = 0.0;
+	double in_max = 1.0;
+	bool enabled = true;
+
+	QJsonObject to_json() const;
+	static OscBinding from_json(const QJsonObject &o);
+};
+
+// ---------------------------------------------------------------------------
+// OscOutput — Sends a port's value to an OSC address (feedback).
+// ---------------------------------------------------------------------------
+struct OscOutput {
+	QString port_id;
+	QString address;
+	bool scale = true;
+	double out_min = 0.0;
+	double out_max = 1.0;
+	bool enabled = true;
+
+	QJsonObject to_json() const;
+	static OscOutput from_json(const QJsonObject &o);
+};
+
+// ---------------------------------------------------------------------------
+// OscAddressTable — Immutable lookup snapshot shared with the socket thread.
+// Exact addresses hash straight to binding indices; bindings whose address
+// is a pattern are compiled once when the table is built.
+// ---------------------------------------------------------------------------
+struct OscAddressTable {
+	quint64 generation = 0;
+	QVector<OscBinding> bindings;
+	QHash<QByteArray, QVector<int>> exact;
+	QVector<QPair<OscPattern, QVector<int>>> patterns;
+
+	// Append indices of bindings matching `addr` to `out`. An incoming
+	// address that is itself a pattern is matched against exact entries.
+	void resolve(const char *addr, int len, QVector<int> &out) const;
+};
+
+// ---------------------------------------------------------------------------
+// OscAdapter
+//
+// The UDP socket lives on its own thread. Datagrams are decoded and resolved
+// there, queued as (binding, value) pairs, and drained on the owner thread
+// in one batch per event-loop pass. Feedback is collected per frame and
+// sent as a single bundle.
+// ---------------------------------------------------------------------------
+class OscAdapter : public QObject {
+	Q_OBJECT
+
+public:
+	explicit OscAdapter(QObject *parent = nullptr);
+	~OscAdapter() override;
+
+	// Socket
+	bool open(quint16 listen_port, const QHostAddress &bind = QHostAddress::AnyIPv4);
+	void close();
+	bool is_open() const;
+	quint16 listen_port() const;
+
+	// Feedback destination
+	void set_remote(const QHostAddress &host, quint16 port);
+	QHostAddress remote_host() const;
+	quint16 remote_port() const;
+
+	// Input bindings
+	void add_binding(const OscBinding &b);
+	void remove_binding(const QString &port_id);
+	void remove_all_bindings();
+	const QVector<OscBinding> &all_bindings() const;
+
+	// Output bindings (feedback)
+	void add_output(const OscOutput &o);
+	void remove_output(const QString &port_id);
+	void remove_all_outputs();
+	const QVector<OscOutput> &all_outputs() const;
+
+	// Send one message immediately (outside the feedback bundle).
+	void send(const QByteArray &address, const QVariantList &args);
+
+	// Diagnostics
+	quint64 packets_received() const { return m_packets_received.load(std::memory_order_relaxed); }
+	quint64 packets_dropped() const { return m_packets_dropped.load(std::memory_order_relaxed); }
+
+	// Persistence
+	QJsonObject save() const;
+	void load(const QJsonObject &obj);
+
+signals:
+	// Address with no binding (deduplicated per batch), for learn UIs.
+	void unmatched_message(const QString &address);
+	void opened(quint16 port);
+	void closed();
+
+private:
+	struct Inbound {
+		quint64 generation;
+		int binding;
+		QVariant value;
+	};
+
+	void rebuild_table();
+	void resolve_ports();
+	void connect_outputs();
+	void drain_inbound();
+	void on_datagrams();				// Socket thread
+	void queue_feedback(int output_index);
+	void flush_feedback();
+	void write_datagram(const QByteArray &bytes);
+
+	// Owner thread
+	QVector<OscBinding> m_bindings;
+	QVector<OscOutput> m_outputs;
+	QVector<QPointer<ControlPort>> m_ports;	// Aligned with table bindings
+	QList<QMetaObject::Connection> m_output_connections;
+	QSet<int> m_dirty_outputs;
+	QTimer *m_feedback_timer = nullptr;
+	QString m_echo_guard;				// Address being applied from input
+	quint64 m_generation = 0;
+	quint16 m_listen_port = 0;
+
+	// Shared with the socket thread
+	mutable QMutex m_mutex;
+	std::shared_ptr<const OscAddressTable> m_table;
+	QVector<Inbound> m_inbound;
+	QSet<QByteArray> m_unmatched;
+	QHostAddress m_remote_host = QHostAddress::LocalHost;
+	quint16 m_remote_port = 9000;
+	std::atomic<bool> m_drain_pending{false};
+	std::atomic<quint64> m_packets_received{0};
+	std::atomic<quint64> m_packets_dropped{0};
+
+	// Socket thread only
+	QThread *m_thread = nullptr;
+	QObject *m_io = nullptr;			// Context object living on m_thread
+	QUdpSocket *m_socket = nullptr;
+	QByteArray m_rx_buffer;
+	quint64 m_cache_generation = 0;
+	QHash<QByteArray, QVector<int>> m_resolve_cache;
+};
+
+} // namespace super
@@ -0,0 +1,530 @@
+// ============================================================================
+// Graph Workflow Engine — Audio-Rate Blocks
+// ============================================================================
+
+#include "audio_graph.hpp"
+#include "audio_nodes.hpp"
+#include "../../core/control_port.hpp"
+#include "../../core/control_registry.hpp"
+
+#include <obs-module.h>
+#include <media-io/audio-io.h>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cmath>
+
+namespace super {
+
+static constexpr double kTwoPi = 6.283185307179586;
+
+// Per-sample coefficient of a one-pole filter with time constant `ms`
+static inline double pole(double ms, double sample_rate)
+{
+	return ms > 0.0 ? std::exp(-1000.0 / (ms * sample_rate)) : 0.0;
+}
+
+// ===== AudioProgram — audio thread =========================================
+
+void AudioProgram::process(float *const *planes, int channels, quint32 frames, double sample_rate)
+{
+	for (quint32 offset = 0; offset < frames; offset += kMaxFrames) {
+		int n = static_cast<int>(qMin<quint32>(kMaxFrames, frames - offset));
+		run_block(planes, channels, static_cast<int>(offset), n, sample_rate);
+	}
+}
+
+void AudioProgram::run_block(float *const *planes, int channels, int offset, int n, double sample_rate)
+{
+	for (size_t k = 0; k < m_code.size(); k++) {
+		const Instr &in = m_code[k];
+		float *__restrict d = in.dst >= 0 ? buffer(in.dst) : nullptr;
+		const float *__restrict a = in.a >= 0 ? buffer(in.a) : nullptr;
+		const float *__restrict b = in.b >= 0 ? buffer(in.b) : nullptr;
+		double &state = m_state[k];
+
+		switch (in.op) {
+		case AudioOp::Input: {
+			const float scale = channels > 0 ? 1.0f / channels : 0.0f;
+			for (int i = 0; i < n; i++)
+				d[i] = 0.0f;
+			for (int c = 0; c < channels; c++) {
+				const float *__restrict s = planes[c] + offset;
+				for (int i = 0; i < n; i++)
+					d[i] += s[i];
+			}
+			for (int i = 0; i < n; i++)
+				d[i] *= scale;
+			break;
+		}
+		case AudioOp::Value: {
+			const double target = param(in.p[0]);
+			const double step = (target - state) / n;
+			for (int i = 0; i < n; i++)
+				d[i] = static_cast<float>(state + step * (i + 1));
+			state = target;
+			break;
+		}
+		case AudioOp::Lfo: {
+			const double inc = kTwoPi * param(in.p[0]) / sample_rate;
+			const float depth = param(in.p[1]);
+			const float center = param(in.p[2]);
+			double phase = state;
+			for (int i = 0; i < n; i++) {
+				d[i] = center + depth * static_cast<float>(std::sin(phase));
+				phase += inc;
+			}
+			state = std::fmod(phase, kTwoPi);
+			break;
+		}
+		case AudioOp::Envelope: {
+			const double att = pole(param(in.p[0]), sample_rate);
+			const double rel = pole(param(in.p[1]), sample_rate);
+			double env = state;
+			for (int i = 0; i < n; i++) {
+				const double x = std::fabs(a[i]);
+				const double c = x > env ? att : rel;
+				env = c * env + (1.0 - c) * x;
+				d[i] = static_cast<float>(env);
+			}
+			state = env;
+			break;
+		}
+		case AudioOp::Smooth: {
+			const double c = pole(param(in.p[0]), sample_rate);
+			double y = state;
+			for (int i = 0; i < n; i++) {
+				y = c * y + (1.0 - c) * a[i];
+				d[i] = static_cast<float>(y);
+			}
+			state = y;
+			break;
+		}
+		case AudioOp::Gate: {
+			const float thr = param(in.p[0]);
+			for (int i = 0; i < n; i++)
+				d[i] = a[i] > thr ? 1.0f : 0.0f;
+			break;
+		}
+		case AudioOp::Add:
+			for (int i = 0; i < n; i++)
+				d[i] = a[i] + b[i];
+			break;
+		case AudioOp::Mul:
+			for (int i = 0; i < n; i++)
+				d[i] = a[i] * b[i];
+			break;
+		case AudioOp::Map: {
+			const float scale = param(in.p[0]);
+			const float bias = param(in.p[1]);
+			for (int i = 0; i < n; i++)
+				d[i] = a[i] * scale + bias;
+			break;
+		}
+		case AudioOp::Gain:
+			for (int c = 0; c < channels; c++) {
+				float *__restrict s = planes[c] + offset;
+				for (int i = 0; i < n; i++)
+					s[i] *= a[i];
+			}
+			break;
+		case AudioOp::Publish:
+			set_param(in.p[0], a[n - 1]);
+			break;
+		}
+	}
+}
+
+// ===== AudioGraph ==========================================================
+
+AudioGraph::AudioGraph(QObject *parent) : QObject(parent), m_poll_timer(this)
+{
+	// Started by set_stages(), which runs on the thread the graph lives on
+	m_poll_timer.setInterval(33);
+	connect(&m_poll_timer, &QTimer::timeout, this, [this]() {
+		reclaim();
+		poll_outputs();
+	});
+}
+
+AudioGraph::~AudioGraph()
+{
+	// The filter is gone, so the audio thread no longer runs process()
+	auto drop = [](AudioProgram *p) {
+		if (!p)
+			return;
+		for (const auto &c : std::as_const(p->m_bindings))
+			QObject::disconnect(c);
+		delete p;
+	};
+	drop(m_pending.exchange(nullptr));
+	drop(m_retired.exchange(nullptr));
+	drop(m_active);
+}
+
+void AudioGraph::process(float *const *planes, int channels, quint32 frames, double sample_rate)
+{
+	// Swap in a new program only once the previous retiree was collected,
+	// so the audio thread never has to free anything.
+	if (m_retired.load(std::memory_order_acquire) == nullptr) {
+		if (AudioProgram *next = m_pending.exchange(nullptr, std::memory_order_acq_rel)) {
+			if (m_active)
+				m_retired.store(m_active, std::memory_order_release);
+			m_active = next;
+		}
+	}
+	if (m_active)
+		m_active->process(planes, channels, frames, sample_rate);
+}
+
+void AudioGraph::reclaim()
+{
+	AudioProgram *old = m_retired.exchange(nullptr, std::memory_order_acq_rel);
+	if (!old)
+		return;
+	for (const auto &c : std::as_const(old->m_bindings))
+		QObject::disconnect(c);
+	delete old;
+}
+
+void AudioGraph::poll_outputs()
+{
+	if (!m_latest)
+		return;
+	for (auto &o : m_latest->m_outputs) {
+		float v = m_latest->param(o.slot);
+		if (o.port && v != o.last) {
+			o.last = v;
+			o.port->set_value(static_cast<double>(v));
+		}
+	}
+}
+
+bool AudioGraph::set_stages(const QJsonArray &stages, QString *error)
+{
+	std::unique_ptr<AudioProgram> prog = compile(stages, error);
+	if (!prog)
+		return false;
+
+	m_latest = prog.get();
+	AudioProgram *unused = m_pending.exchange(prog.release(), std::memory_order_acq_rel);
+	if (unused) {
+		// Never reached the audio thread
+		for (const auto &c : std::as_const(unused->m_bindings))
+			QObject::disconnect(c);
+		delete unused;
+	}
+	if (!m_poll_timer.isActive())
+		m_poll_timer.start();
+	return true;
+}
+
+bool AudioGraph::set_graph(GraphEngine &engine, const QString &bus, QString *error)
+{
+	const QJsonArray stages = lower(engine, bus, error);
+	return !stages.isEmpty() && set_stages(stages, error);
+}
+
+// ---------------------------------------------------------------------------
+// Lower: block nodes of one bus → stage list. The plan is already in
+// topological order, so every signal source gets its stage index before
+// the nodes reading it.
+// ---------------------------------------------------------------------------
+
+QJsonArray AudioGraph::lower(GraphEngine &engine, const QString &bus, QString *error)
+{
+	auto fail = [error](const GraphNode *node, const QString &msg) {
+		if (error)
+			*error = QString("%1: %2").arg(node->display_name(), msg);
+		return QJsonArray();
+	};
+
+	const ExecutionPlan &plan = engine.plan();
+	QHash<QPair<QUuid, QString>, Connection> wire_to;
+	for (const Connection &c : engine.connections())
+		wire_to.insert({c.target_node, c.target_pin}, c);
+
+	QHash<QUuid, int> stage_of;
+	QJsonArray stages;
+	for (GraphNode *node : plan.order) {
+		auto *block = qobject_cast<AudioBlockNode *>(node);
+		if (!block || block->bus() != bus)
+			continue;
+
+		QJsonObject st{{"op", QString::fromLatin1(block->stage_op())}};
+
+		QJsonArray in;
+		for (int pin : block->signal_inputs()) {
+			const QString &pin_id = block->pin(pin).id;
+			auto it = wire_to.constFind({block->node_id(), pin_id});
+			if (it == wire_to.constEnd())
+				return fail(block, QString("signal input '%1' is not connected").arg(pin_id));
+			const int src = stage_of.value(it->source_node, -1);
+			if (src < 0 || it->delayed)
+				return fail(block, QString("signal input '%1' must come from a block node on bus '%2'")
+					.arg(pin_id, bus));
+			in.append(src);
+		}
+		if (!in.isEmpty())
+			st["in"] = in;
+
+		QJsonArray params;
+		for (int pin : block->param_inputs()) {
+			const Pin &p = block->pin(pin);
+			auto it = wire_to.constFind({block->node_id(), p.id});
+			if (it == wire_to.constEnd()) {
+				params.append(p.value.number);
+				continue;
+			}
+			GraphNode *src = engine.find_node(it->source_node);
+			if (src && src->type_id() == "constant") {
+				params.append(src->state()["value"].toDouble());
+			} else if (src && src->type_id() == "port_read") {
+				params.append(QJsonObject{{"port", src->state()["port"].toString()},
+										  {"default", p.value.number}});
+			} else {
+				return fail(block, QString("parameter '%1' must be a value, a Constant or a Read Port")
+					.arg(p.id));
+			}
+		}
+		if (!params.isEmpty())
+			st["params"] = params;
+
+		if (auto *pub = qobject_cast<AudioPublishNode *>(block))
+			st["port"] = pub->port_id();
+
+		if (block->signal_output() >= 0)
+			stage_of.insert(block->node_id(), stages.size());
+		stages.append(st);
+	}
+
+	if (stages.isEmpty() && error)
+		*error = QString("No audio nodes on bus '%1'").arg(bus);
+	return stages;
+}
+
+// ---------------------------------------------------------------------------
+// Compile: resolve op names, stage references and parameter slots.
+// ---------------------------------------------------------------------------
+
+std::unique_ptr<AudioProgram> AudioGraph::compile(const QJsonArray &stages, QString *error)
+{
+	struct OpInfo { AudioOp op; int inputs; int params; bool writes; };
+	static const QHash<QString, OpInfo> ops = {
+		{"input",    {AudioOp::Input,    0, 0, true}},
+		{"value",    {AudioOp::Value,    0, 1, true}},
+		{"lfo",      {AudioOp::Lfo,      0, 3, true}},
+		{"envelope", {AudioOp::Envelope, 1, 2, true}},
+		{"smooth",   {AudioOp::Smooth,   1, 1, true}},
+		{"gate",     {AudioOp::Gate,     1, 1, true}},
+		{"add",      {AudioOp::Add,      2, 0, true}},
+		{"mul",      {AudioOp::Mul,      2, 0, true}},
+		{"map",      {AudioOp::Map,      1, 2, true}},
+		{"gain",     {AudioOp::Gain,     1, 0, false}},
+		{"publish",  {AudioOp::Publish,  1, 0, false}},
+	};
+
+	auto fail = [error](int stage, const QString &msg) {
+		if (error)
+			*error = QString("Stage %1: %2").arg(stage).arg(msg);
+		return nullptr;
+	};
+
+	auto prog = std::make_unique<AudioProgram>();
+	struct Slot { float init; QString port; };
+	QVector<Slot> slots;
+	auto add_slot = [&](const QJsonValue &v) {
+		if (v.isObject()) {
+			QJsonObject o = v.toObject();
+			slots.append({static_cast<float>(o["default"].toDouble()), o["port"].toString()});
+		} else {
+			slots.append({static_cast<float>(v.toDouble()), QString()});
+		}
+		return slots.size() - 1;
+	};
+
+	QVector<int> buffer_of(stages.size(), -1);
+	int buffers = 0;
+	QVector<int> publish_slots;
+	QStringList publish_ports;
+
+	for (int s = 0; s < stages.size(); s++) {
+		const QJsonObject st = stages[s].toObject();
+		auto it = ops.constFind(st["op"].toString());
+		if (it == ops.constEnd())
+			return fail(s, QString("unknown op '%1'").arg(st["op"].toString()));
+		const OpInfo &info = it.value();
+
+		AudioProgram::Instr in{info.op, -1, -1, -1, {-1, -1, -1}};
+		const QJsonArray inputs = st["in"].toArray();
+		if (inputs.size() < info.inputs)
+			return fail(s, QString("needs %1 input(s)").arg(info.inputs));
+		for (int i = 0; i < info.inputs; i++) {
+			int src = inputs[i].toInt(-1);
+			if (src < 0 || src >= s || buffer_of[src] < 0)
+				return fail(s, QString("input %1 must name an earlier stage with output").arg(i));
+			(i == 0 ? in.a : in.b) = buffer_of[src];
+		}
+
+		const QJsonArray params = st["params"].toArray();
+		for (int i = 0; i < info.params; i++)
+			in.p[i] = add_slot(i < params.size() ? params[i] : QJsonValue(0.0));
+
+		if (info.op == AudioOp::Publish) {
+			in.p[0] = add_slot(0.0);
+			publish_slots.append(in.p[0]);
+			publish_ports.append(st["port"].toString());
+		}
+		if (info.writes) {
+			in.dst = buffers++;
+			buffer_of[s] = in.dst;
+		}
+		prog->m_code.push_back(in);
+	}
+
+	prog->m_buffers.assign(size_t(buffers) * AudioProgram::kMaxFrames, 0.0f);
+	prog->m_state.assign(prog->m_code.size(), 0.0);
+	prog->m_param_count = slots.size();
+	prog->m_params.reset(new std::atomic<float>[qMax(1, int(slots.size()))]);
+
+	// Seed and bind parameters (Qt thread; the program isn't published yet)
+	auto &registry = ControlRegistry::instance();
+	AudioProgram *raw = prog.get();
+	for (int i = 0; i < slots.size(); i++) {
+		float init = slots[i].init;
+		if (!slots[i].port.isEmpty()) {
+			if (ControlPort *port = registry.find(slots[i].port)) {
+				init = static_cast<float>(port->as_double());
+				prog->m_bindings.append(connect(port, &ControlPort::value_changed, this,
+					[raw, i, port]() { raw->set_param(i, static_cast<float>(port->as_double())); }));
+			}
+		}
+		prog->set_param(i, init);
+	}
+	for (int k = 0; k < publish_slots.size(); k++)
+		prog->m_outputs.append({publish_slots[k], registry.find(publish_ports[k]), 0.0f});
+
+	// Value ramps start at their initial value instead of sweeping from 0
+	for (size_t k = 0; k < prog->m_code.size(); k++)
+		if (prog->m_code[k].op == AudioOp::Value)
+			prog->m_state[k] = prog->param(prog->m_code[k].p[0]);
+
+	return prog;
+}
+
+// ===== OBS filter ==========================================================
+
+struct AudioGraphFilter {
+	AudioGraph *graph;
+	double sample_rate;
+	int channels;
+};
+
+// A saved GraphEngine ("graph") takes precedence over a raw stage list
+static void apply_settings(AudioGraphFilter *f, obs_data_t *settings)
+{
+	QByteArray stages = obs_data_get_string(settings, "stages");
+	QByteArray saved = obs_data_get_string(settings, "graph");
+	QString bus = QString::fromUtf8(obs_data_get_string(settings, "bus"));
+	AudioGraph *graph = f->graph;
+	// Port bindings must be made on the graph's (Qt) thread
+	QMetaObject::invokeMethod(graph, [graph, stages, saved, bus]() {
+		QString err;
+		bool ok;
+		if (!saved.trimmed().isEmpty()) {
+			// Only lowered, never evaluated
+			GraphEngine engine;
+			engine.set_schedule({GraphTrigger::Manual});
+			engine.load(QJsonDocument::fromJson(saved).object());
+			ok = graph->set_graph(engine, bus, &err);
+		} else {
+			ok = graph->set_stages(QJsonDocument::fromJson(stages).array(), &err);
+		}
+		if (!ok)
+			blog(LOG_WARNING, "[Super Audio Graph] %s", err.toUtf8().constData());
+	});
+}
+
+static void *audio_graph_create(obs_data_t *settings, obs_source_t *context)
+{
+	UNUSED_PARAMETER(context);
+	auto *f = new AudioGraphFilter();
+	f->graph = new AudioGraph();
+	if (QCoreApplication::instance())
+		f->graph->moveToThread(QCoreApplication::instance()->thread());
+	f->sample_rate = audio_output_get_sample_rate(obs_get_audio());
+	f->channels = static_cast<int>(audio_output_get_channels(obs_get_audio()));
+	apply_settings(f, settings);
+	return f;
+}
+
+static void audio_graph_destroy(void *data)
+{
+	auto *f = static_cast<AudioGraphFilter *>(data);
+	f->graph->deleteLater();
+	delete f;
+}
+
+static void audio_graph_update(void *data, obs_data_t *settings)
+{
+	apply_settings(static_cast<AudioGraphFilter *>(data), settings);
+}
+
+static struct obs_audio_data *audio_graph_filter_audio(void *data, struct obs_audio_data *audio)
+{
+	auto *f = static_cast<AudioGraphFilter *>(data);
+	float *planes[MAX_AV_PLANES];
+	int channels = qMin(f->channels, int(MAX_AV_PLANES));
+	for (int c = 0; c < channels; c++) {
+		planes[c] = reinterpret_cast<float *>(audio->data[c]);
+		if (!planes[c]) {
+			channels = c;
+			break;
+		}
+	}
+	f->graph->process(planes, channels, audio->frames, f->sample_rate);
+	return audio;
+}
+
+static const char *audio_graph_get_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "Super Audio Graph";
+}
+
+static obs_properties_t *audio_graph_properties(void *data)
+{
+	UNUSED_PARAMETER(data);
+	obs_properties_t *props = obs_properties_create();
+	obs_properties_add_text(props, "stages", "Stages (JSON)", OBS_TEXT_MULTILINE);
+	obs_properties_add_text(props, "graph", "Graph (JSON, overrides stages)", OBS_TEXT_MULTILINE);
+	obs_properties_add_text(props, "bus", "Audio Bus", OBS_TEXT_DEFAULT);
+	return props;
+}
+
+static void audio_graph_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_string(settings, "bus", "main");
+}
+
+void register_audio_graph_filter()
+{
+	struct obs_source_info info = {};
+	info.id = "super_audio_graph_filter";
+	info.type = OBS_SOURCE_TYPE_FILTER;
+	info.version = 0x00000001;
+	info.output_flags = OBS_SOURCE_AUDIO;
+	info.create = audio_graph_create;
+	info.destroy = audio_graph_destroy;
+	info.update = audio_graph_update;
+	info.get_name = audio_graph_get_name;
+	info.get_properties = audio_graph_properties;
+	info.get_defaults = audio_graph_defaults;
+	info.filter_audio = audio_graph_filter_audio;
+
+	obs_register_source(&info);
+}
+
+} // namespace super
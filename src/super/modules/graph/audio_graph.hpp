@@ -0,0 +1,146 @@
+#pragma once
+
+// ============================================================================
+// Graph Workflow Engine — Audio-Rate Blocks
+// A small block-processing program that runs inside an OBS audio filter, for
+// modulation that must be sample accurate (ducking curves, LFO tremolo,
+// gates). Parameters are exchanged with ControlRegistry through atomics; the
+// audio thread never allocates, locks or touches a QObject.
+// ============================================================================
+
+#include <QJsonArray>
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace super {
+
+class ControlPort;
+class GraphEngine;
+
+// ---------------------------------------------------------------------------
+// AudioOp — Block instructions. Each writes one block buffer (dst) from
+// earlier buffers (a, b) and parameter slots (p0..p2).
+// ---------------------------------------------------------------------------
+enum class AudioOp : quint8 {
+	Input,		// dst = mono mix of the filter's input channels
+	Value,		// dst = p0, ramped across the block to avoid zipper noise
+	Lfo,		// dst = p2 + p1 * sin(phase), p0 = rate in Hz
+	Envelope,	// dst = peak follower of a, p0 = attack ms, p1 = release ms
+	Smooth,		// dst = one-pole lowpass of a, p0 = time constant ms
+	Gate,		// dst = a > p0 ? 1 : 0
+	Add,		// dst = a + b
+	Mul,		// dst = a * b
+	Map,		// dst = a * p0 + p1
+	Gain,		// Every channel *= a (no dst)
+	Publish,	// Slot p0 = last sample of a, read back on the Qt thread
+};
+
+// ---------------------------------------------------------------------------
+// AudioProgram — One compiled stage list plus its buffers and state, all
+// sized at compile time. Owned by the Qt thread until published, then by
+// the audio thread until retired.
+// ---------------------------------------------------------------------------
+class AudioProgram {
+public:
+	static constexpr int kMaxFrames = 1024;	// OBS AUDIO_OUTPUT_FRAMES
+
+	struct Instr {
+		AudioOp op;
+		int dst;		// Buffer index, -1 for Gain / Publish
+		int a, b;		// Buffer indices, -1 if unused
+		int p[3];		// Parameter slots, -1 if unused
+	};
+
+	// Audio thread. `planes` are processed in place.
+	void process(float *const *planes, int channels, quint32 frames, double sample_rate);
+
+	int param_count() const { return m_param_count; }
+	float param(int slot) const { return m_params[slot].load(std::memory_order_relaxed); }
+	void set_param(int slot, float v) { m_params[slot].store(v, std::memory_order_relaxed); }
+
+private:
+	friend class AudioGraph;
+
+	void run_block(float *const *planes, int channels, int offset, int n, double sample_rate);
+	float *buffer(int index) { return m_buffers.data() + size_t(index) * kMaxFrames; }
+
+	std::vector<Instr> m_code;
+	std::vector<float> m_buffers;	// Stage count × kMaxFrames
+	std::vector<double> m_state;	// Per instruction: phase / envelope / filter memory
+	std::unique_ptr<std::atomic<float>[]> m_params;
+	int m_param_count = 0;
+
+	// Qt thread only
+	QVector<QMetaObject::Connection> m_bindings;
+	struct Output { int slot; QPointer<ControlPort> port; float last; };
+	QVector<Output> m_outputs;
+};
+
+// ---------------------------------------------------------------------------
+// AudioGraph — Qt-side owner of the program an audio filter runs.
+//
+// Programs come from a stage list, or from a GraphEngine subgraph:
+// set_graph() lowers the block nodes (audio_nodes.hpp) of one bus to a
+// stage list first. Their parameter pins may be left at a value, or wired
+// from a Constant or a Read Port node, which becomes a port-bound parameter.
+//
+// Stages are a JSON array evaluated in order; stage i writes buffer i and
+// may only read earlier stages, so a stage list is already a topological
+// order and cannot contain cycles:
+//
+//   [ {"op": "input"},
+//     {"op": "envelope", "in": [0], "params": [5, 250]},
+//     {"op": "map", "in": [1], "params": [-2, 1]},
+//     {"op": "smooth", "in": [2], "params": [{"port": "duck.time", "default": 20}]},
+//     {"op": "gain", "in": [3]},
+//     {"op": "publish", "in": [3], "port": "duck.level"} ]
+//
+// A parameter is a number or {"port": id, "default": x}; port-bound
+// parameters follow the port's value_changed. Publishing is polled at
+// ~30 Hz and written to the port only when it moves.
+//
+// Programs change hands through two atomic pointers: set_stages() offers
+// one in `pending`, the audio thread swaps it in at a block boundary and
+// hands the old one back through `retired`, which the Qt thread deletes.
+// ---------------------------------------------------------------------------
+class AudioGraph : public QObject {
+	Q_OBJECT
+
+public:
+	explicit AudioGraph(QObject *parent = nullptr);
+	~AudioGraph() override;
+
+	// Qt thread. On failure the running program is kept.
+	bool set_stages(const QJsonArray &stages, QString *error = nullptr);
+	bool set_graph(GraphEngine &engine, const QString &bus, QString *error = nullptr);
+
+	// Stage list for the block nodes of `bus`, in plan order. Empty (and
+	// `error` set) if the subgraph can't run at block rate.
+	static QJsonArray lower(GraphEngine &engine, const QString &bus, QString *error = nullptr);
+
+	// Audio thread.
+	void process(float *const *planes, int channels, quint32 frames, double sample_rate);
+
+private:
+	std::unique_ptr<AudioProgram> compile(const QJsonArray &stages, QString *error);
+	void reclaim();
+	void poll_outputs();
+
+	std::atomic<AudioProgram *> m_pending{nullptr};
+	std::atomic<AudioProgram *> m_retired{nullptr};
+	AudioProgram *m_active = nullptr;		// Audio thread only
+	AudioProgram *m_latest = nullptr;		// Last published (Qt thread view)
+	QTimer m_poll_timer;
+};
+
+// Registers the "Super Audio Graph" filter with OBS.
+void register_audio_graph_filter();
+
+} // namespace super
@@ -0,0 +1,229 @@
+#pragma once
+
+// ============================================================================
+// Audio Node Library — Block-rate graph nodes.
+// These describe a subgraph that AudioGraph lowers into an AudioProgram and
+// runs inside an OBS audio filter. At control rate they do nothing: their
+// "signal" pins only carry structure, one sample block per wire.
+// ============================================================================
+
+#include "graph_node.hpp"
+#include "graph_compiler.hpp"
+
+namespace super {
+
+// ---------------------------------------------------------------------------
+// AudioBlockNode — Base for block nodes.
+// Every block node belongs to a bus; AudioGraph::set_graph() lowers the
+// nodes of one bus. Inputs are either signals (wired from another block
+// node) or parameters (a constant, a Read Port node, or the pin's value).
+// ---------------------------------------------------------------------------
+class AudioBlockNode : public GraphNode {
+	Q_OBJECT
+public:
+	const QString &bus() const { return m_bus; }
+	void set_bus(const QString &bus) { m_bus = bus; }
+
+	// AudioGraph stage op ("lfo", "envelope", ...)
+	const char *stage_op() const { return m_op; }
+	const QVector<int> &signal_inputs() const { return m_signals; }
+	const QVector<int> &param_inputs() const { return m_params; }
+	int signal_output() const { return m_out; }
+
+	QJsonObject state() const override { return {{"bus", m_bus}}; }
+
+	bool is_pure() const override { return true; }
+	void process() override {}
+	bool lower(GraphCodegen &) const override { return true; }
+
+protected:
+	AudioBlockNode(const QString &type_id, const char *op, const QJsonObject &state,
+				   QObject *parent)
+		: GraphNode(type_id, parent), m_bus(state["bus"].toString("main")), m_op(op)
+	{}
+
+	void add_signal_input(const QString &id, const QString &label) {
+		m_signals.append(add_input(id, label, PinType::Number, 0.0));
+	}
+	void add_param(const QString &id, const QString &label, double default_val) {
+		m_params.append(add_input(id, label, PinType::Number, default_val));
+	}
+	void add_signal_output() { m_out = add_output("signal", "Signal", PinType::Number); }
+
+private:
+	QString m_bus;
+	const char *m_op;
+	QVector<int> m_signals;
+	QVector<int> m_params;
+	int m_out = -1;
+};
+
+// ---------------------------------------------------------------------------
+// AudioInputNode — Mono mix of the filter's input channels.
+// ---------------------------------------------------------------------------
+class AudioInputNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioInputNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_input", "input", state, parent)
+	{
+		add_signal_output();
+		set_display_name("Audio Input");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioLfoNode — Sine LFO: center + depth * sin(2π · rate · t).
+// ---------------------------------------------------------------------------
+class AudioLfoNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioLfoNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_lfo", "lfo", state, parent)
+	{
+		add_param("rate", "Rate (Hz)", 1.0);
+		add_param("depth", "Depth", 0.5);
+		add_param("center", "Center", 0.5);
+		add_signal_output();
+		set_display_name("LFO");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioEnvelopeNode — Peak envelope follower.
+// ---------------------------------------------------------------------------
+class AudioEnvelopeNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioEnvelopeNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_envelope", "envelope", state, parent)
+	{
+		add_signal_input("input", "Input");
+		add_param("attack", "Attack (ms)", 5.0);
+		add_param("release", "Release (ms)", 250.0);
+		add_signal_output();
+		set_display_name("Envelope Follower");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioSmoothNode — One-pole lowpass, for de-zippering control signals.
+// ---------------------------------------------------------------------------
+class AudioSmoothNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioSmoothNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_smooth", "smooth", state, parent)
+	{
+		add_signal_input("input", "Input");
+		add_param("time", "Time (ms)", 20.0);
+		add_signal_output();
+		set_display_name("Block Smooth");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioGateNode — 1 while the input is above the threshold, else 0.
+// ---------------------------------------------------------------------------
+class AudioGateNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioGateNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_gate", "gate", state, parent)
+	{
+		add_signal_input("input", "Input");
+		add_param("threshold", "Threshold", 0.1);
+		add_signal_output();
+		set_display_name("Block Gate");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioMapNode — input * scale + offset.
+// ---------------------------------------------------------------------------
+class AudioMapNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioMapNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_map", "map", state, parent)
+	{
+		add_signal_input("input", "Input");
+		add_param("scale", "Scale", 1.0);
+		add_param("offset", "Offset", 0.0);
+		add_signal_output();
+		set_display_name("Block Map");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioMathNode — Sample-wise A + B or A * B.
+// ---------------------------------------------------------------------------
+class AudioMathNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	enum Op { Add, Multiply };
+
+	explicit AudioMathNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_math", state["op"].toInt() == Multiply ? "mul" : "add",
+						 state, parent),
+		  m_op(state["op"].toInt() == Multiply ? Multiply : Add)
+	{
+		add_signal_input("a", "A");
+		add_signal_input("b", "B");
+		add_signal_output();
+		set_display_name(m_op == Multiply ? "Block Multiply" : "Block Add");
+	}
+
+	QJsonObject state() const override {
+		QJsonObject s = AudioBlockNode::state();
+		s["op"] = int(m_op);
+		return s;
+	}
+
+private:
+	Op m_op;
+};
+
+// ---------------------------------------------------------------------------
+// AudioGainNode — Multiplies every channel of the filter's audio by the
+// gain signal. A sink: the point of most audio subgraphs.
+// ---------------------------------------------------------------------------
+class AudioGainNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioGainNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_gain", "gain", state, parent)
+	{
+		add_signal_input("gain", "Gain");
+		set_display_name("Apply Gain");
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AudioPublishNode — Writes the signal's last sample of each block to a
+// ControlPort (~30 Hz, only when it moves), e.g. for a ducking meter.
+// ---------------------------------------------------------------------------
+class AudioPublishNode : public AudioBlockNode {
+	Q_OBJECT
+public:
+	explicit AudioPublishNode(const QJsonObject &state = {}, QObject *parent = nullptr)
+		: AudioBlockNode("audio_publish", "publish", state, parent),
+		  m_port_id(state["port"].toString())
+	{
+		add_signal_input("input", "Input");
+		set_display_name("Publish: " + m_port_id);
+	}
+
+	const QString &port_id() const { return m_port_id; }
+
+	QJsonObject state() const override {
+		QJsonObject s = AudioBlockNode::state();
+		s["port"] = m_port_id;
+		return s;
+	}
+
+private:
+	QString m_port_id;
+};
+
+} // namespace super
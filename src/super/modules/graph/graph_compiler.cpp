@@ -0,0 +1,225 @@
+// ============================================================================
+// Graph Workflow Engine — Bytecode Compiler / VM
+// ============================================================================
+
+#include "graph_compiler.hpp"
+#include "graph_node.hpp"
+
+#include <QHash>
+#include <QtMath>
+#include <utility>
+
+namespace super {
+
+// ===== GraphCodegen =======================================================
+
+int GraphCodegen::reg(int pin) const
+{
+	return (*m_pin_regs)[pin];
+}
+
+void GraphCodegen::emit(GraphOp op, int dst, int a, int b, int c, int d, int e)
+{
+	m_prog.m_code.append({op, dst, a, b, c, d, e});
+}
+
+// ===== GraphProgram — Compile =============================================
+
+int GraphProgram::alloc(double init)
+{
+	m_regs.append(init);
+	return m_regs.size() - 1;
+}
+
+std::unique_ptr<GraphProgram> GraphProgram::compile(GraphEngine &engine, QString *error)
+{
+	const ExecutionPlan &plan = engine.plan();
+	auto prog = std::unique_ptr<GraphProgram>(new GraphProgram());
+
+	for (const auto &e : plan.edges) {
+		if (!e.numeric) {
+			if (error)
+				*error = QString("Connection into '%1' is not numeric").arg(e.target->id);
+			return nullptr;
+		}
+	}
+	for (const auto &d : plan.delays) {
+		if (!d.numeric) {
+			if (error)
+				*error = QString("Delayed connection into '%1' is not numeric").arg(d.target->id);
+			return nullptr;
+		}
+	}
+
+	// Every numeric output pin gets a register, seeded with its value
+	QHash<const Pin *, int> out_reg;
+	for (GraphNode *node : plan.order) {
+		for (const Pin &p : node->pins())
+			if (p.is_output() && p.is_numeric())
+				out_reg.insert(&p, prog->alloc(p.value.number));
+	}
+
+	// Delay targets get a register that run() refreshes from the source
+	QHash<const Pin *, int> delay_reg;
+	for (const auto &d : plan.delays) {
+		int r = delay_reg.value(d.target, -1);
+		if (r < 0) {
+			r = prog->alloc(d.target->value.number);
+			delay_reg.insert(d.target, r);
+		}
+		prog->m_latches.append({out_reg.value(d.source), r});
+	}
+
+	GraphCodegen gen(*prog);
+	QVector<int> pin_regs;
+	QVector<Bind> seeds;
+	for (int rank = 0; rank < plan.order.size(); rank++) {
+		GraphNode *node = plan.order[rank];
+		const QList<Pin> &pins = node->pins();
+
+		// Resolve this node's pins to registers (-1: non-numeric)
+		pin_regs.fill(-1, pins.size());
+		seeds.clear();
+		for (int i = 0; i < pins.size(); i++) {
+			const Pin &p = pins[i];
+			if (!p.is_numeric())
+				continue;
+			if (p.is_output()) {
+				pin_regs[i] = out_reg.value(&p);
+				continue;
+			}
+			// Last connection wins, matching interpreted evaluation
+			for (int k = plan.edge_begin[rank]; k < plan.edge_begin[rank + 1]; k++)
+				if (plan.edges[k].target == &p)
+					pin_regs[i] = out_reg.value(plan.edges[k].source);
+			if (pin_regs[i] < 0)
+				pin_regs[i] = delay_reg.value(&p, -1);
+			if (pin_regs[i] < 0) {
+				// Unconnected: the pin can still be written (graph_set, the
+				// editor), so run() re-reads it rather than baking it in
+				pin_regs[i] = prog->alloc(p.value.number);
+				seeds.append({pin_regs[i], const_cast<Pin *>(&p)});
+			}
+		}
+
+		gen.m_node = node;
+		gen.m_pin_regs = &pin_regs;
+		int code_size = prog->m_code.size();
+		if (node->lower(gen)) {
+			prog->m_seeds.append(seeds);
+			for (int i = 0; i < pins.size(); i++)
+				if (pins[i].is_output() && pin_regs[i] >= 0)
+					prog->m_outputs.append({node, i, pin_regs[i]});
+			continue;
+		}
+		prog->m_code.resize(code_size);	// Drop anything a refusing node emitted
+
+		// Trampoline
+		Call call;
+		call.node = node;
+		call.in_begin = prog->m_binds.size();
+		for (int i = 0; i < pins.size(); i++) {
+			auto it = delay_reg.constFind(&pins[i]);
+			if (it != delay_reg.constEnd())
+				prog->m_binds.append({it.value(), const_cast<Pin *>(&pins[i])});
+		}
+		for (int k = plan.edge_begin[rank]; k < plan.edge_begin[rank + 1]; k++) {
+			const auto &e = plan.edges[k];
+			prog->m_binds.append({out_reg.value(e.source), e.target});
+		}
+
+		call.in_end = call.out_begin = prog->m_binds.size();
+		for (int i = 0; i < pins.size(); i++)
+			if (pins[i].is_output() && pin_regs[i] >= 0)
+				prog->m_binds.append({pin_regs[i], const_cast<Pin *>(&pins[i])});
+		call.out_end = prog->m_binds.size();
+		prog->m_code.append({GraphOp::Call, 0, static_cast<int>(prog->m_calls.size()), 0, 0, 0, 0});
+		prog->m_calls.append(call);
+	}
+
+	prog->m_code.squeeze();
+	return prog;
+}
+
+// ===== GraphProgram — VM ==================================================
+
+bool GraphProgram::run()
+{
+	double *R = m_regs.data();
+	bool again = false;
+
+	for (const Bind &b : std::as_const(m_seeds))
+		R[b.reg] = b.pin->value.number;
+	for (const Latch &l : std::as_const(m_latches))
+		R[l.target] = R[l.source];
+
+	for (const Instr &in : std::as_const(m_code)) {
+		if (in.op == GraphOp::Call) {
+			const Call &c = m_calls[in.a];
+			for (int k = c.in_begin; k < c.in_end; k++)
+				m_binds[k].pin->value.number = R[m_binds[k].reg];
+			c.node->process();
+			for (int k = c.out_begin; k < c.out_end; k++)
+				R[m_binds[k].reg] = m_binds[k].pin->value.number;
+			continue;
+		}
+
+		double &d = R[in.dst];
+		const double a = R[in.a];
+		switch (in.op) {
+		case GraphOp::Add: d = a + R[in.b]; break;
+		case GraphOp::Sub: d = a - R[in.b]; break;
+		case GraphOp::Mul: d = a * R[in.b]; break;
+		case GraphOp::Div: d = qFuzzyIsNull(R[in.b]) ? 0.0 : a / R[in.b]; break;
+		case GraphOp::Pow: d = qPow(a, R[in.b]); break;
+		case GraphOp::Mod: d = qFuzzyIsNull(R[in.b]) ? 0.0 : std::fmod(a, R[in.b]); break;
+		case GraphOp::Min: d = qMin(a, R[in.b]); break;
+		case GraphOp::Max: d = qMax(a, R[in.b]); break;
+		case GraphOp::Eq:  d = qFuzzyCompare(a, R[in.b]) ? 1.0 : 0.0; break;
+		case GraphOp::Ne:  d = qFuzzyCompare(a, R[in.b]) ? 0.0 : 1.0; break;
+		case GraphOp::Lt:  d = a < R[in.b] ? 1.0 : 0.0; break;
+		case GraphOp::Gt:  d = a > R[in.b] ? 1.0 : 0.0; break;
+		case GraphOp::Le:  d = a <= R[in.b] ? 1.0 : 0.0; break;
+		case GraphOp::Ge:  d = a >= R[in.b] ? 1.0 : 0.0; break;
+		case GraphOp::And: d = (a != 0.0 && R[in.b] != 0.0) ? 1.0 : 0.0; break;
+		case GraphOp::Or:  d = (a != 0.0 || R[in.b] != 0.0) ? 1.0 : 0.0; break;
+		case GraphOp::Not: d = a != 0.0 ? 0.0 : 1.0; break;
+		case GraphOp::Xor: d = ((a != 0.0) != (R[in.b] != 0.0)) ? 1.0 : 0.0; break;
+		case GraphOp::Select: d = a != 0.0 ? R[in.b] : R[in.c]; break;
+		case GraphOp::Clamp:  d = qBound(R[in.b], a, R[in.c]); break;
+		case GraphOp::MapRange: {
+			double span = R[in.c] - R[in.b];
+			d = qFuzzyIsNull(span) ? R[in.d]
+				: R[in.d] + (a - R[in.b]) / span * (R[in.e] - R[in.d]);
+			break;
+		}
+		case GraphOp::Smooth: {
+			double alpha = qBound(0.0, R[in.b], 1.0);
+			double v = alpha * d + (1.0 - alpha) * a;
+			if (std::abs(v - a) < 1e-6)
+				v = a;
+			else if (alpha < 1.0)
+				again = true;
+			d = v;
+			break;
+		}
+		case GraphOp::Call:
+			break;
+		}
+	}
+
+	// A delay source that moved feeds the next run
+	for (const Latch &l : std::as_const(m_latches))
+		if (R[l.target] != R[l.source])
+			again = true;
+	return again;
+}
+
+void GraphProgram::write_back()
+{
+	for (const Output &o : std::as_const(m_outputs))
+		if (o.node->m_observed)
+			o.node->set_output_number(o.pin, m_regs[o.reg]);
+}
+
+} // namespace super
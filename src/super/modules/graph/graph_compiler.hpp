@@ -0,0 +1,118 @@
+#pragma once
+
+// ============================================================================
+// Graph Workflow Engine — Bytecode Compiler
+// Lowers a graph into straight-line code over a flat register file, so
+// math-heavy graphs run as one tight loop instead of a virtual process()
+// call plus pin copies per node.
+// ============================================================================
+
+#include <QString>
+#include <QVector>
+#include <memory>
+
+namespace super {
+
+class GraphEngine;
+class GraphNode;
+class GraphProgram;
+struct Pin;
+
+// ---------------------------------------------------------------------------
+// GraphOp — VM instructions. Operands are register indices; booleans are
+// 0.0 / 1.0 and any non-zero value reads as true.
+// ---------------------------------------------------------------------------
+enum class GraphOp : quint8 {
+	Add, Sub, Mul, Div, Pow, Mod, Min, Max,	// Div / Mod give 0 for a ~0 divisor
+	Eq, Ne, Lt, Gt, Le, Ge,					// Eq / Ne use qFuzzyCompare
+	And, Or, Not, Xor,
+	Select,		// dst = a ? b : c
+	Clamp,		// dst = clamp(a, b, c)
+	MapRange,	// dst = a mapped from [b, c] to [d, e]
+	Smooth,		// dst = EMA towards a with factor b (dst holds the state)
+	Call,		// Trampoline a: run a node's own process()
+};
+
+// ---------------------------------------------------------------------------
+// GraphCodegen — Passed to GraphNode::lower() for one node at a time.
+// reg() maps the node's pins to registers: outputs get their own register,
+// connected inputs read the source output's register, unconnected inputs
+// a constant register holding the pin's current value.
+// ---------------------------------------------------------------------------
+class GraphCodegen {
+public:
+	int reg(int pin) const;
+	void emit(GraphOp op, int dst, int a = 0, int b = 0, int c = 0, int d = 0, int e = 0);
+
+private:
+	friend class GraphProgram;
+	GraphCodegen(GraphProgram &prog) : m_prog(prog) {}
+
+	GraphProgram &m_prog;
+	const GraphNode *m_node = nullptr;
+	const QVector<int> *m_pin_regs = nullptr;	// Per pin of m_node
+};
+
+// ---------------------------------------------------------------------------
+// GraphProgram — Compiled form of a GraphEngine's current plan.
+// Nodes that don't lower themselves are called through a trampoline that
+// copies registers into their input pins and their output pins back out.
+// Only numeric connections (delayed or not) are supported; compile() fails
+// otherwise and the engine keeps interpreting.
+// ---------------------------------------------------------------------------
+class GraphProgram {
+public:
+	struct Instr {
+		GraphOp op;
+		int dst;
+		int a, b, c, d, e;
+	};
+
+	static std::unique_ptr<GraphProgram> compile(GraphEngine &engine, QString *error = nullptr);
+
+	// Execute once. Returns true if some node wants to run again next
+	// evaluation (a smoother still settling).
+	bool run();
+
+	// Publish register values to lowered nodes' output pins, for nodes
+	// that have output_changed receivers.
+	void write_back();
+
+	int instruction_count() const { return m_code.size(); }
+	int register_count() const { return m_regs.size(); }
+	int trampoline_count() const { return m_calls.size(); }
+
+private:
+	friend class GraphCodegen;
+
+	struct Bind {
+		int reg;
+		Pin *pin;
+	};
+	struct Call {
+		GraphNode *node;
+		int in_begin, in_end;		// Into m_binds: register → input pin
+		int out_begin, out_end;		// Into m_binds: output pin → register
+	};
+	struct Output {
+		GraphNode *node;
+		int pin;
+		int reg;
+	};
+	struct Latch {
+		int source;		// Delay source's output register
+		int target;		// Register read by the delayed input
+	};
+
+	int alloc(double init);
+
+	QVector<Instr> m_code;
+	QVector<double> m_regs;
+	QVector<Bind> m_binds;
+	QVector<Call> m_calls;
+	QVector<Output> m_outputs;		// Lowered nodes' output registers
+	QVector<Latch> m_latches;		// Delayed connections, copied before each run
+	QVector<Bind> m_seeds;			// Unconnected inputs of lowered nodes, pin → register before each run
+};
+
+} // namespace super
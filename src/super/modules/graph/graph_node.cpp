@@ -3,13 +3,69 @@
 // ============================================================================
 
 #include "graph_node.hpp"
+#include "graph_compiler.hpp"
+#include "node_factory.hpp"
+#include "../../core/work_pool.hpp"
+#include "../../dev/debugger/trace_recorder.hpp"
+#include "../../dev/metrics/metrics.hpp"
 
-#include <QQueue>
-#include <QSet>
+#include <QCborMap>
+#include <QCborValue>
+#include <QDataStream>
+#include <QMetaMethod>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
 
 namespace super {
 
+// ============================================================================
+// Pin
+// ============================================================================
+
+QVariant Pin::to_variant() const
+{
+	switch (type) {
+	case PinType::Number: return value.number;
+	case PinType::Bool:   return value.number != 0.0;
+	case PinType::Event:  return value.number;
+	case PinType::String: return value.text;
+	case PinType::Any:    break;
+	}
+	return value.any;
+}
+
+bool Pin::assign(const QVariant &v)
+{
+	switch (type) {
+	case PinType::Number:
+	case PinType::Event: {
+		double d = v.toDouble();
+		if (d == value.number) return false;
+		value.number = d;
+		return true;
+	}
+	case PinType::Bool: {
+		double d = v.toBool() ? 1.0 : 0.0;
+		if (d == value.number) return false;
+		value.number = d;
+		return true;
+	}
+	case PinType::String: {
+		QString t = v.toString();
+		if (t == value.text) return false;
+		value.text = t;
+		return true;
+	}
+	case PinType::Any:
+		break;
+	}
+	if (v == value.any) return false;
+	value.any = v;
+	return true;
+}
+
 // ============================================================================
 // GraphNode
 // ============================================================================
@@ -48,23 +104,103 @@ const Pin *GraphNode::find_pin(const QString &pin_id) const
 	return nullptr;
 }
 
+int GraphNode::pin_index(const QString &pin_id) const
+{
+	for (int i = 0; i < m_pins.size(); i++)
+		if (m_pins[i].id == pin_id)
+			return i;
+	return -1;
+}
+
 QVariant GraphNode::input_value(const QString &pin_id) const
 {
 	if (auto *p = find_pin(pin_id))
-		return p->current_value.isValid() ? p->current_value : p->default_value;
+		return p->to_variant();
 	return {};
 }
 
 void GraphNode::set_output(const QString &pin_id, const QVariant &value)
 {
-	if (auto *p = find_pin(pin_id)) {
-		p->current_value = value;
-		emit output_changed(pin_id, value);
-	}
+	int i = pin_index(pin_id);
+	if (i >= 0)
+		set_output(i, value);
 }
 
-void GraphNode::add_input(const QString &id, const QString &label,
-						   PinType type, const QVariant &default_val)
+void GraphNode::set_output(int pin, const QVariant &v)
+{
+	Pin &p = m_pins[pin];
+	if (p.assign(v))
+		output_written(p);
+}
+
+void GraphNode::set_output_number(int pin, double v)
+{
+	Pin &p = m_pins[pin];
+	if (p.value.number == v)
+		return;  // Unchanged outputs don't wake downstream nodes
+	p.value.number = v;
+	output_written(p);
+}
+
+void GraphNode::set_output_string(int pin, const QString &v)
+{
+	Pin &p = m_pins[pin];
+	if (p.value.text == v)
+		return;
+	p.value.text = v;
+	output_written(p);
+}
+
+void GraphNode::fire_event(int pin, int count)
+{
+	if (count <= 0)
+		return;
+	Pin &p = m_pins[pin];
+	p.value.number += count;
+	output_written(p);
+}
+
+int GraphNode::take_events(int pin)
+{
+	Pin &p = m_pins[pin];
+	double fired = p.value.number - p.events_seen;
+	p.events_seen = p.value.number;
+	return fired > 0.0 ? static_cast<int>(fired) : 0;
+}
+
+void GraphNode::output_written(Pin &p)
+{
+	p.changed_epoch = m_epoch;
+	if (m_observed)
+		emit output_changed(p.id, p.to_variant());
+}
+
+void GraphNode::connectNotify(const QMetaMethod &signal)
+{
+	if (signal == QMetaMethod::fromSignal(&GraphNode::output_changed))
+		m_observed = true;
+}
+
+void GraphNode::disconnectNotify(const QMetaMethod &signal)
+{
+	// Called with an invalid method when a receiver is destroyed
+	if (!signal.isValid() || signal == QMetaMethod::fromSignal(&GraphNode::output_changed))
+		m_observed = isSignalConnected(QMetaMethod::fromSignal(&GraphNode::output_changed));
+}
+
+void GraphNode::mark_dirty()
+{
+	m_dirty = true;
+	// During a pool batch the engine collects marks itself afterwards
+	if (!m_engine || m_engine->m_in_pool || m_rank < 0)
+		return;
+	if (m_rank < m_engine->m_first_dirty)
+		m_engine->m_first_dirty = m_rank;
+	m_engine->request_evaluation();
+}
+
+int GraphNode::add_input(const QString &id, const QString &label,
+						  PinType type, const QVariant &default_val)
 {
 	Pin p;
 	p.id = id;
@@ -72,12 +208,13 @@ void GraphNode::add_input(const QString &id, const QString &label,
 	p.direction = PinDirection::Input;
 	p.type = type;
 	p.default_value = default_val;
-	p.current_value = default_val;
+	p.assign(default_val);
 	m_pins.append(p);
+	return m_pins.size() - 1;
 }
 
-void GraphNode::add_output(const QString &id, const QString &label,
-							PinType type)
+int GraphNode::add_output(const QString &id, const QString &label,
+						   PinType type)
 {
 	Pin p;
 	p.id = id;
@@ -85,6 +222,7 @@ void GraphNode::add_output(const QString &id, const QString &label,
 	p.direction = PinDirection::Output;
 	p.type = type;
 	m_pins.append(p);
+	return m_pins.size() - 1;
 }
 
 QJsonObject GraphNode::save() const
@@ -96,6 +234,10 @@ QJsonObject GraphNode::save() const
 	obj["x"] = m_position.x();
 	obj["y"] = m_position.y();
 
+	QJsonObject st = state();
+	if (!st.isEmpty())
+		obj["state"] = st;
+
 	// Save pin defaults
 	QJsonObject pins;
 	for (const auto &p : m_pins) {
@@ -116,16 +258,25 @@ void GraphNode::load(const QJsonObject &obj)
 
 	auto pins = obj["pin_defaults"].toObject();
 	for (auto it = pins.constBegin(); it != pins.constEnd(); ++it) {
-		if (auto *p = find_pin(it.key()))
+		if (auto *p = find_pin(it.key())) {
 			p->default_value = it.value().toVariant();
+			p->assign(p->default_value);
+		}
 	}
+	mark_dirty();
 }
 
 // ============================================================================
 // GraphEngine
 // ============================================================================
 
-GraphEngine::GraphEngine(QObject *parent) : QObject(parent) {}
+GraphEngine::GraphEngine(QObject *parent) : QObject(parent)
+{
+	m_schedule_timer.setSingleShot(true);
+	m_schedule_timer.setTimerType(Qt::PreciseTimer);
+	QObject::connect(&m_schedule_timer, &QTimer::timeout, this, &GraphEngine::run_scheduled);
+	m_frame_clock.start();
+}
 
 GraphEngine::~GraphEngine()
 {
@@ -134,17 +285,38 @@ GraphEngine::~GraphEngine()
 
 GraphNode *GraphEngine::add_node(GraphNode *node)
 {
-	node->setParent(this);
-	m_nodes.insert(node->node_id(), node);
+	adopt(node);
+	invalidate_plan();
 	emit node_added(node->node_id());
 	return node;
 }
 
+void GraphEngine::adopt(GraphNode *node)
+{
+	node->setParent(this);
+	node->m_engine = this;
+	m_nodes.insert(node->node_id(), node);
+}
+
+void GraphEngine::clear()
+{
+	for (GraphNode *node : std::as_const(m_nodes)) {
+		node->m_engine = nullptr;
+		node->m_rank = -1;
+		node->deleteLater();
+	}
+	m_nodes.clear();
+	m_connections.clear();
+	invalidate_plan();
+}
+
 void GraphEngine::remove_node(const QUuid &id)
 {
 	auto *node = m_nodes.take(id);
 	if (!node)
 		return;
+	node->m_engine = nullptr;
+	node->m_rank = -1;
 
 	// Remove all connections involving this node
 	m_connections.erase(
@@ -153,6 +325,7 @@ void GraphEngine::remove_node(const QUuid &id)
 				return c.source_node == id || c.target_node == id;
 			}),
 		m_connections.end());
+	invalidate_plan();
 
 	emit node_removed(id);
 	node->deleteLater();
@@ -171,7 +344,8 @@ QList<GraphNode *> GraphEngine::all_nodes() const
 Connection *GraphEngine::connect_pins(const QUuid &source_node,
 									   const QString &source_pin,
 									   const QUuid &target_node,
-									   const QString &target_pin)
+									   const QString &target_pin,
+									   bool delayed)
 {
 	// Validate nodes exist
 	auto *src = find_node(source_node);
@@ -191,8 +365,10 @@ Connection *GraphEngine::connect_pins(const QUuid &source_node,
 	c.source_pin = source_pin;
 	c.target_node = target_node;
 	c.target_pin = target_pin;
+	c.delayed = delayed;
 
 	m_connections.append(c);
+	invalidate_plan();
 	emit connection_added(c.id);
 	return &m_connections.last();
 }
@@ -206,6 +382,7 @@ void GraphEngine::disconnect(const QUuid &connection_id)
 
 	if (it != m_connections.end()) {
 		m_connections.erase(it);
+		invalidate_plan();
 		emit connection_removed(connection_id);
 	}
 }
@@ -216,82 +393,429 @@ QList<Connection> GraphEngine::connections() const
 }
 
 // ---------------------------------------------------------------------------
-// Topological sort (Kahn's algorithm)
+// Execution plan: topological sort (Kahn's algorithm) over node indices,
+// then incoming edges resolved to pin pointers and bucketed per node.
+// Pin lists are fixed after construction, so the pointers stay valid until
+// the next structural change.
 // ---------------------------------------------------------------------------
 
-QList<GraphNode *> GraphEngine::topological_sort() const
+// ---------------------------------------------------------------------------
+// Cycle diagnostics. After Kahn's pass every node left with in_degree > 0
+// has an unscheduled predecessor, so following predecessors from any of them
+// must end on a cycle. Each node is walked at most once: linear overall.
+// ---------------------------------------------------------------------------
+
+template <typename Links>
+static void find_cycles(const QVector<GraphNode *> &nodes, const QVector<int> &in_degree,
+						const Links &links, QStringList &out)
 {
-	// Build adjacency + in-degree
-	QHash<QUuid, int> in_degree;
-	QHash<QUuid, QList<QUuid>> adjacency;
+	const int n = nodes.size();
+	QVector<int> pred(n, -1);
+	for (const auto &l : links)
+		if (in_degree[l.source] > 0 && in_degree[l.target] > 0)
+			pred[l.target] = l.source;
 
+	QVector<int> walk_of(n, -1);	// Which walk first reached the node
+	QVector<int> path;
+	for (int start = 0; start < n; start++) {
+		if (in_degree[start] == 0 || walk_of[start] >= 0)
+			continue;
+		path.clear();
+		int i = start;
+		while (i >= 0 && walk_of[i] < 0) {
+			walk_of[i] = start;
+			path.append(i);
+			i = pred[i];
+		}
+		if (i < 0 || walk_of[i] != start)
+			continue;  // Ran into an earlier walk's cycle
+
+		// path ends ... i ... (pred chain); the cycle is i back to i
+		QStringList names;
+		int from = path.indexOf(i);
+		for (int k = path.size() - 1; k >= from; k--)
+			names.append(nodes[path[k]]->display_name());
+		names.append(nodes[path.last()]->display_name());
+		out.append(names.join(QStringLiteral(" → ")));
+	}
+}
+
+void GraphEngine::build_plan()
+{
+	m_plan.clear();
+
+	const int n = m_nodes.size();
+	QVector<GraphNode *> nodes;
+	nodes.reserve(n);
+	QHash<QUuid, int> index;
+	index.reserve(n);
 	for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it) {
-		in_degree[it.key()] = 0;
+		index.insert(it.key(), nodes.size());
+		nodes.append(it.value());
 	}
 
+	// Resolve every connection once. Delayed ones don't constrain the order.
+	struct Resolved { int source; int target; ExecutionPlan::Edge edge; };
+	QVector<Resolved> resolved;
+	QVector<Resolved> delayed;
+	resolved.reserve(m_connections.size());
+	QVector<int> in_degree(n, 0);
+	QVector<int> out_count(n, 0);
 	for (const auto &conn : m_connections) {
-		adjacency[conn.source_node].append(conn.target_node);
-		in_degree[conn.target_node]++;
+		int si = index.value(conn.source_node, -1);
+		int ti = index.value(conn.target_node, -1);
+		if (si < 0 || ti < 0)
+			continue;
+		const Pin *out_pin = nodes[si]->find_pin(conn.source_pin);
+		Pin *in_pin = nodes[ti]->find_pin(conn.target_pin);
+		if (!out_pin || !in_pin)
+			continue;
+		bool numeric = out_pin->is_numeric() && in_pin->is_numeric();
+		if (conn.delayed) {
+			delayed.append({si, ti, {out_pin, in_pin, numeric}});
+			continue;
+		}
+		resolved.append({si, ti, {out_pin, in_pin, numeric}});
+		in_degree[ti]++;
+		out_count[si]++;
 	}
 
-	// Seed with zero in-degree nodes
-	QQueue<QUuid> queue;
-	for (auto it = in_degree.cbegin(); it != in_degree.cend(); ++it) {
-		if (it.value() == 0)
-			queue.enqueue(it.key());
+	// Adjacency as CSR
+	QVector<int> adj_begin(n + 1, 0);
+	for (int i = 0; i < n; i++)
+		adj_begin[i + 1] = adj_begin[i] + out_count[i];
+	QVector<int> adj(resolved.size());
+	QVector<int> fill = adj_begin;
+	for (const auto &r : resolved)
+		adj[fill[r.source]++] = r.target;
+
+	QVector<int> queue;
+	queue.reserve(n);
+	for (int i = 0; i < n; i++)
+		if (in_degree[i] == 0)
+			queue.append(i);
+	for (int head = 0; head < queue.size(); head++) {
+		int i = queue[head];
+		for (int k = adj_begin[i]; k < adj_begin[i + 1]; k++)
+			if (--in_degree[adj[k]] == 0)
+				queue.append(adj[k]);
 	}
+	// Nodes on a cycle never reach in-degree 0 and are left out
+	if (queue.size() < n)
+		find_cycles(nodes, in_degree, resolved, m_plan.cycles);
 
-	QList<GraphNode *> sorted;
-	while (!queue.isEmpty()) {
-		QUuid id = queue.dequeue();
-		if (auto *node = m_nodes.value(id))
-			sorted.append(node);
+	// Longest-path level per node, then order by level (counting sort).
+	// Level order is still a topological order.
+	QVector<int> level(n, 0);
+	int levels = 0;
+	for (int i : queue) {
+		for (int k = adj_begin[i]; k < adj_begin[i + 1]; k++)
+			level[adj[k]] = qMax(level[adj[k]], level[i] + 1);
+		levels = qMax(levels, level[i] + 1);
+	}
+	m_plan.level_begin.fill(0, levels + 1);
+	for (int i : queue)
+		m_plan.level_begin[level[i] + 1]++;
+	for (int l = 0; l < levels; l++)
+		m_plan.level_begin[l + 1] += m_plan.level_begin[l];
 
-		for (const QUuid &neighbor : adjacency.value(id)) {
-			in_degree[neighbor]--;
-			if (in_degree[neighbor] == 0)
-				queue.enqueue(neighbor);
-		}
+	// Structure changed: every scheduled node runs once on the next pass
+	QVector<int> rank(n, -1);
+	m_plan.order.resize(queue.size());
+	m_plan.level_of.resize(queue.size());
+	m_plan.pure.resize(queue.size());
+	for (GraphNode *node : nodes)
+		node->m_rank = -1;
+	fill = m_plan.level_begin;
+	for (int i : queue) {
+		int r = fill[level[i]]++;
+		rank[i] = r;
+		nodes[i]->m_rank = r;
+		nodes[i]->m_dirty = true;
+		m_plan.order[r] = nodes[i];
+		m_plan.level_of[r] = level[i];
+		m_plan.pure[r] = nodes[i]->is_pure();
 	}
+	m_first_dirty = 0;
+
+	// Bucket edges by target rank
+	const int m = m_plan.order.size();
+	m_plan.edge_begin.fill(0, m + 1);
+	for (const auto &r : resolved)
+		if (rank[r.target] >= 0)
+			m_plan.edge_begin[rank[r.target] + 1]++;
+	for (int i = 0; i < m; i++)
+		m_plan.edge_begin[i + 1] += m_plan.edge_begin[i];
+	m_plan.edges.resize(m_plan.edge_begin[m]);
+	fill = m_plan.edge_begin;
+	for (const auto &r : resolved)
+		if (rank[r.target] >= 0)
+			m_plan.edges[fill[rank[r.target]]++] = r.edge;
+
+	m_plan.delays.reserve(delayed.size());
+	for (const auto &r : delayed)
+		if (rank[r.source] >= 0 && rank[r.target] >= 0)
+			m_plan.delays.append({r.edge.source, r.edge.target, rank[r.target], r.edge.numeric});
 
-	return sorted;
+	m_plan_valid = true;
+	if (m_profile)
+		reset_stats();
+	if (!m_plan.cycles.isEmpty())
+		emit cycles_detected(m_plan.cycles);
 }
 
 // ---------------------------------------------------------------------------
-// Propagate output values to connected input pins
+// Evaluate: walk the plan from the first dirty node. A node runs if it was
+// marked dirty or one of its sources changed an output in this pass; its
+// incoming edges are pulled right before process().
 // ---------------------------------------------------------------------------
 
-void GraphEngine::propagate_values()
+bool GraphEngine::run_node(int rank, quint64 epoch)
 {
-	for (const auto &conn : m_connections) {
-		auto *src = find_node(conn.source_node);
-		auto *tgt = find_node(conn.target_node);
-		if (!src || !tgt)
-			continue;
+	GraphNode *node = m_plan.order[rank];
+	const auto *edges = m_plan.edges.constData();
+	const int begin = m_plan.edge_begin[rank];
+	const int end = m_plan.edge_begin[rank + 1];
+
+	bool run = node->m_dirty;
+	for (int k = begin; !run && k < end; k++)
+		run = edges[k].source->changed_epoch == epoch;
+	if (!run)
+		return false;
 
-		auto *out_pin = src->find_pin(conn.source_pin);
-		auto *in_pin = tgt->find_pin(conn.target_pin);
-		if (out_pin && in_pin)
-			in_pin->current_value = out_pin->current_value;
+	for (int k = begin; k < end; k++) {
+		const auto &e = edges[k];
+		if (e.numeric)
+			e.target->value.number = e.source->value.number;
+		else
+			e.target->assign(e.source->to_variant());
 	}
+	node->m_dirty = false;
+	node->m_epoch = epoch;
+	if (m_profile)
+		profile_node(rank, epoch);
+	else
+		node->process();
+	return true;
 }
 
-// ---------------------------------------------------------------------------
-// Evaluate: topological sort → propagate → process each node
-// ---------------------------------------------------------------------------
+void GraphEngine::profile_node(int rank, quint64 epoch)
+{
+	GraphNode *node = m_plan.order[rank];
+	const auto t0 = std::chrono::steady_clock::now();
+	node->process();
+	const qint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count();
+
+	// Each rank runs on one thread per pass, so its slot needs no lock
+	NodeStats &st = m_stats[rank];
+	st.calls++;
+	st.total_ns += ns;
+	st.max_ns = qMax(st.max_ns, ns);
+	for (const Pin &p : std::as_const(node->m_pins))
+		if (p.is_output() && p.changed_epoch == epoch)
+			st.output_changes++;
+}
+
+void GraphEngine::set_profiling(bool enabled)
+{
+	if (enabled == m_profile)
+		return;
+	m_profile = enabled;
+	if (enabled)
+		reset_stats();
+}
+
+void GraphEngine::reset_stats()
+{
+	m_stats.fill(NodeStats(), m_plan.order.size());
+	m_stats_clock.start();
+}
+
+double GraphEngine::stats_seconds() const
+{
+	return m_stats_clock.isValid() ? m_stats_clock.nsecsElapsed() / 1e9 : 0.0;
+}
 
 void GraphEngine::evaluate()
 {
-	auto sorted = topological_sort();
+	if (!m_plan_valid)
+		build_plan();
+	if (m_compile && !m_program && m_compile_error.isEmpty())
+		m_program = GraphProgram::compile(*this, &m_compile_error);
+	if (!m_program)
+		latch_delays();
 
-	for (auto *node : sorted) {
-		propagate_values();  // Push upstream outputs to this node's inputs
-		node->process();
+	const int count = m_plan.order.size();
+	if (m_first_dirty >= count)
+		return;  // Idle
+	SUPER_TRACE_SCOPE("graph", "evaluate");
+	SUPER_METRIC_TIME("graph.evaluate");
+	m_evaluating = true;
+
+	const quint64 epoch = ++m_epoch;
+	const int start = m_first_dirty;
+	m_first_dirty = count;  // Marks made from here on belong to the next pass
+
+	if (m_program) {
+		// Straight-line code runs every node; dirtiness only gates the pass
+		for (GraphNode *node : std::as_const(m_plan.order)) {
+			node->m_dirty = false;
+			node->m_epoch = epoch;
+		}
+		if (m_program->run())
+			m_first_dirty = 0;
+		m_program->write_back();
+		if (m_first_dirty < count)
+			request_evaluation();
+	} else if (m_parallel && WorkPool::instance().worker_count() > 0) {
+		evaluate_parallel(start, epoch);
+	} else {
+		for (int i = start; i < count; i++)
+			run_node(i, epoch);
 	}
 
+	// A delay source that moved feeds the next pass
+	if (!m_program) {
+		for (const auto &d : std::as_const(m_plan.delays)) {
+			if (d.source->changed_epoch == epoch) {
+				request_evaluation();
+				break;
+			}
+		}
+	}
+
+	m_evaluating = false;
 	emit evaluation_complete();
 }
 
+// Copy delay sources (still holding last pass's values) into their targets,
+// waking targets whose input actually changed.
+void GraphEngine::latch_delays()
+{
+	for (const auto &d : std::as_const(m_plan.delays)) {
+		bool changed;
+		if (d.numeric) {
+			changed = d.target->value.number != d.source->value.number;
+			d.target->value.number = d.source->value.number;
+		} else {
+			changed = d.target->assign(d.source->to_variant());
+		}
+		if (changed) {
+			m_plan.order[d.target_rank]->m_dirty = true;
+			m_first_dirty = qMin(m_first_dirty, d.target_rank);
+		}
+	}
+}
+
+void GraphEngine::invalidate_plan()
+{
+	m_plan_valid = false;
+	m_program.reset();
+	m_compile_error.clear();
+	request_evaluation();
+}
+
+// ---------------------------------------------------------------------------
+// Scheduling: the first request arms one single-shot timer; later requests
+// until it fires are absorbed, so a burst of port changes costs one pass.
+// Requests made while evaluating (a node asking to run again) always wait
+// for the next frame so they can't spin the event loop.
+// ---------------------------------------------------------------------------
+
+void GraphEngine::set_schedule(const GraphSchedule &schedule)
+{
+	m_schedule = schedule;
+	m_schedule_timer.stop();
+	m_eval_pending = false;
+	if (m_first_dirty < m_plan.order.size() || !m_plan_valid)
+		request_evaluation();
+}
+
+void GraphEngine::request_evaluation()
+{
+	if (m_schedule.trigger == GraphTrigger::Manual || m_eval_pending)
+		return;
+	m_eval_pending = true;
+
+	qint64 delay = 0;
+	if (m_schedule.trigger == GraphTrigger::Frame || m_evaluating) {
+		qint64 frame = qMax(1, m_schedule.frame_ms);
+		delay = frame - m_frame_clock.elapsed() % frame;
+	}
+	if (m_schedule.max_rate_hz > 0.0 && m_last_run.isValid()) {
+		qint64 gap = static_cast<qint64>(std::ceil(1000.0 / m_schedule.max_rate_hz));
+		delay = qMax(delay, gap - m_last_run.elapsed());
+	}
+	m_schedule_timer.start(static_cast<int>(qMax<qint64>(0, delay)));
+}
+
+void GraphEngine::run_scheduled()
+{
+	m_eval_pending = false;
+	m_last_run.start();
+	evaluate();
+}
+
+const ExecutionPlan &GraphEngine::plan()
+{
+	if (!m_plan_valid)
+		build_plan();
+	return m_plan;
+}
+
+void GraphEngine::set_compiled(bool enabled)
+{
+	if (enabled == m_compile)
+		return;
+	m_compile = enabled;
+	invalidate_plan();
+}
+
+void GraphEngine::set_parallel(bool enabled, int min_batch)
+{
+	m_parallel = enabled;
+	m_min_batch = qMax(2, min_batch);
+}
+
+// Level by level: nodes that must stay on this thread run first, then the
+// level's pure nodes go to the pool as one batch. Levels are barriers, so a
+// batch only ever reads outputs of earlier levels.
+void GraphEngine::evaluate_parallel(int start, quint64 epoch)
+{
+	const int count = m_plan.order.size();
+	int level = m_plan.level_of[start];
+	int i = start;
+	while (i < count) {
+		const int level_end = m_plan.level_begin[level + 1];
+		m_batch.clear();
+		for (; i < level_end; i++) {
+			if (m_plan.pure[i] && !m_plan.order[i]->m_observed)
+				m_batch.append(i);
+			else
+				run_node(i, epoch);
+		}
+
+		if (m_batch.size() >= m_min_batch) {
+			m_in_pool = true;
+			WorkPool::instance().parallel_for(m_batch.size(),
+				[this, epoch](int k) { run_node(m_batch[k], epoch); }, 8);
+			m_in_pool = false;
+			// Pick up re-evaluation requests made on worker threads
+			for (int r : m_batch) {
+				if (m_plan.order[r]->m_dirty && r < m_first_dirty) {
+					m_first_dirty = r;
+					request_evaluation();
+				}
+			}
+		} else {
+			for (int r : m_batch)
+				run_node(r, epoch);
+		}
+		level++;
+	}
+}
+
 // ---------------------------------------------------------------------------
 // Serialization
 // ---------------------------------------------------------------------------
@@ -300,29 +824,258 @@ QJsonObject GraphEngine::save() const
 {
 	QJsonObject obj;
 
+	QHash<QUuid, int> index;
+	index.reserve(m_nodes.size());
 	QJsonArray nodes_arr;
-	for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it)
+	for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it) {
+		index.insert(it.key(), nodes_arr.size());
 		nodes_arr.append(it.value()->save());
+	}
 	obj["nodes"] = nodes_arr;
 
+	// Node indices ("si"/"ti") let load skip UUID lookups
 	QJsonArray conn_arr;
-	for (const auto &c : m_connections)
-		conn_arr.append(c.to_json());
+	for (const auto &c : m_connections) {
+		QJsonObject o = c.to_json();
+		o["si"] = index.value(c.source_node, -1);
+		o["ti"] = index.value(c.target_node, -1);
+		conn_arr.append(o);
+	}
 	obj["connections"] = conn_arr;
 
 	return obj;
 }
 
-void GraphEngine::load(const QJsonObject &obj)
+bool GraphEngine::load(const QJsonObject &obj)
 {
-	// Note: Node deserialization requires a factory to create the right
-	// subclass by type_id. This will be implemented when the node library
-	// is built. For now, connections are loaded here.
+	clear();
+	bool complete = true;
+	auto &factory = NodeFactory::instance();
 
-	auto conn_arr = obj["connections"].toArray();
-	m_connections.clear();
-	for (const auto &v : conn_arr)
-		m_connections.append(Connection::from_json(v.toObject()));
+	const QJsonArray nodes_arr = obj["nodes"].toArray();
+	QVector<GraphNode *> nodes(nodes_arr.size(), nullptr);
+	m_nodes.reserve(nodes_arr.size());
+	for (int i = 0; i < nodes_arr.size(); i++) {
+		const QJsonObject o = nodes_arr[i].toObject();
+		GraphNode *node = factory.create(o["type"].toString(), o["state"].toObject());
+		if (!node) {
+			complete = false;  // Unknown type: drop it and its connections
+			continue;
+		}
+		node->load(o);
+		adopt(node);
+		nodes[i] = node;
+	}
+
+	const QJsonArray conn_arr = obj["connections"].toArray();
+	m_connections.reserve(conn_arr.size());
+	for (const auto &v : conn_arr) {
+		const QJsonObject o = v.toObject();
+		Connection c = Connection::from_json(o);
+		GraphNode *src = nullptr;
+		GraphNode *tgt = nullptr;
+		if (o.contains("si")) {
+			int si = o["si"].toInt(-1);
+			int ti = o["ti"].toInt(-1);
+			src = si >= 0 && si < nodes.size() ? nodes[si] : nullptr;
+			tgt = ti >= 0 && ti < nodes.size() ? nodes[ti] : nullptr;
+		} else {
+			src = find_node(c.source_node);
+			tgt = find_node(c.target_node);
+		}
+		if (!src || !tgt || !src->find_pin(c.source_pin) || !tgt->find_pin(c.target_pin)) {
+			complete = false;
+			continue;
+		}
+		c.source_node = src->node_id();
+		c.target_node = tgt->node_id();
+		m_connections.append(c);
+	}
+
+	invalidate_plan();
+	emit loaded();
+	return complete;
+}
+
+// ---------------------------------------------------------------------------
+// Binary format (QDataStream, Qt 6.0 encoding)
+//
+//   u32 magic 'SGRF', u16 version, QStringList strings
+//   u32 node count, per node:
+//     u32 type (string index), QUuid id, u32 name (string index),
+//     f64 x, f64 y, QByteArray state (CBOR, empty if none),
+//     u16 default count, then (u16 pin index, QVariant default) pairs
+//   u32 connection count, per connection:
+//     u32 source node, u16 source pin, u32 target node, u16 target pin,
+//     QUuid id, u8 flags (bit 0: delayed; version 2+)
+//
+// Nodes and pins are referenced by index, so loading never parses UUID
+// strings or compares pin ids.
+// ---------------------------------------------------------------------------
+
+static constexpr quint32 kGraphMagic = 0x53475246;	// "SGRF"
+static constexpr quint16 kGraphVersion = 2;
+
+QByteArray GraphEngine::save_binary() const
+{
+	QStringList strings;
+	QHash<QString, quint32> string_index;
+	auto intern = [&](const QString &str) -> quint32 {
+		auto it = string_index.constFind(str);
+		if (it != string_index.constEnd())
+			return it.value();
+		quint32 i = strings.size();
+		strings.append(str);
+		string_index.insert(str, i);
+		return i;
+	};
+
+	QVector<GraphNode *> nodes;
+	nodes.reserve(m_nodes.size());
+	QHash<QUuid, quint32> index;
+	index.reserve(m_nodes.size());
+	for (auto it = m_nodes.cbegin(); it != m_nodes.cend(); ++it) {
+		index.insert(it.key(), nodes.size());
+		nodes.append(it.value());
+	}
+
+	QByteArray body;
+	QDataStream out(&body, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_6_0);
+
+	out << quint32(nodes.size());
+	for (GraphNode *node : std::as_const(nodes)) {
+		out << intern(node->type_id()) << node->node_id() << intern(node->display_name())
+			<< node->position().x() << node->position().y();
+		QJsonObject st = node->state();
+		out << (st.isEmpty() ? QByteArray() : QCborValue::fromJsonValue(st).toCbor());
+
+		const QList<Pin> &pins = node->pins();
+		quint16 defaults = 0;
+		for (const Pin &p : pins)
+			if (p.is_input() && p.default_value.isValid())
+				defaults++;
+		out << defaults;
+		for (int i = 0; i < pins.size(); i++)
+			if (pins[i].is_input() && pins[i].default_value.isValid())
+				out << quint16(i) << pins[i].default_value;
+	}
+
+	struct Wire { quint32 si; quint16 sp; quint32 ti; quint16 tp; QUuid id; quint8 flags; };
+	QVector<Wire> wires;
+	wires.reserve(m_connections.size());
+	for (const auto &c : m_connections) {
+		auto si = index.constFind(c.source_node);
+		auto ti = index.constFind(c.target_node);
+		if (si == index.constEnd() || ti == index.constEnd())
+			continue;
+		int sp = nodes[*si]->pin_index(c.source_pin);
+		int tp = nodes[*ti]->pin_index(c.target_pin);
+		if (sp < 0 || tp < 0)
+			continue;
+		wires.append({*si, quint16(sp), *ti, quint16(tp), c.id, quint8(c.delayed ? 1 : 0)});
+	}
+	out << quint32(wires.size());
+	for (const Wire &w : std::as_const(wires))
+		out << w.si << w.sp << w.ti << w.tp << w.id << w.flags;
+
+	QByteArray result;
+	QDataStream head(&result, QIODevice::WriteOnly);
+	head.setVersion(QDataStream::Qt_6_0);
+	head << kGraphMagic << kGraphVersion << strings;
+	result.append(body);
+	return result;
+}
+
+bool GraphEngine::load_binary(const QByteArray &data)
+{
+	QDataStream in(data);
+	in.setVersion(QDataStream::Qt_6_0);
+
+	quint32 magic = 0;
+	quint16 version = 0;
+	QStringList strings;
+	in >> magic >> version;
+	if (magic != kGraphMagic || version > kGraphVersion)
+		return false;
+	in >> strings;
+
+	clear();
+	bool complete = true;
+	auto &factory = NodeFactory::instance();
+	auto string_at = [&](quint32 i) { return i < quint32(strings.size()) ? strings[i] : QString(); };
+
+	quint32 node_count = 0;
+	in >> node_count;
+	QVector<GraphNode *> nodes(qMin<quint32>(node_count, data.size()), nullptr);
+	m_nodes.reserve(nodes.size());
+	for (quint32 i = 0; i < node_count && in.status() == QDataStream::Ok; i++) {
+		quint32 type = 0, name = 0;
+		QUuid id;
+		double x = 0.0, y = 0.0;
+		QByteArray state;
+		quint16 defaults = 0;
+		in >> type >> id >> name >> x >> y >> state >> defaults;
+
+		QJsonObject st = state.isEmpty() ? QJsonObject()
+			: QCborValue::fromCbor(state).toMap().toJsonObject();
+		GraphNode *node = factory.create(string_at(type), st);
+
+		for (quint16 k = 0; k < defaults; k++) {
+			quint16 pin = 0;
+			QVariant value;
+			in >> pin >> value;
+			if (node && pin < node->m_pins.size()) {
+				Pin &p = node->m_pins[pin];
+				p.default_value = value;
+				p.assign(value);
+			}
+		}
+		if (!node) {
+			complete = false;
+			continue;
+		}
+		node->m_id = id;
+		node->m_display_name = string_at(name);
+		node->m_position = QPointF(x, y);
+		adopt(node);
+		if (i < quint32(nodes.size()))
+			nodes[i] = node;
+	}
+
+	quint32 conn_count = 0;
+	in >> conn_count;
+	m_connections.reserve(qMin<quint32>(conn_count, data.size()));
+	for (quint32 i = 0; i < conn_count && in.status() == QDataStream::Ok; i++) {
+		quint32 si = 0, ti = 0;
+		quint16 sp = 0, tp = 0;
+		Connection c;
+		quint8 flags = 0;
+		in >> si >> sp >> ti >> tp >> c.id;
+		if (version >= 2)
+			in >> flags;
+		c.delayed = flags & 1;
+		GraphNode *src = si < quint32(nodes.size()) ? nodes[si] : nullptr;
+		GraphNode *tgt = ti < quint32(nodes.size()) ? nodes[ti] : nullptr;
+		if (!src || !tgt || sp >= src->m_pins.size() || tp >= tgt->m_pins.size()) {
+			complete = false;
+			continue;
+		}
+		c.source_node = src->m_id;
+		c.source_pin = src->m_pins[sp].id;
+		c.target_node = tgt->m_id;
+		c.target_pin = tgt->m_pins[tp].id;
+		m_connections.append(c);
+	}
+
+	if (in.status() != QDataStream::Ok) {
+		clear();
+		return false;
+	}
+
+	invalidate_plan();
+	emit loaded();
+	return complete;
 }
 
 } // namespace super
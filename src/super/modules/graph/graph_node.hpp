@@ -7,18 +7,25 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 #include <QList>
+#include <QVector>
 #include <QHash>
 #include <QUuid>
 #include <QPointF>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <memory>
 
 namespace super {
 
 class GraphNode;
 class GraphEngine;
+class GraphCodegen;
+class GraphProgram;
 
 // ---------------------------------------------------------------------------
 // PinDirection — Whether a pin receives or sends data.
@@ -36,6 +43,16 @@ enum class PinType {
 	Event		// Stateless trigger (like ControlType::Command)
 };
 
+// ---------------------------------------------------------------------------
+// PinValue — Typed storage behind a pin. Only the member matching the pin's
+// type is used, so hot paths never touch QVariant.
+// ---------------------------------------------------------------------------
+struct PinValue {
+	double number = 0.0;	// Number, Bool (0 / 1), Event (fire counter)
+	QString text;			// String (implicitly shared handle)
+	QVariant any;			// Any
+};
+
 // ---------------------------------------------------------------------------
 // Pin — A single input or output slot on a node.
 // ---------------------------------------------------------------------------
@@ -45,14 +62,24 @@ struct Pin {
 	PinDirection direction;
 	PinType type = PinType::Any;
 	QVariant default_value;
-	QVariant current_value;
+	PinValue value;
+	quint64 changed_epoch = 0;	// Evaluation pass that last changed this output
+	double events_seen = 0.0;	// Event inputs: counter consumed by take_events()
 
 	bool is_input() const { return direction == PinDirection::Input; }
 	bool is_output() const { return direction == PinDirection::Output; }
+	bool is_numeric() const { return type == PinType::Number || type == PinType::Bool || type == PinType::Event; }
+
+	// Slow path for persistence, UI and untyped pins.
+	QVariant to_variant() const;
+	// Store `v` converted to this pin's type. Returns false if unchanged.
+	bool assign(const QVariant &v);
 };
 
 // ---------------------------------------------------------------------------
 // Connection — A wire between two pins on different nodes.
+// A delayed wire (z⁻¹) delivers the value its source had at the end of the
+// previous evaluation; it doesn't order its ends, so it may close a cycle.
 // ---------------------------------------------------------------------------
 struct Connection {
 	QUuid id;
@@ -60,6 +87,7 @@ struct Connection {
 	QString source_pin;
 	QUuid target_node;
 	QString target_pin;
+	bool delayed = false;
 
 	QJsonObject to_json() const {
 		QJsonObject obj;
@@ -68,6 +96,8 @@ struct Connection {
 		obj["source_pin"] = source_pin;
 		obj["target_node"] = target_node.toString();
 		obj["target_pin"] = target_pin;
+		if (delayed)
+			obj["delay"] = true;
 		return obj;
 	}
 
@@ -78,6 +108,7 @@ struct Connection {
 		c.source_pin = obj["source_pin"].toString();
 		c.target_node = QUuid::fromString(obj["target_node"].toString());
 		c.target_pin = obj["target_pin"].toString();
+		c.delayed = obj["delay"].toBool();
 		return c;
 	}
 };
@@ -105,18 +136,40 @@ public:
 	void set_position(const QPointF &pos);
 
 	// -- Pins --
+	// Pins are fixed after construction; resolve ids to indices once.
 	const QList<Pin> &pins() const;
+	const Pin &pin(int index) const { return m_pins[index]; }
+	int pin_index(const QString &pin_id) const;
 	Pin *find_pin(const QString &pin_id);
 	const Pin *find_pin(const QString &pin_id) const;
 
+	// By id (QVariant, linear lookup) — for tools and scripting
 	QVariant input_value(const QString &pin_id) const;
 	void set_output(const QString &pin_id, const QVariant &value);
 
 	// -- Processing --
-	// Called by the engine each tick. Read inputs, compute, write outputs.
+	// Called by the engine when the node is dirty or an upstream output it
+	// reads changed. Read inputs, compute, write outputs.
 	virtual void process() = 0;
 
+	// Pure nodes only read their inputs and write their outputs (no
+	// registry, OBS or other shared state), so the engine may run them on
+	// worker threads.
+	virtual bool is_pure() const { return false; }
+
+	// Emit VM code for this node (see graph_compiler.hpp). Nodes that
+	// return false are run through a trampoline calling process().
+	virtual bool lower(GraphCodegen &gen) const { Q_UNUSED(gen); return false; }
+
+	// Schedule this node for the next evaluation (e.g. an external source
+	// changed). Inputs arriving over connections do this automatically.
+	void mark_dirty();
+	bool is_dirty() const { return m_dirty; }
+
 	// -- Serialization --
+	// Construction parameters (operator, port id, ...). NodeFactory passes
+	// them back when recreating the node, before load() is called.
+	virtual QJsonObject state() const { return {}; }
 	virtual QJsonObject save() const;
 	virtual void load(const QJsonObject &obj);
 
@@ -125,13 +178,49 @@ signals:
 
 protected:
 	// Subclasses call these in constructor to define their interface.
-	void add_input(const QString &id, const QString &label,
-				   PinType type = PinType::Any,
-				   const QVariant &default_val = {});
-	void add_output(const QString &id, const QString &label,
-					PinType type = PinType::Any);
+	// The returned index addresses the pin in the typed accessors below.
+	int add_input(const QString &id, const QString &label,
+				  PinType type = PinType::Any,
+				  const QVariant &default_val = {});
+	int add_output(const QString &id, const QString &label,
+				   PinType type = PinType::Any);
+
+	// -- Typed pin access (by index) --
+	double input_number(int pin) const { return m_pins[pin].value.number; }
+	bool input_bool(int pin) const { return m_pins[pin].value.number != 0.0; }
+	const QString &input_string(int pin) const { return m_pins[pin].value.text; }
+	QVariant input_value(int pin) const { return m_pins[pin].to_variant(); }
+
+	void set_output_number(int pin, double v);
+	void set_output_bool(int pin, bool v) { set_output_number(pin, v ? 1.0 : 0.0); }
+	void set_output_string(int pin, const QString &v);
+	void set_output(int pin, const QVariant &v);
+
+	// Event pins carry a fire counter, so triggers stay discrete even when
+	// several arrive between evaluations. take_events() returns how many
+	// fired into an Event input since the last call.
+	void fire_event(int pin, int count = 1);
+	int take_events(int pin);
+
+	void connectNotify(const QMetaMethod &signal) override;
+	void disconnectNotify(const QMetaMethod &signal) override;
+
+	// From process(): run again next evaluation even if no input changes
+	// (time-based state that hasn't settled yet).
+	void request_reevaluate() { mark_dirty(); }
 
 private:
+	friend class GraphEngine;
+	friend class GraphProgram;
+
+	void output_written(Pin &p);
+
+	GraphEngine *m_engine = nullptr;
+	int m_rank = -1;			// Position in the engine's plan, -1 if not scheduled
+	quint64 m_epoch = 0;		// Pass currently being processed
+	bool m_dirty = true;
+	bool m_observed = false;	// output_changed has receivers
+
 	QUuid m_id;
 	QString m_type_id;
 	QString m_display_name;
@@ -139,6 +228,78 @@ private:
 	QList<Pin> m_pins;
 };
 
+// ---------------------------------------------------------------------------
+// ExecutionPlan — Cached evaluation order for a GraphEngine.
+// Rebuilt only when nodes or connections change. Incoming edges are resolved
+// to pin pointers and grouped per node, so evaluation is one linear pass.
+// ---------------------------------------------------------------------------
+struct ExecutionPlan {
+	struct Edge {
+		const Pin *source;
+		Pin *target;
+		bool numeric;	// Both ends numeric: plain double copy
+	};
+
+	struct Delay {
+		const Pin *source;
+		Pin *target;
+		int target_rank;
+		bool numeric;
+	};
+
+	QVector<GraphNode *> order;		// Topological order, grouped by level
+	QVector<Edge> edges;			// Grouped by target, in `order` order
+	QVector<int> edge_begin;		// order.size() + 1 offsets into `edges`
+
+	// Level k holds nodes whose longest path from a source has k edges;
+	// nodes within a level never depend on each other.
+	QVector<int> level_begin;		// levels + 1 offsets into `order`
+	QVector<int> level_of;			// Per rank
+	QVector<bool> pure;				// Per rank: GraphNode::is_pure()
+
+	// Delayed connections, latched at the start of each evaluation
+	QVector<Delay> delays;
+
+	// One entry per cycle without a delayed connection, e.g.
+	// "Add → Clamp → Add". Nodes on or downstream of such a cycle are
+	// left out of `order`.
+	QStringList cycles;
+
+	void clear()
+	{
+		order.clear(); edges.clear(); edge_begin.clear();
+		level_begin.clear(); level_of.clear(); pure.clear();
+		delays.clear(); cycles.clear();
+	}
+};
+
+// ---------------------------------------------------------------------------
+// GraphSchedule — When a GraphEngine evaluates on its own.
+// Any mark_dirty() (port change, loaded default, settling smoother, graph
+// edit) requests an evaluation; requests coalesce until it runs.
+// ---------------------------------------------------------------------------
+enum class GraphTrigger {
+	Manual,		// Only explicit evaluate() calls
+	Immediate,	// Next event-loop pass
+	Frame		// Next frame boundary (frame_ms grid)
+};
+
+struct GraphSchedule {
+	GraphTrigger trigger = GraphTrigger::Frame;
+	double max_rate_hz = 0.0;	// Minimum spacing between runs; 0 = unlimited
+	int frame_ms = 16;
+};
+
+// ---------------------------------------------------------------------------
+// NodeStats — Per-node profile counters collected while profiling is on.
+// ---------------------------------------------------------------------------
+struct NodeStats {
+	quint64 calls = 0;			// process() invocations
+	qint64 total_ns = 0;		// Wall time inside process()
+	qint64 max_ns = 0;			// Slowest single call
+	quint64 output_changes = 0;	// Outputs that changed value across all calls
+};
+
 // ---------------------------------------------------------------------------
 // GraphEngine — Owns nodes, manages connections, drives evaluation.
 // ---------------------------------------------------------------------------
@@ -159,17 +320,62 @@ public:
 	Connection *connect_pins(const QUuid &source_node,
 							  const QString &source_pin,
 							  const QUuid &target_node,
-							  const QString &target_pin);
+							  const QString &target_pin,
+							  bool delayed = false);
 	void disconnect(const QUuid &connection_id);
 	QList<Connection> connections() const;
 
 	// -- Evaluation --
-	// Process all nodes in topological order.
+	// Process dirty nodes, and nodes whose upstream outputs changed, in
+	// topological order. Returns immediately when nothing is pending.
 	void evaluate();
 
+	// Run independent pure nodes of a level on WorkPool threads once a
+	// level has at least `min_batch` of them. Other nodes, and nodes with
+	// output_changed receivers, always run on the calling thread.
+	// Off by default: with cheap nodes the hand-off costs more than it
+	// saves. Measure with super-graph-bench (ENABLE_BENCHMARKS) first.
+	void set_parallel(bool enabled, int min_batch = 64);
+	bool is_parallel() const { return m_parallel; }
+
+	// Run the graph as compiled bytecode (GraphProgram). Falls back to
+	// interpretation when the graph can't be compiled.
+	void set_compiled(bool enabled);
+	bool is_compiled() const { return m_program != nullptr; }
+	const QString &compile_error() const { return m_compile_error; }
+
+	// Current plan (rebuilt first if the graph changed).
+	const ExecutionPlan &plan();
+
+	// -- Profiling --
+	// While enabled, each interpreted process() call is timed into stats().
+	// Disabled, the cost is one branch per node run. Compiled graphs run as
+	// one program and are not broken down per node.
+	void set_profiling(bool enabled);
+	bool is_profiling() const { return m_profile; }
+	void reset_stats();
+	// Indexed by plan rank (plan().order); reset when the plan is rebuilt.
+	const QVector<NodeStats> &stats() const { return m_stats; }
+	// Wall time covered by stats(), for turning counts into rates.
+	double stats_seconds() const;
+
+	// -- Scheduling --
+	void set_schedule(const GraphSchedule &schedule);
+	const GraphSchedule &schedule() const { return m_schedule; }
+
+	// Remove every node and connection.
+	void clear();
+
 	// -- Serialization --
+	// Loading replaces the graph: nodes are recreated through NodeFactory
+	// and connections resolved by node / pin index. Per-element signals are
+	// not emitted; `loaded` fires once at the end.
 	QJsonObject save() const;
-	void load(const QJsonObject &obj);
+	bool load(const QJsonObject &obj);
+
+	// Compact binary form of the same data (see graph_node.cpp).
+	QByteArray save_binary() const;
+	bool load_binary(const QByteArray &data);
 
 signals:
 	void node_added(const QUuid &id);
@@ -177,13 +383,44 @@ signals:
 	void connection_added(const QUuid &id);
 	void connection_removed(const QUuid &id);
 	void evaluation_complete();
+	void loaded();
+	void cycles_detected(const QStringList &cycles);	// From plan building
 
 private:
-	void propagate_values();
-	QList<GraphNode *> topological_sort() const;
+	friend class GraphNode;
+
+	void invalidate_plan();
+	void build_plan();
+	void adopt(GraphNode *node);
+	void request_evaluation();
+	void run_scheduled();
+	bool run_node(int rank, quint64 epoch);
+	void profile_node(int rank, quint64 epoch);
+	void evaluate_parallel(int start, quint64 epoch);
+	void latch_delays();
 
 	QHash<QUuid, GraphNode *> m_nodes;
 	QList<Connection> m_connections;
+	ExecutionPlan m_plan;
+	bool m_plan_valid = false;
+	int m_first_dirty = 0;		// Lowest plan rank with a pending node
+	quint64 m_epoch = 0;
+	bool m_parallel = false;
+	bool m_in_pool = false;		// Pool batch running: marks are node-local
+	int m_min_batch = 64;
+	QVector<int> m_batch;
+	GraphSchedule m_schedule;
+	QTimer m_schedule_timer;
+	QElapsedTimer m_frame_clock;
+	QElapsedTimer m_last_run;
+	bool m_eval_pending = false;
+	bool m_evaluating = false;
+	bool m_compile = false;
+	std::unique_ptr<GraphProgram> m_program;
+	QString m_compile_error;
+	bool m_profile = false;
+	QVector<NodeStats> m_stats;
+	QElapsedTimer m_stats_clock;
 };
 
 } // namespace super
@@ -0,0 +1,113 @@
+// ============================================================================
+// Graph Workflow Engine — Node Factory
+// ============================================================================
+
+#include "node_factory.hpp"
+#include "standard_nodes.hpp"
+#include "audio_nodes.hpp"
+
+namespace super {
+
+NodeFactory &NodeFactory::instance()
+{
+	static NodeFactory factory;
+	return factory;
+}
+
+NodeFactory::NodeFactory()
+{
+	register_standard_nodes();
+	register_audio_nodes();
+}
+
+void NodeFactory::register_type(const QString &type_id, const QString &display_name,
+								const QString &category, Creator create)
+{
+	if (!m_entries.contains(type_id))
+		m_order.append(type_id);
+	m_entries.insert(type_id, {type_id, display_name, category, std::move(create)});
+}
+
+const NodeFactory::Entry *NodeFactory::entry(const QString &type_id) const
+{
+	auto it = m_entries.constFind(type_id);
+	return it != m_entries.constEnd() ? &it.value() : nullptr;
+}
+
+GraphNode *NodeFactory::create(const QString &type_id, const QJsonObject &state) const
+{
+	auto it = m_entries.constFind(type_id);
+	return it != m_entries.constEnd() ? it->create(state) : nullptr;
+}
+
+void NodeFactory::register_standard_nodes()
+{
+	register_type("math", "Math", "Math", [](const QJsonObject &s) {
+		return new MathNode(static_cast<MathNode::Op>(s["op"].toInt(MathNode::Add)));
+	});
+	register_type("compare", "Compare", "Logic", [](const QJsonObject &s) {
+		return new CompareNode(static_cast<CompareNode::Op>(s["op"].toInt(CompareNode::Equal)));
+	});
+	register_type("logic_gate", "Logic Gate", "Logic", [](const QJsonObject &s) {
+		return new LogicGateNode(static_cast<LogicGateNode::Op>(s["op"].toInt(LogicGateNode::And)));
+	});
+	register_type("switch", "Switch", "Flow", [](const QJsonObject &) {
+		return new SwitchNode();
+	});
+	register_type("clamp", "Clamp", "Math", [](const QJsonObject &) {
+		return new ClampNode();
+	});
+	register_type("map_range", "Map Range", "Math", [](const QJsonObject &) {
+		return new MapRangeNode();
+	});
+	register_type("port_read", "Read Port", "Control", [](const QJsonObject &s) {
+		return new PortReadNode(s["port"].toString());
+	});
+	register_type("port_write", "Write Port", "Control", [](const QJsonObject &s) {
+		return new PortWriteNode(s["port"].toString());
+	});
+	register_type("constant", "Constant", "Math", [](const QJsonObject &s) {
+		return new ConstantNode(s["value"].toDouble());
+	});
+	register_type("smooth", "Smooth", "Math", [](const QJsonObject &) {
+		return new SmoothNode();
+	});
+}
+
+void NodeFactory::register_audio_nodes()
+{
+	register_type("audio_input", "Audio Input", "Audio", [](const QJsonObject &s) {
+		return new AudioInputNode(s);
+	});
+	register_type("audio_lfo", "LFO", "Audio", [](const QJsonObject &s) {
+		return new AudioLfoNode(s);
+	});
+	register_type("audio_envelope", "Envelope Follower", "Audio", [](const QJsonObject &s) {
+		return new AudioEnvelopeNode(s);
+	});
+	register_type("audio_smooth", "Block Smooth", "Audio", [](const QJsonObject &s) {
+		return new AudioSmoothNode(s);
+	});
+	register_type("audio_gate", "Block Gate", "Audio", [](const QJsonObject &s) {
+		return new AudioGateNode(s);
+	});
+	register_type("audio_map", "Block Map", "Audio", [](const QJsonObject &s) {
+		return new AudioMapNode(s);
+	});
+	register_type("audio_math", "Block Math", "Audio", [](const QJsonObject &s) {
+		return new AudioMathNode(s);
+	});
+	register_type("audio_gain", "Apply Gain", "Audio", [](const QJsonObject &s) {
+		return new AudioGainNode(s);
+	});
+	register_type("audio_publish", "Publish", "Audio", [](const QJsonObject &s) {
+		return new AudioPublishNode(s);
+	});
+}
+
+} // namespace super
+
+// standard_nodes.hpp and audio_nodes.hpp have no translation unit of their
+// own; moc them here
+#include "moc_standard_nodes.cpp"
+#include "moc_audio_nodes.cpp"
@@ -0,0 +1,55 @@
+#pragma once
+
+// ============================================================================
+// Graph Workflow Engine — Node Factory
+// Creates nodes by type_id, so saved graphs can be rebuilt.
+// ============================================================================
+
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+namespace super {
+
+class GraphNode;
+
+// ---------------------------------------------------------------------------
+// NodeFactory — type_id → constructor registry (singleton).
+// Creators receive the node's saved state() so parameters that shape the
+// pin layout (e.g. a NOT gate having one input) are known up front.
+// The standard and audio node libraries are registered on first use.
+// ---------------------------------------------------------------------------
+class NodeFactory {
+public:
+	using Creator = std::function<GraphNode *(const QJsonObject &state)>;
+
+	struct Entry {
+		QString type_id;
+		QString display_name;
+		QString category;
+		Creator create;
+	};
+
+	static NodeFactory &instance();
+
+	void register_type(const QString &type_id, const QString &display_name,
+					   const QString &category, Creator create);
+	bool has_type(const QString &type_id) const { return m_entries.contains(type_id); }
+	QStringList type_ids() const { return m_order; }
+	const Entry *entry(const QString &type_id) const;
+
+	// nullptr for unknown types.
+	GraphNode *create(const QString &type_id, const QJsonObject &state = {}) const;
+
+private:
+	NodeFactory();
+	void register_standard_nodes();
+	void register_audio_nodes();
+
+	QHash<QString, Entry> m_entries;
+	QStringList m_order;	// Registration order, for menus
+};
+
+} // namespace super
@@ -6,8 +6,10 @@
 // ============================================================================
 
 #include "graph_node.hpp"
+#include "graph_compiler.hpp"
 #include "../../core/control_registry.hpp"
 
+#include <QPointer>
 #include <QtMath>
 
 namespace super {
@@ -25,15 +27,19 @@ public:
 	explicit MathNode(Op op = Add, QObject *parent = nullptr)
 		: GraphNode("math", parent), m_op(op)
 	{
-		add_input("a", "A", PinType::Number, 0.0);
-		add_input("b", "B", PinType::Number, 0.0);
-		add_output("result", "Result", PinType::Number);
+		m_a = add_input("a", "A", PinType::Number, 0.0);
+		m_b = add_input("b", "B", PinType::Number, 0.0);
+		m_result = add_output("result", "Result", PinType::Number);
 		set_display_name(op_name(op));
 	}
 
+	QJsonObject state() const override { return {{"op", int(m_op)}}; }
+
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		double a = input_value("a").toDouble();
-		double b = input_value("b").toDouble();
+		double a = input_number(m_a);
+		double b = input_number(m_b);
 		double r = 0.0;
 		switch (m_op) {
 		case Add:      r = a + b; break;
@@ -45,7 +51,16 @@ public:
 		case Min:      r = qMin(a, b); break;
 		case Max:      r = qMax(a, b); break;
 		}
-		set_output("result", r);
+		set_output_number(m_result, r);
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		static const GraphOp ops[] = {
+			GraphOp::Add, GraphOp::Sub, GraphOp::Mul, GraphOp::Div,
+			GraphOp::Pow, GraphOp::Mod, GraphOp::Min, GraphOp::Max
+		};
+		gen.emit(ops[m_op], gen.reg(m_result), gen.reg(m_a), gen.reg(m_b));
+		return true;
 	}
 
 private:
@@ -63,6 +78,7 @@ private:
 		return "Math";
 	}
 	Op m_op;
+	int m_a, m_b, m_result;
 };
 
 // ---------------------------------------------------------------------------
@@ -76,14 +92,18 @@ public:
 	explicit CompareNode(Op op = Equal, QObject *parent = nullptr)
 		: GraphNode("compare", parent), m_op(op)
 	{
-		add_input("a", "A", PinType::Number, 0.0);
-		add_input("b", "B", PinType::Number, 0.0);
-		add_output("result", "Result", PinType::Bool);
+		m_a = add_input("a", "A", PinType::Number, 0.0);
+		m_b = add_input("b", "B", PinType::Number, 0.0);
+		m_result = add_output("result", "Result", PinType::Bool);
 	}
 
+	QJsonObject state() const override { return {{"op", int(m_op)}}; }
+
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		double a = input_value("a").toDouble();
-		double b = input_value("b").toDouble();
+		double a = input_number(m_a);
+		double b = input_number(m_b);
 		bool r = false;
 		switch (m_op) {
 		case Equal:        r = qFuzzyCompare(a, b); break;
@@ -93,11 +113,21 @@ public:
 		case LessEqual:    r = a <= b; break;
 		case GreaterEqual: r = a >= b; break;
 		}
-		set_output("result", r);
+		set_output_bool(m_result, r);
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		static const GraphOp ops[] = {
+			GraphOp::Eq, GraphOp::Ne, GraphOp::Lt,
+			GraphOp::Gt, GraphOp::Le, GraphOp::Ge
+		};
+		gen.emit(ops[m_op], gen.reg(m_result), gen.reg(m_a), gen.reg(m_b));
+		return true;
 	}
 
 private:
 	Op m_op;
+	int m_a, m_b, m_result;
 };
 
 // ---------------------------------------------------------------------------
@@ -111,15 +141,18 @@ public:
 	explicit LogicGateNode(Op op = And, QObject *parent = nullptr)
 		: GraphNode("logic_gate", parent), m_op(op)
 	{
-		add_input("a", "A", PinType::Bool, false);
-		if (op != Not)
-			add_input("b", "B", PinType::Bool, false);
-		add_output("result", "Result", PinType::Bool);
+		m_a = add_input("a", "A", PinType::Bool, false);
+		m_b = op != Not ? add_input("b", "B", PinType::Bool, false) : -1;
+		m_result = add_output("result", "Result", PinType::Bool);
 	}
 
+	QJsonObject state() const override { return {{"op", int(m_op)}}; }
+
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		bool a = input_value("a").toBool();
-		bool b = input_value("b").toBool();
+		bool a = input_bool(m_a);
+		bool b = m_b >= 0 && input_bool(m_b);
 		bool r = false;
 		switch (m_op) {
 		case And: r = a && b; break;
@@ -127,11 +160,19 @@ public:
 		case Not: r = !a; break;
 		case Xor: r = a != b; break;
 		}
-		set_output("result", r);
+		set_output_bool(m_result, r);
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		static const GraphOp ops[] = { GraphOp::And, GraphOp::Or, GraphOp::Not, GraphOp::Xor };
+		int b = m_b >= 0 ? gen.reg(m_b) : 0;
+		gen.emit(ops[m_op], gen.reg(m_result), gen.reg(m_a), b);
+		return true;
 	}
 
 private:
 	Op m_op;
+	int m_a, m_b, m_result;
 };
 
 // ---------------------------------------------------------------------------
@@ -143,18 +184,27 @@ public:
 	explicit SwitchNode(QObject *parent = nullptr)
 		: GraphNode("switch", parent)
 	{
-		add_input("condition", "Condition", PinType::Bool, false);
-		add_input("true_val", "If True", PinType::Number, 1.0);
-		add_input("false_val", "If False", PinType::Number, 0.0);
-		add_output("result", "Result", PinType::Number);
+		m_cond = add_input("condition", "Condition", PinType::Bool, false);
+		m_true = add_input("true_val", "If True", PinType::Number, 1.0);
+		m_false = add_input("false_val", "If False", PinType::Number, 0.0);
+		m_result = add_output("result", "Result", PinType::Number);
 		set_display_name("Switch");
 	}
 
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		bool cond = input_value("condition").toBool();
-		set_output("result", cond ? input_value("true_val")
-								  : input_value("false_val"));
+		set_output_number(m_result, input_number(input_bool(m_cond) ? m_true : m_false));
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		gen.emit(GraphOp::Select, gen.reg(m_result),
+				 gen.reg(m_cond), gen.reg(m_true), gen.reg(m_false));
+		return true;
 	}
+
+private:
+	int m_cond, m_true, m_false, m_result;
 };
 
 // ---------------------------------------------------------------------------
@@ -166,19 +216,30 @@ public:
 	explicit ClampNode(QObject *parent = nullptr)
 		: GraphNode("clamp", parent)
 	{
-		add_input("value", "Value", PinType::Number,  0.0);
-		add_input("min",   "Min",   PinType::Number,  0.0);
-		add_input("max",   "Max",   PinType::Number,  1.0);
-		add_output("result", "Result", PinType::Number);
+		m_value  = add_input("value", "Value", PinType::Number,  0.0);
+		m_min    = add_input("min",   "Min",   PinType::Number,  0.0);
+		m_max    = add_input("max",   "Max",   PinType::Number,  1.0);
+		m_result = add_output("result", "Result", PinType::Number);
 		set_display_name("Clamp");
 	}
 
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		double v = input_value("value").toDouble();
-		double lo = input_value("min").toDouble();
-		double hi = input_value("max").toDouble();
-		set_output("result", qBound(lo, v, hi));
+		double v = input_number(m_value);
+		double lo = input_number(m_min);
+		double hi = input_number(m_max);
+		set_output_number(m_result, qBound(lo, v, hi));
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		gen.emit(GraphOp::Clamp, gen.reg(m_result),
+				 gen.reg(m_value), gen.reg(m_min), gen.reg(m_max));
+		return true;
 	}
+
+private:
+	int m_value, m_min, m_max, m_result;
 };
 
 // ---------------------------------------------------------------------------
@@ -190,34 +251,47 @@ public:
 	explicit MapRangeNode(QObject *parent = nullptr)
 		: GraphNode("map_range", parent)
 	{
-		add_input("value",    "Value",    PinType::Number, 0.0);
-		add_input("in_min",   "In Min",   PinType::Number, 0.0);
-		add_input("in_max",   "In Max",   PinType::Number, 1.0);
-		add_input("out_min",  "Out Min",  PinType::Number, 0.0);
-		add_input("out_max",  "Out Max",  PinType::Number, 100.0);
-		add_output("result",  "Result",   PinType::Number);
+		m_value   = add_input("value",    "Value",    PinType::Number, 0.0);
+		m_in_min  = add_input("in_min",   "In Min",   PinType::Number, 0.0);
+		m_in_max  = add_input("in_max",   "In Max",   PinType::Number, 1.0);
+		m_out_min = add_input("out_min",  "Out Min",  PinType::Number, 0.0);
+		m_out_max = add_input("out_max",  "Out Max",  PinType::Number, 100.0);
+		m_result  = add_output("result",  "Result",   PinType::Number);
 		set_display_name("Map Range");
 	}
 
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		double v      = input_value("value").toDouble();
-		double in_lo  = input_value("in_min").toDouble();
-		double in_hi  = input_value("in_max").toDouble();
-		double out_lo = input_value("out_min").toDouble();
-		double out_hi = input_value("out_max").toDouble();
+		double v      = input_number(m_value);
+		double in_lo  = input_number(m_in_min);
+		double in_hi  = input_number(m_in_max);
+		double out_lo = input_number(m_out_min);
+		double out_hi = input_number(m_out_max);
 
 		double span = in_hi - in_lo;
 		if (qFuzzyIsNull(span)) {
-			set_output("result", out_lo);
+			set_output_number(m_result, out_lo);
 			return;
 		}
 		double t = (v - in_lo) / span;
-		set_output("result", out_lo + t * (out_hi - out_lo));
+		set_output_number(m_result, out_lo + t * (out_hi - out_lo));
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		gen.emit(GraphOp::MapRange, gen.reg(m_result), gen.reg(m_value),
+				 gen.reg(m_in_min), gen.reg(m_in_max),
+				 gen.reg(m_out_min), gen.reg(m_out_max));
+		return true;
 	}
+
+private:
+	int m_value, m_in_min, m_in_max, m_out_min, m_out_max, m_result;
 };
 
 // ---------------------------------------------------------------------------
 // PortReadNode — Reads a ControlPort value from the Registry.
+// Outputs: Value (Number), Changed (Event, fires once per port change)
 // ---------------------------------------------------------------------------
 class PortReadNode : public GraphNode {
 	Q_OBJECT
@@ -226,19 +300,38 @@ public:
 						   QObject *parent = nullptr)
 		: GraphNode("port_read", parent), m_port_id(port_id)
 	{
-		add_output("value", "Value", PinType::Number);
+		m_out = add_output("value", "Value", PinType::Number);
+		m_changed = add_output("changed", "Changed", PinType::Event);
 		set_display_name("Read: " + port_id);
 	}
 
-	void set_port_id(const QString &id) { m_port_id = id; }
+	void set_port_id(const QString &id) { m_port_id = id; mark_dirty(); }
+
+	QJsonObject state() const override { return {{"port", m_port_id}}; }
 
 	void process() override {
 		auto *port = ControlRegistry::instance().find(m_port_id);
-		set_output("value", port ? port->as_double() : 0.0);
+		if (port != m_port) {
+			QObject::disconnect(m_subscription);
+			m_port = port;
+			// Port changes wake the node; no per-frame polling
+			if (port)
+				m_subscription = connect(port, &ControlPort::value_changed,
+										 this, [this]() { m_pending_changes++; mark_dirty(); });
+		}
+		if (!port)
+			request_reevaluate();  // Not registered yet: keep looking
+		set_output_number(m_out, port ? port->as_double() : 0.0);
+		fire_event(m_changed, m_pending_changes);
+		m_pending_changes = 0;
 	}
 
 private:
 	QString m_port_id;
+	int m_out, m_changed;
+	int m_pending_changes = 0;	// Port changes since the last pass
+	QPointer<ControlPort> m_port;
+	QMetaObject::Connection m_subscription;
 };
 
 // ---------------------------------------------------------------------------
@@ -251,20 +344,23 @@ public:
 							QObject *parent = nullptr)
 		: GraphNode("port_write", parent), m_port_id(port_id)
 	{
-		add_input("value", "Value", PinType::Number, 0.0);
+		m_in = add_input("value", "Value", PinType::Number, 0.0);
 		set_display_name("Write: " + port_id);
 	}
 
-	void set_port_id(const QString &id) { m_port_id = id; }
+	void set_port_id(const QString &id) { m_port_id = id; mark_dirty(); }
+
+	QJsonObject state() const override { return {{"port", m_port_id}}; }
 
 	void process() override {
 		auto *port = ControlRegistry::instance().find(m_port_id);
 		if (port)
-			port->set_value(input_value("value"));
+			port->set_value(input_number(m_in));
 	}
 
 private:
 	QString m_port_id;
+	int m_in;
 };
 
 // ---------------------------------------------------------------------------
@@ -276,14 +372,24 @@ public:
 	explicit ConstantNode(double value = 0.0, QObject *parent = nullptr)
 		: GraphNode("constant", parent)
 	{
-		add_output("value", "Value", PinType::Number);
+		m_out = add_output("value", "Value", PinType::Number);
 		set_display_name("Constant");
-		set_output("value", value);
+		set_output_number(m_out, value);
 	}
 
+	QJsonObject state() const override { return {{"value", pin(m_out).value.number}}; }
+
+	bool is_pure() const override { return true; }
+
 	void process() override {
 		// Output is already set; no-op unless overridden.
 	}
+
+	// The output register is seeded with the value; nothing to run.
+	bool lower(GraphCodegen &) const override { return true; }
+
+private:
+	int m_out;
 };
 
 // ---------------------------------------------------------------------------
@@ -295,20 +401,32 @@ public:
 	explicit SmoothNode(QObject *parent = nullptr)
 		: GraphNode("smooth", parent)
 	{
-		add_input("input", "Input", PinType::Number, 0.0);
-		add_input("alpha", "Smoothing", PinType::Number, 0.8);
-		add_output("output", "Output", PinType::Number);
+		m_in    = add_input("input", "Input", PinType::Number, 0.0);
+		m_alpha = add_input("alpha", "Smoothing", PinType::Number, 0.8);
+		m_out   = add_output("output", "Output", PinType::Number);
 		set_display_name("Smooth");
 	}
 
+	bool is_pure() const override { return true; }
+
 	void process() override {
-		double in = input_value("input").toDouble();
-		double a = qBound(0.0, input_value("alpha").toDouble(), 1.0);
+		double in = input_number(m_in);
+		double a = qBound(0.0, input_number(m_alpha), 1.0);
 		m_prev = a * m_prev + (1.0 - a) * in;
-		set_output("output", m_prev);
+		if (std::abs(m_prev - in) < 1e-6)
+			m_prev = in;
+		else if (a < 1.0)
+			request_reevaluate();  // Still settling towards the input
+		set_output_number(m_out, m_prev);
+	}
+
+	bool lower(GraphCodegen &gen) const override {
+		gen.emit(GraphOp::Smooth, gen.reg(m_out), gen.reg(m_in), gen.reg(m_alpha));
+		return true;
 	}
 
 private:
+	int m_in, m_alpha, m_out;
 	double m_prev = 0.0;
 };
 
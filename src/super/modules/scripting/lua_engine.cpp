@@ -1,23 +1,86 @@
 // ============================================================================
-// Lua Scripting Engine — Stub Implementation
+// Lua Scripting Engine — Implementation
 //
-// This compiles without Lua linked. Once lua54 is added to CMake,
-// uncomment the #include and replace the stubs with real calls.
+// Real Lua 5.4 when built with SUPER_HAS_LUA (CMake option ENABLE_LUA);
+// otherwise every entry point reports that Lua isn't linked.
 // ============================================================================
 
 #include "lua_engine.hpp"
+#include "../../core/control_port.hpp"
+#include "../../core/control_registry.hpp"
+#include "../../core/control_variable.hpp"
+#include "../../core/task_scheduler.hpp"
+#include "../graph/graph_node.hpp"
+#include "../time/master_clock.hpp"
 
-// #include <lua.hpp>   // Uncomment when Lua is linked
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+#if SUPER_HAS_LUA
+#include <lua.hpp>
+#endif
 
 namespace super {
 
+// The hook fires every kHookStep instructions, so budgets and instruction
+// counts have that granularity.
+static constexpr int kHookStep = 1000;
+
 // ---------------------------------------------------------------------------
-// PIMPL (holds lua_State* when Lua is linked)
+// PIMPL
 // ---------------------------------------------------------------------------
 struct LuaEngine::Impl {
-	// lua_State *L = nullptr;   // Uncomment when Lua is linked
+	LuaEngine *self = nullptr;
+#if SUPER_HAS_LUA
+	lua_State *L = nullptr;
+#endif
 	QString last_error;
 	bool initialized = false;
+
+	QString cache_dir;
+	QHash<QByteArray, int> chunks;		// Content key → registry ref of the compiled chunk
+	QPointer<GraphEngine> graph;
+
+	qint64 budget = 10'000'000;
+	qint64 steps_left = 0;				// Hook steps left in this invocation
+	qint64 steps_used = 0;
+	bool over_budget = false;
+
+	QString current;					// Script being run (stats / timer owner)
+	QHash<QString, ScriptStats> stats;
+
+	struct Timer { QTimer *timer; int fn_ref; QString owner; };
+	QHash<int, Timer> timers;
+	int next_timer = 1;
+
+	// Coroutine tasks (super.spawn), parked in TaskScheduler while waiting
+	struct Task {
+		void *thread;				// lua_State of the coroutine
+		int ref;					// Keeps the thread alive
+		QString owner;
+		TaskScheduler::WaitId wait = 0;
+	};
+	QHash<int, Task> tasks;
+	QHash<void *, int> task_of;		// Coroutine → task id
+	int next_task = 1;
+
+#if SUPER_HAS_LUA
+	bool call(int nargs, const QString &owner);
+	bool load(const QByteArray &source, const QString &name);
+	void begin_invocation(const QString &owner);
+	void end_invocation(const QString &owner, qint64 ns);
+	void resume_task(int id, int nargs);
+	void end_task(int id);
+#endif
 };
 
 // ---------------------------------------------------------------------------
@@ -27,6 +90,10 @@ struct LuaEngine::Impl {
 LuaEngine::LuaEngine(QObject *parent)
 	: QObject(parent), m_impl(new Impl)
 {
+	m_impl->self = this;
+	QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if (!base.isEmpty())
+		m_impl->cache_dir = base + "/lua";
 	init();
 }
 
@@ -37,96 +104,832 @@ LuaEngine::~LuaEngine()
 }
 
 // ---------------------------------------------------------------------------
-// Initialization (stubbed)
+// Settings / Stats
 // ---------------------------------------------------------------------------
 
-void LuaEngine::init()
+void LuaEngine::set_instruction_budget(qint64 instructions)
+{
+	m_impl->budget = qMax<qint64>(0, instructions);
+}
+
+qint64 LuaEngine::instruction_budget() const
+{
+	return m_impl->budget;
+}
+
+void LuaEngine::set_cache_dir(const QString &dir)
+{
+	m_impl->cache_dir = dir;
+}
+
+QString LuaEngine::cache_dir() const
+{
+	return m_impl->cache_dir;
+}
+
+void LuaEngine::set_graph(GraphEngine *graph)
+{
+	m_impl->graph = graph;
+}
+
+QHash<QString, LuaEngine::ScriptStats> LuaEngine::script_stats() const
+{
+	return m_impl->stats;
+}
+
+void LuaEngine::reset_stats()
+{
+	m_impl->stats.clear();
+}
+
+QString LuaEngine::stats_report() const
+{
+	QStringList names = m_impl->stats.keys();
+	std::sort(names.begin(), names.end(), [this](const QString &a, const QString &b) {
+		return m_impl->stats[a].total_ns > m_impl->stats[b].total_ns;
+	});
+
+	QStringList lines;
+	for (const QString &name : names) {
+		const ScriptStats &s = m_impl->stats[name];
+		lines.append(QString("%1: %2 ms total, %3 calls, avg %4 µs, max %5 µs, ~%6 instr%7")
+			.arg(name)
+			.arg(s.total_ns / 1e6, 0, 'f', 2)
+			.arg(s.calls)
+			.arg(s.calls ? s.total_ns / 1e3 / s.calls : 0.0, 0, 'f', 1)
+			.arg(s.max_ns / 1e3, 0, 'f', 1)
+			.arg(s.instructions)
+			.arg(s.budget_hits ? QString(", %1 over budget").arg(s.budget_hits) : QString()));
+	}
+	return lines.join('\n');
+}
+
+QString LuaEngine::last_error() const
+{
+	return m_impl->last_error;
+}
+
+bool LuaEngine::is_initialized() const
+{
+	return m_impl->initialized;
+}
+
+#if SUPER_HAS_LUA
+
+// ===========================================================================
+// Lua build
+// ===========================================================================
+
+static LuaEngine::Impl *impl_of(lua_State *L)
+{
+	return *static_cast<LuaEngine::Impl **>(lua_getextraspace(L));
+}
+
+// ---------------------------------------------------------------------------
+// Value conversion
+// ---------------------------------------------------------------------------
+
+static void push_variant(lua_State *L, const QVariant &v)
+{
+	switch (v.typeId()) {
+	case QMetaType::Bool:
+		lua_pushboolean(L, v.toBool());
+		break;
+	case QMetaType::Int:
+	case QMetaType::LongLong:
+	case QMetaType::UInt:
+	case QMetaType::ULongLong:
+		lua_pushinteger(L, v.toLongLong());
+		break;
+	case QMetaType::Double:
+	case QMetaType::Float:
+		lua_pushnumber(L, v.toDouble());
+		break;
+	case QMetaType::QString:
+	case QMetaType::QByteArray:
+		lua_pushstring(L, v.toString().toUtf8().constData());
+		break;
+	default:
+		if (v.isValid() && v.canConvert<double>())
+			lua_pushnumber(L, v.toDouble());
+		else
+			lua_pushnil(L);
+		break;
+	}
+}
+
+static QVariant to_variant(lua_State *L, int idx)
+{
+	switch (lua_type(L, idx)) {
+	case LUA_TBOOLEAN:
+		return QVariant(static_cast<bool>(lua_toboolean(L, idx)));
+	case LUA_TNUMBER:
+		return lua_isinteger(L, idx) ? QVariant(static_cast<qlonglong>(lua_tointeger(L, idx)))
+									 : QVariant(lua_tonumber(L, idx));
+	case LUA_TSTRING:
+		return QVariant(QString::fromUtf8(lua_tostring(L, idx)));
+	default:
+		return {};
+	}
+}
+
+static QString check_qstring(lua_State *L, int idx)
+{
+	return QString::fromUtf8(luaL_checkstring(L, idx));
+}
+
+// ---------------------------------------------------------------------------
+// Port handles — userdata holding a QPointer, so a destroyed port reads nil
+// ---------------------------------------------------------------------------
+
+static const char *kPortMeta = "super.Port";
+
+struct PortHandle {
+	QPointer<ControlPort> port;
+};
+
+static ControlPort *check_port(lua_State *L, int idx)
+{
+	auto *h = static_cast<PortHandle *>(luaL_checkudata(L, idx, kPortMeta));
+	return h->port.data();
+}
+
+static int port_get(lua_State *L)
+{
+	ControlPort *p = check_port(L, 1);
+	if (p)
+		push_variant(L, p->value());
+	else
+		lua_pushnil(L);
+	return 1;
+}
+
+static int port_set(lua_State *L)
+{
+	if (ControlPort *p = check_port(L, 1))
+		p->set_value(to_variant(L, 2));
+	return 0;
+}
+
+static int port_id(lua_State *L)
+{
+	ControlPort *p = check_port(L, 1);
+	lua_pushstring(L, p ? p->id().toUtf8().constData() : "");
+	return 1;
+}
+
+static int port_valid(lua_State *L)
+{
+	lua_pushboolean(L, check_port(L, 1) != nullptr);
+	return 1;
+}
+
+static int port_gc(lua_State *L)
+{
+	static_cast<PortHandle *>(luaL_checkudata(L, 1, kPortMeta))->~PortHandle();
+	return 0;
+}
+
+// ---------------------------------------------------------------------------
+// super.* functions
+// ---------------------------------------------------------------------------
+
+static int l_get(lua_State *L)
+{
+	ControlPort *p = ControlRegistry::instance().find(check_qstring(L, 1));
+	if (p)
+		push_variant(L, p->value());
+	else
+		lua_pushnil(L);
+	return 1;
+}
+
+static int l_set(lua_State *L)
+{
+	if (ControlPort *p = ControlRegistry::instance().find(check_qstring(L, 1)))
+		p->set_value(to_variant(L, 2));
+	return 0;
+}
+
+static int l_port(lua_State *L)
+{
+	ControlPort *p = ControlRegistry::instance().find(check_qstring(L, 1));
+	if (!p) {
+		lua_pushnil(L);
+		return 1;
+	}
+	void *mem = lua_newuserdatauv(L, sizeof(PortHandle), 0);
+	new (mem) PortHandle{p};
+	luaL_setmetatable(L, kPortMeta);
+	return 1;
+}
+
+// super.get_many({"a", "b"}) → {va, vb}
+static int l_get_many(lua_State *L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	auto &registry = ControlRegistry::instance();
+	const lua_Integer n = luaL_len(L, 1);
+	lua_createtable(L, static_cast<int>(n), 0);
+	for (lua_Integer i = 1; i <= n; i++) {
+		lua_geti(L, 1, i);
+		ControlPort *p = lua_isstring(L, -1)
+			? registry.find(QString::fromUtf8(lua_tostring(L, -1))) : nullptr;
+		lua_pop(L, 1);
+		if (p)
+			push_variant(L, p->value());
+		else
+			lua_pushnil(L);
+		lua_seti(L, -2, i);
+	}
+	return 1;
+}
+
+// super.set_many({["a"] = 1, ["b"] = true})
+static int l_set_many(lua_State *L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+	auto &registry = ControlRegistry::instance();
+	lua_pushnil(L);
+	while (lua_next(L, 1) != 0) {
+		if (lua_type(L, -2) == LUA_TSTRING) {
+			if (ControlPort *p = registry.find(QString::fromUtf8(lua_tostring(L, -2))))
+				p->set_value(to_variant(L, -1));
+		}
+		lua_pop(L, 1);
+	}
+	return 0;
+}
+
+static int l_var(lua_State *L)
+{
+	ControlVariable *v = ControlRegistry::instance().find_variable(check_qstring(L, 1));
+	if (v)
+		push_variant(L, v->value());
+	else
+		lua_pushnil(L);
+	return 1;
+}
+
+static int l_set_var(lua_State *L)
+{
+	if (ControlVariable *v = ControlRegistry::instance().find_variable(check_qstring(L, 1)))
+		v->set_value(to_variant(L, 2));
+	return 0;
+}
+
+static int l_modifier(lua_State *L)
+{
+	lua_pushboolean(L, ControlRegistry::instance().modifier(check_qstring(L, 1)));
+	return 1;
+}
+
+static int l_log(lua_State *L)
+{
+	emit impl_of(L)->self->log_message(QString::fromUtf8(luaL_tolstring(L, 1, nullptr)));
+	return 0;
+}
+
+// -- Graph --
+
+static GraphNode *check_node(lua_State *L, int idx)
+{
+	GraphEngine *g = impl_of(L)->graph;
+	return g ? g->find_node(QUuid::fromString(check_qstring(L, idx))) : nullptr;
+}
+
+// super.graph_get(node_uuid, pin_id) → value
+static int l_graph_get(lua_State *L)
+{
+	GraphNode *node = check_node(L, 1);
+	const Pin *pin = node ? node->find_pin(check_qstring(L, 2)) : nullptr;
+	if (pin)
+		push_variant(L, pin->to_variant());
+	else
+		lua_pushnil(L);
+	return 1;
+}
+
+// super.graph_set(node_uuid, pin_id, value) — sets an unconnected input
+static int l_graph_set(lua_State *L)
 {
-	// When Lua is linked:
-	// m_impl->L = luaL_newstate();
-	// luaL_openlibs(m_impl->L);
-	// register_api();
-	// m_impl->initialized = true;
+	GraphNode *node = check_node(L, 1);
+	Pin *pin = node ? node->find_pin(check_qstring(L, 2)) : nullptr;
+	if (pin && pin->is_input() && pin->assign(to_variant(L, 3)))
+		node->mark_dirty();
+	return 0;
+}
+
+static int l_graph_evaluate(lua_State *L)
+{
+	if (GraphEngine *g = impl_of(L)->graph)
+		g->evaluate();
+	return 0;
+}
+
+// -- Scheduler --
+
+static int add_timer(lua_State *L, bool repeat)
+{
+	LuaEngine::Impl *d = impl_of(L);
+	const int ms = static_cast<int>(luaL_checkinteger(L, 1));
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+	lua_pushvalue(L, 2);
+	const int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	const int id = d->next_timer++;
+
+	auto *t = new QTimer(d->self);
+	t->setSingleShot(!repeat);
+	t->setInterval(qMax(0, ms));
+	d->timers.insert(id, {t, ref, d->current});
+	QObject::connect(t, &QTimer::timeout, d->self, [d, id]() {
+		auto it = d->timers.find(id);
+		if (it == d->timers.end())
+			return;
+		const LuaEngine::Impl::Timer timer = it.value();
+		if (timer.timer->isSingleShot()) {
+			d->timers.erase(it);
+			timer.timer->deleteLater();
+		}
+		lua_rawgeti(d->L, LUA_REGISTRYINDEX, timer.fn_ref);
+		if (timer.timer->isSingleShot())
+			luaL_unref(d->L, LUA_REGISTRYINDEX, timer.fn_ref);
+		d->call(0, timer.owner);
+	});
+	t->start();
 
-	m_impl->initialized = false;  // Stub: not yet functional
+	lua_pushinteger(L, id);
+	return 1;
+}
+
+static int l_after(lua_State *L) { return add_timer(L, false); }
+static int l_every(lua_State *L) { return add_timer(L, true); }
+
+static int l_cancel(lua_State *L)
+{
+	LuaEngine::Impl *d = impl_of(L);
+	auto it = d->timers.find(static_cast<int>(luaL_checkinteger(L, 1)));
+	if (it != d->timers.end()) {
+		it->timer->stop();
+		it->timer->deleteLater();
+		luaL_unref(L, LUA_REGISTRYINDEX, it->fn_ref);
+		d->timers.erase(it);
+	}
+	return 0;
+}
+
+static int l_bpm(lua_State *L)
+{
+	lua_pushnumber(L, MasterClock::instance().bpm());
+	return 1;
+}
+
+static int l_beat(lua_State *L)
+{
+	lua_pushnumber(L, MasterClock::instance().beat_position());
+	return 1;
+}
+
+// -- Coroutine tasks --
+
+// super.spawn(fn, ...) → task id
+static int l_spawn(lua_State *L)
+{
+	LuaEngine::Impl *d = impl_of(L);
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	const int nargs = lua_gettop(L) - 1;
+
+	lua_State *co = lua_newthread(d->L);
+	const int ref = luaL_ref(d->L, LUA_REGISTRYINDEX);
+	lua_pushvalue(L, 1);
+	for (int i = 2; i <= nargs + 1; i++)
+		lua_pushvalue(L, i);
+	lua_xmove(L, co, nargs + 1);
+
+	const int id = d->next_task++;
+	d->tasks.insert(id, {co, ref, d->current, 0});
+	d->task_of.insert(co, id);
+	d->resume_task(id, nargs);
+
+	lua_pushinteger(L, id);
+	return 1;
+}
+
+// super.kill(task id)
+static int l_kill(lua_State *L)
+{
+	LuaEngine::Impl *d = impl_of(L);
+	const int id = static_cast<int>(luaL_checkinteger(L, 1));
+	auto it = d->tasks.constFind(id);
+	if (it != d->tasks.constEnd() && it->thread == L)
+		return luaL_error(L, "a task cannot kill itself; return instead");
+	d->end_task(id);
+	return 0;
+}
+
+// Parks the calling task with `wait` and yields. Resumes with the `ok`
+// flag (false if a watched port was destroyed).
+template <typename Register>
+static int park(lua_State *L, Register &&wait)
+{
+	LuaEngine::Impl *d = impl_of(L);
+	const int id = d->task_of.value(L, 0);
+	if (!id || !lua_isyieldable(L))
+		return luaL_error(L, "super.wait* can only be called from a super.spawn task");
+
+	QPointer<LuaEngine> guard(d->self);
+	d->tasks[id].wait = wait([d, guard, id](bool ok) {
+		if (!guard)
+			return;
+		auto it = d->tasks.find(id);
+		if (it == d->tasks.end())
+			return;
+		lua_pushboolean(static_cast<lua_State *>(it->thread), ok);
+		d->resume_task(id, 1);
+	});
+	return lua_yield(L, 0);
+}
+
+static int l_wait(lua_State *L)
+{
+	const qint64 ms = luaL_checkinteger(L, 1);
+	return park(L, [ms](TaskScheduler::Resume r) { return TaskScheduler::instance().wait_ms(ms, std::move(r)); });
+}
+
+static int l_wait_frames(lua_State *L)
+{
+	const int frames = static_cast<int>(luaL_optinteger(L, 1, 1));
+	return park(L, [frames](TaskScheduler::Resume r) { return TaskScheduler::instance().wait_frames(frames, std::move(r)); });
+}
+
+static int l_wait_beats(lua_State *L)
+{
+	const double beats = luaL_checknumber(L, 1);
+	return park(L, [beats](TaskScheduler::Resume r) { return TaskScheduler::instance().wait_beats(beats, std::move(r)); });
+}
+
+// super.wait_until(port id | handle, op, value); op is one of
+// ">", ">=", "<", "<=", "==", "~=", "changed"
+static int l_wait_until(lua_State *L)
+{
+	ControlPort *port = lua_isuserdata(L, 1) ? check_port(L, 1)
+		: ControlRegistry::instance().find(check_qstring(L, 1));
+	static const char *const ops[] = {">", ">=", "<", "<=", "==", "~=", "changed", nullptr};
+	const auto cmp = static_cast<WaitCompare>(luaL_checkoption(L, 2, "changed", ops));
+	const double value = luaL_optnumber(L, 3, 0.0);
+	return park(L, [port, cmp, value](TaskScheduler::Resume r) {
+		return TaskScheduler::instance().wait_port(port, cmp, value, std::move(r));
+	});
+}
+
+// ---------------------------------------------------------------------------
+// Budget hook and protected calls
+// ---------------------------------------------------------------------------
+
+static void count_hook(lua_State *L, lua_Debug *)
+{
+	LuaEngine::Impl *d = impl_of(L);
+	d->steps_used++;
+	if (d->budget > 0 && --d->steps_left < 0) {
+		d->over_budget = true;
+		luaL_error(L, "instruction budget exceeded (%I)", static_cast<lua_Integer>(d->budget));
+	}
+}
+
+static int traceback(lua_State *L)
+{
+	luaL_traceback(L, L, lua_tostring(L, 1), 1);
+	return 1;
+}
+
+void LuaEngine::Impl::begin_invocation(const QString &owner)
+{
+	current = owner;
+	steps_left = budget > 0 ? (budget + kHookStep - 1) / kHookStep : 0;
+	steps_used = 0;
+	over_budget = false;
+}
+
+void LuaEngine::Impl::end_invocation(const QString &owner, qint64 ns)
+{
+	ScriptStats &s = stats[owner];
+	s.calls++;
+	s.total_ns += ns;
+	s.max_ns = qMax(s.max_ns, ns);
+	s.instructions += static_cast<quint64>(steps_used) * kHookStep;
+	if (over_budget)
+		s.budget_hits++;
+}
+
+// Calls the function below `nargs` arguments on the stack, charging the
+// time to `owner`. Nested calls (a script calling graph_evaluate that runs
+// nothing Lua-side) are charged to the outer invocation only.
+bool LuaEngine::Impl::call(int nargs, const QString &owner)
+{
+	const int base = lua_gettop(L) - nargs;
+	lua_pushcfunction(L, traceback);
+	lua_insert(L, base);
+
+	const QString prev = current;
+	begin_invocation(owner);
+	const auto t0 = std::chrono::steady_clock::now();
+	const int status = lua_pcall(L, nargs, 0, base);
+	end_invocation(owner, std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count());
+	current = prev;
+
+	lua_remove(L, base);
+	if (status != LUA_OK) {
+		last_error = QString("%1: %2").arg(owner, QString::fromUtf8(lua_tostring(L, -1)));
+		lua_pop(L, 1);
+		emit self->script_error(last_error);
+		return false;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// Coroutine tasks. A task runs until it calls one of the super.wait*
+// functions, which park it in TaskScheduler and yield; the scheduler's frame
+// batch resumes it with the wait's `ok` flag. Each resume is a separate
+// invocation with its own instruction budget.
+// ---------------------------------------------------------------------------
+
+void LuaEngine::Impl::resume_task(int id, int nargs)
+{
+	auto it = tasks.find(id);
+	if (it == tasks.end())
+		return;
+	lua_State *co = static_cast<lua_State *>(it->thread);
+	const QString owner = it->owner;
+	it->wait = 0;
+
+	// super.spawn resumes from inside another invocation; keep its budget
+	const QString prev = current;
+	const qint64 prev_left = steps_left, prev_used = steps_used;
+	const bool prev_over = over_budget;
+	begin_invocation(owner);
+	int nres = 0;
+	const auto t0 = std::chrono::steady_clock::now();
+	const int status = lua_resume(co, L, nargs, &nres);
+	end_invocation(owner, std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - t0).count());
+	current = prev;
+	steps_left = prev_left;
+	steps_used = prev_used;
+	over_budget = prev_over;
+
+	if (status == LUA_YIELD) {
+		lua_pop(co, nres);
+		// A bare coroutine.yield() (no super.wait*) means "next frame"
+		auto t = tasks.find(id);
+		if (t != tasks.end() && t->wait == 0) {
+			QPointer<LuaEngine> guard(self);
+			t->wait = TaskScheduler::instance().wait_frames(1, [this, guard, id](bool) {
+				if (guard)
+					resume_task(id, 0);
+			});
+		}
+		return;
+	}
+	if (status != LUA_OK) {
+		luaL_traceback(L, co, lua_tostring(co, -1), 0);
+		last_error = QString("%1: %2").arg(owner, QString::fromUtf8(lua_tostring(L, -1)));
+		lua_pop(L, 1);
+		emit self->script_error(last_error);
+	}
+	end_task(id);
+}
+
+void LuaEngine::Impl::end_task(int id)
+{
+	auto it = tasks.find(id);
+	if (it == tasks.end())
+		return;
+	if (it->wait)
+		TaskScheduler::instance().cancel(it->wait);
+	task_of.remove(it->thread);
+	luaL_unref(L, LUA_REGISTRYINDEX, it->ref);
+	tasks.erase(it);
+}
+
+// ---------------------------------------------------------------------------
+// Chunk loading: memory cache → disk bytecode cache → parse (then store).
+// Leaves the chunk function on the stack on success.
+// ---------------------------------------------------------------------------
+
+static int dump_writer(lua_State *, const void *p, size_t size, void *ud)
+{
+	static_cast<QByteArray *>(ud)->append(static_cast<const char *>(p), static_cast<qsizetype>(size));
+	return 0;
+}
+
+bool LuaEngine::Impl::load(const QByteArray &source, const QString &name)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+	hash.addData(QByteArray::number(LUA_VERSION_NUM));
+	hash.addData(name.toUtf8());
+	hash.addData(source);
+	const QByteArray key = hash.result().toHex();
+
+	auto it = chunks.constFind(key);
+	if (it != chunks.constEnd()) {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, it.value());
+		return true;
+	}
+
+	const QByteArray chunkname = "@" + name.toUtf8();
+	const QString cache_path = cache_dir.isEmpty() ? QString() : cache_dir + "/" + key + ".luac";
+	bool loaded = false;
+
+	if (!cache_path.isEmpty()) {
+		QFile f(cache_path);
+		if (f.open(QIODevice::ReadOnly)) {
+			const QByteArray code = f.readAll();
+			loaded = luaL_loadbufferx(L, code.constData(), code.size(), chunkname.constData(), "b") == LUA_OK;
+			if (!loaded) {
+				lua_pop(L, 1);	// Stale or foreign bytecode: recompile
+				f.close();
+				f.remove();
+			}
+		}
+	}
+
+	if (!loaded) {
+		if (luaL_loadbufferx(L, source.constData(), source.size(), chunkname.constData(), "t") != LUA_OK) {
+			last_error = QString::fromUtf8(lua_tostring(L, -1));
+			lua_pop(L, 1);
+			emit self->script_error(last_error);
+			return false;
+		}
+		if (!cache_path.isEmpty() && QDir().mkpath(cache_dir)) {
+			QByteArray code;
+			lua_dump(L, dump_writer, &code, 0);
+			QSaveFile out(cache_path);
+			if (out.open(QIODevice::WriteOnly)) {
+				out.write(code);
+				out.commit();
+			}
+		}
+	}
+
+	lua_pushvalue(L, -1);
+	chunks.insert(key, luaL_ref(L, LUA_REGISTRYINDEX));
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// Initialization
+// ---------------------------------------------------------------------------
+
+void LuaEngine::init()
+{
+	lua_State *L = luaL_newstate();
+	if (!L) {
+		m_impl->last_error = "Lua state allocation failed";
+		return;
+	}
+	*static_cast<Impl **>(lua_getextraspace(L)) = m_impl;
+	luaL_openlibs(L);
+	lua_sethook(L, count_hook, LUA_MASKCOUNT, kHookStep);
+	m_impl->L = L;
+	register_api();
+	m_impl->initialized = true;
 }
 
 void LuaEngine::register_api()
 {
-	// This will expose C functions to Lua:
-	//   super.get(port_id)          -> double
-	//   super.set(port_id, value)   -> void
-	//   super.var(var_id)           -> double
-	//   super.set_var(var_id, val)  -> void
-	//   super.modifier(mod_id)     -> bool
-	//   super.log(message)         -> void
+	lua_State *L = m_impl->L;
+
+	static const luaL_Reg port_methods[] = {
+		{"get", port_get},
+		{"set", port_set},
+		{"id", port_id},
+		{"valid", port_valid},
+		{nullptr, nullptr},
+	};
+	luaL_newmetatable(L, kPortMeta);
+	luaL_newlib(L, port_methods);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, port_gc);
+	lua_setfield(L, -2, "__gc");
+	lua_pop(L, 1);
+
+	static const luaL_Reg api[] = {
+		{"get", l_get},
+		{"set", l_set},
+		{"port", l_port},
+		{"get_many", l_get_many},
+		{"set_many", l_set_many},
+		{"var", l_var},
+		{"set_var", l_set_var},
+		{"modifier", l_modifier},
+		{"log", l_log},
+		{"graph_get", l_graph_get},
+		{"graph_set", l_graph_set},
+		{"graph_evaluate", l_graph_evaluate},
+		{"after", l_after},
+		{"every", l_every},
+		{"cancel", l_cancel},
+		{"bpm", l_bpm},
+		{"beat", l_beat},
+		{"spawn", l_spawn},
+		{"kill", l_kill},
+		{"wait", l_wait},
+		{"wait_frames", l_wait_frames},
+		{"wait_beats", l_wait_beats},
+		{"wait_until", l_wait_until},
+		{nullptr, nullptr},
+	};
+	luaL_newlib(L, api);
+	lua_setglobal(L, "super");
 }
 
 void LuaEngine::shutdown()
 {
-	// if (m_impl->L) {
-	//     lua_close(m_impl->L);
-	//     m_impl->L = nullptr;
-	// }
+	for (const auto &t : std::as_const(m_impl->timers))
+		delete t.timer;
+	m_impl->timers.clear();
+	for (const auto &t : std::as_const(m_impl->tasks))
+		if (t.wait)
+			TaskScheduler::instance().cancel(t.wait);
+	m_impl->tasks.clear();
+	m_impl->task_of.clear();
+	m_impl->chunks.clear();
+	if (m_impl->L) {
+		lua_close(m_impl->L);
+		m_impl->L = nullptr;
+	}
 	m_impl->initialized = false;
 }
 
 // ---------------------------------------------------------------------------
-// Script Execution (stubbed)
+// Script Execution
 // ---------------------------------------------------------------------------
 
-bool LuaEngine::run(const QString &script)
+bool LuaEngine::run(const QString &script, const QString &name)
 {
-	Q_UNUSED(script);
-
 	if (!m_impl->initialized) {
-		m_impl->last_error = "Lua engine not initialized (library not linked)";
+		m_impl->last_error = "Lua engine not initialized";
 		emit script_error(m_impl->last_error);
 		return false;
 	}
 
-	// int status = luaL_dostring(m_impl->L, script.toUtf8().constData());
-	// if (status != LUA_OK) {
-	//     m_impl->last_error = lua_tostring(m_impl->L, -1);
-	//     lua_pop(m_impl->L, 1);
-	//     emit script_error(m_impl->last_error);
-	//     return false;
-	// }
-	return true;
+	const QByteArray source = script.toUtf8();
+	const QString label = name.isEmpty()
+		? "chunk:" + QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex().left(8)
+		: name;
+	if (!m_impl->load(source, label))
+		return false;
+	return m_impl->call(0, label);
 }
 
 bool LuaEngine::run_file(const QString &path)
 {
-	Q_UNUSED(path);
-
-	if (!m_impl->initialized) {
-		m_impl->last_error = "Lua engine not initialized (library not linked)";
+	QFile f(path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		m_impl->last_error = QString("Cannot open %1").arg(path);
 		emit script_error(m_impl->last_error);
 		return false;
 	}
+	return run(QString::fromUtf8(f.readAll()), QFileInfo(path).fileName());
+}
 
-	// int status = luaL_dofile(m_impl->L, path.toUtf8().constData());
-	// if (status != LUA_OK) {
-	//     m_impl->last_error = lua_tostring(m_impl->L, -1);
-	//     lua_pop(m_impl->L, 1);
-	//     emit script_error(m_impl->last_error);
-	//     return false;
-	// }
-	return true;
+#else // !SUPER_HAS_LUA
+
+// ===========================================================================
+// Stub build
+// ===========================================================================
+
+void LuaEngine::init()
+{
+	m_impl->initialized = false;
 }
 
-// ---------------------------------------------------------------------------
-// Error Reporting
-// ---------------------------------------------------------------------------
+void LuaEngine::register_api()
+{
+}
 
-QString LuaEngine::last_error() const
+void LuaEngine::shutdown()
 {
-	return m_impl->last_error;
+	m_impl->initialized = false;
 }
 
-bool LuaEngine::is_initialized() const
+bool LuaEngine::run(const QString &script, const QString &name)
 {
-	return m_impl->initialized;
+	Q_UNUSED(script);
+	Q_UNUSED(name);
+	m_impl->last_error = "Lua engine not initialized (library not linked)";
+	emit script_error(m_impl->last_error);
+	return false;
+}
+
+bool LuaEngine::run_file(const QString &path)
+{
+	Q_UNUSED(path);
+	return run(QString());
 }
 
+#endif // SUPER_HAS_LUA
+
 } // namespace super
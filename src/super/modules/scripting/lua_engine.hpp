@@ -3,23 +3,33 @@
 // ============================================================================
 // Lua Scripting Engine — Bindings for the Control API.
 //
-// Embeds Lua 5.4 and exposes:
-//   • ControlRegistry port read/write
+// Embeds Lua 5.4 and exposes a global `super` table:
+//   • ControlRegistry port read/write, port handles and batched access
 //   • Variable management
 //   • Modifier state queries
+//   • Graph pin access and evaluation
+//   • Timers on the Qt event loop and the master clock
+//   • Coroutine tasks (super.spawn) with frame-batched waits on time,
+//     beats and port conditions (see TaskScheduler)
 //   • Logging
 //
-// NOTE: Lua 5.4 is NOT yet linked. This header defines the interface;
-//       the implementation stub compiles without Lua and will be activated
-//       once the Lua library is added to CMake.
+// Chunks are compiled once per engine and their bytecode is cached on disk
+// by content hash, so a restart skips the parser. Every invocation (script
+// run or timer callback) gets an instruction budget; a script that runs
+// past it is aborted with an error instead of stalling the UI thread.
+//
+// Built without Lua (ENABLE_LUA=OFF) every call fails with an error.
 // ============================================================================
 
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 
 namespace super {
 
+class GraphEngine;
+
 // ---------------------------------------------------------------------------
 // LuaEngine — Script execution environment.
 // ---------------------------------------------------------------------------
@@ -27,22 +37,56 @@ class LuaEngine : public QObject {
 	Q_OBJECT
 
 public:
+	// CPU use of one script (run() chunk plus the timers it registered).
+	struct ScriptStats {
+		quint64 calls = 0;
+		qint64 total_ns = 0;
+		qint64 max_ns = 0;
+		quint64 instructions = 0;	// Approximate (counted in hook steps)
+		quint64 budget_hits = 0;	// Invocations aborted by the budget
+	};
+
 	explicit LuaEngine(QObject *parent = nullptr);
 	~LuaEngine() override;
 
 	// -- Script Execution --
-	// Run a Lua string. Returns true on success.
-	bool run(const QString &script);
+	// Run a Lua string. `name` labels errors and stats (default: a hash).
+	// Returns true on success.
+	bool run(const QString &script, const QString &name = {});
 
 	// Load and run a Lua file. Returns true on success.
 	bool run_file(const QString &path);
 
+	// -- Limits --
+	// VM instructions allowed per invocation; 0 = unlimited.
+	void set_instruction_budget(qint64 instructions);
+	qint64 instruction_budget() const;
+
+	// -- Bytecode Cache --
+	// Directory for cached bytecode; empty disables the disk cache.
+	void set_cache_dir(const QString &dir);
+	QString cache_dir() const;
+
+	// -- Bindings --
+	// Graph reached by super.graph_*; may be null.
+	void set_graph(GraphEngine *graph);
+
+	// -- Profiling --
+	QHash<QString, ScriptStats> script_stats() const;
+	void reset_stats();
+	// One line per script, most expensive first.
+	QString stats_report() const;
+
 	// -- Error Handling --
 	QString last_error() const;
 
 	// -- Status --
 	bool is_initialized() const;
 
+	// Engine state, defined in lua_engine.cpp (public so the C callbacks
+	// registered with Lua can reach it).
+	struct Impl;
+
 signals:
 	void script_error(const QString &error);
 	void log_message(const QString &message);
@@ -52,7 +96,6 @@ private:
 	void register_api();
 	void shutdown();
 
-	struct Impl;
 	Impl *m_impl = nullptr;
 };
 
@@ -0,0 +1,379 @@
+// ============================================================================
+// Master Clock — External Sync (MIDI Clock / MTC)
+// ============================================================================
+
+#include "master_clock.hpp"
+#include "../../core/control_registry.hpp"
+#include "../../../utils/midi/midi_backend.hpp"
+
+#include <chrono>
+#include <cmath>
+
+namespace super {
+
+static constexpr int kClockPpqn = 24;
+
+static qint64 steady_now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===== ClockPll ===========================================================
+
+void ClockPll::update(qint64 t_ns, double nominal_ns)
+{
+	double t = static_cast<double>(t_ns);
+
+	if (pulses == 0) {
+		period_ns = nominal_ns;
+		last_ns = t;
+		next_ns = t + period_ns;
+		pulses = 1;
+		return;
+	}
+
+	// No period yet: take it from the first interval
+	if (period_ns <= 0.0) {
+		if (t <= last_ns) return;
+		period_ns = t - last_ns;
+		last_ns = t;
+		next_ns = t + period_ns;
+		pulses++;
+		return;
+	}
+
+	double err_ns = t - next_ns;
+	double e = err_ns / period_ns;
+
+	// Outside the capture range (tempo jump, dropped pulses, relocate):
+	// re-seed from the raw interval instead of slewing towards it.
+	if (std::abs(e) > 0.5) {
+		double raw = t - last_ns;
+		if (raw > 0.0 && raw < period_ns * 4.0)
+			period_ns = raw;
+		last_ns = t;
+		next_ns = t + period_ns;
+		error = qBound(-0.5, e, 0.5);
+		error_avg = 1.0;
+		locked = false;
+		pulses++;
+		return;
+	}
+
+	error = e;
+	last_ns = next_ns + kp * err_ns;
+	period_ns += ki * err_ns;
+	next_ns = last_ns + period_ns;
+	pulses++;
+
+	// Lock with hysteresis so a single late pulse doesn't flap the state
+	error_avg += 0.1 * (std::abs(e) - error_avg);
+	if (!locked && error_avg < 0.05)
+		locked = true;
+	else if (locked && error_avg > 0.15)
+		locked = false;
+}
+
+// ===== MasterClock — Sync Source ==========================================
+
+void MasterClock::set_sync_source(ClockSyncSource source, MidiBackend *backend, int device)
+{
+	for (const auto &c : m_sync_connections) disconnect(c);
+	m_sync_connections.clear();
+	m_sync_watchdog.stop();
+	m_pll.reset();
+	m_mtc_received = 0;
+	update_lock(false);
+
+	// Leaving whatever drove the transport before
+	m_tick_timer.stop();
+	bool was_running = m_running;
+	m_running = false;
+	if (was_running)
+		emit transport_stopped();
+
+	m_sync_source = source;
+	m_sync_backend = backend;
+	m_sync_device = device;
+
+	if (source == ClockSyncSource::Internal || !backend)
+		return;
+
+	ensure_sync_ports();
+	m_sync_connections.append(connect(backend, &MidiBackend::midi_timing,
+		this, &MasterClock::on_midi_timing));
+	if (source == ClockSyncSource::Mtc)
+		m_sync_connections.append(connect(backend, &MidiBackend::sysex_message,
+			this, &MasterClock::on_sysex));
+}
+
+double MasterClock::beat_position() const
+{
+	switch (m_sync_source) {
+	case ClockSyncSource::Internal: {
+		if (!m_running) return m_beat_count;
+		int interval = m_tick_timer.interval();
+		double frac = interval > 0
+			? 1.0 - static_cast<double>(m_tick_timer.remainingTime()) / interval
+			: 0.0;
+		return m_beat_count + qBound(0.0, frac, 1.0);
+	}
+	case ClockSyncSource::MidiClock: {
+		if (!m_running || m_clock_ticks == 0 || m_pll.period_ns <= 0.0)
+			return static_cast<double>(m_clock_ticks) / kClockPpqn;
+		double since = (steady_now_ns() - m_pll.last_ns) / m_pll.period_ns;
+		double ticks = (m_clock_ticks - 1) + qBound(0.0, since, 1.0);
+		return ticks / kClockPpqn;
+	}
+	case ClockSyncSource::Mtc: {
+		double ms = static_cast<double>(m_mtc_ms);
+		if (m_running && m_pll.period_ns > 0.0) {
+			double since = (steady_now_ns() - m_pll.last_ns) / m_pll.period_ns;
+			ms += qBound(0.0, since, 1.0) * m_pll.period_ns / 1e6;
+		}
+		return ms * m_bpm / 60000.0;
+	}
+	}
+	return 0.0;
+}
+
+// ===== MasterClock — MIDI Input ===========================================
+
+void MasterClock::on_midi_timing(int device, int status, int data, qint64 timestamp_ns)
+{
+	if (m_sync_device != -1 && device != m_sync_device)
+		return;
+
+	if (m_sync_source == ClockSyncSource::Mtc) {
+		if (status == 0xF1)
+			on_mtc_quarter_frame(data, timestamp_ns);
+		return;
+	}
+
+	switch (status) {
+	case 0xF8:
+		on_clock_pulse(timestamp_ns);
+		break;
+	case 0xFA:	// Start: from the top
+		locate_ticks(0);
+		set_external_running(true);
+		break;
+	case 0xFB:	// Continue: from the last song position
+		set_external_running(true);
+		break;
+	case 0xFC:
+		set_external_running(false);
+		break;
+	case 0xF2:	// Song position in MIDI beats (1/16 note = 6 clocks)
+		locate_ticks(static_cast<qint64>(data) * 6);
+		break;
+	default:
+		break;
+	}
+}
+
+void MasterClock::on_clock_pulse(qint64 timestamp_ns)
+{
+	// Masters keep sending 0xF8 while stopped, so tempo stays tracked
+	m_pll.update(timestamp_ns);
+	if (m_pll.period_ns > 0.0) {
+		m_bpm = qBound(20.0, 60e9 / (m_pll.period_ns * kClockPpqn), 300.0);
+		m_sync_watchdog.start(qMax(100, static_cast<int>(m_pll.period_ns * 8 / 1e6)));
+	} else {
+		m_sync_watchdog.start(1000);
+	}
+
+	if (m_running) {
+		qint64 pos = m_clock_ticks++;
+		if (pos % kClockPpqn == 0) {
+			m_beat_count = static_cast<int>(pos / kClockPpqn);
+			emit tick();
+			emit beat_signal(beat());
+			if (beat() == 0)
+				emit bar_signal(bar());
+		}
+	}
+
+	update_lock(m_pll.locked);
+	publish_sync_state();
+}
+
+void MasterClock::locate_ticks(qint64 ticks)
+{
+	m_clock_ticks = ticks;
+	m_beat_count = static_cast<int>(ticks / kClockPpqn);
+}
+
+void MasterClock::set_external_running(bool running)
+{
+	if (running == m_running)
+		return;
+	m_running = running;
+	if (running) {
+		m_elapsed.start();
+		emit transport_started();
+	} else {
+		emit transport_stopped();
+	}
+}
+
+void MasterClock::on_sync_timeout()
+{
+	// Pulses stopped: the next one re-seeds the loop
+	m_pll.reset();
+	update_lock(false);
+	if (m_sync_source == ClockSyncSource::Mtc)
+		set_external_running(false);
+	publish_sync_state();
+}
+
+void MasterClock::update_lock(bool locked)
+{
+	if (locked == m_sync_locked)
+		return;
+	m_sync_locked = locked;
+	if (m_port_locked)
+		m_port_locked->set_value(locked);
+	emit lock_changed(locked);
+}
+
+// ===== MasterClock — MTC ==================================================
+
+static double mtc_fps(int rate)
+{
+	switch (rate) {
+	case 0: return 24.0;
+	case 1: return 25.0;
+	case 2: return 30000.0 / 1001.0;
+	default: return 30.0;
+	}
+}
+
+// Labelled timecode → real milliseconds (handles 29.97 drop-frame).
+static qint64 mtc_to_ms(int h, int m, int s, int f, int rate)
+{
+	if (rate == 2) {
+		qint64 minutes = h * 60 + m;
+		qint64 frame = (static_cast<qint64>(h) * 3600 + m * 60 + s) * 30 + f
+			- 2 * (minutes - minutes / 10);
+		return frame * 1001 / 30;
+	}
+	double fps = mtc_fps(rate);
+	return static_cast<qint64>(((h * 3600.0 + m * 60.0 + s) + f / fps) * 1000.0);
+}
+
+void MasterClock::on_mtc_quarter_frame(int data, qint64 timestamp_ns)
+{
+	int piece = (data >> 4) & 0x07;
+	m_mtc_pieces[piece] = data & 0x0F;
+	if (piece == 0)
+		m_mtc_received = 0;
+	m_mtc_received |= 1 << piece;
+
+	int rate = (m_mtc_pieces[7] >> 1) & 0x03;
+	double fps = mtc_fps(rate);
+	double qf_ms = 250.0 / fps;
+
+	m_pll.update(timestamp_ns, qf_ms * 1e6);
+	m_sync_watchdog.start(qMax(100, static_cast<int>(qf_ms * 16)));
+
+	if (piece == 7 && m_mtc_received == 0xFF) {
+		int f = m_mtc_pieces[0] | (m_mtc_pieces[1] << 4);
+		int s = m_mtc_pieces[2] | (m_mtc_pieces[3] << 4);
+		int m = m_mtc_pieces[4] | (m_mtc_pieces[5] << 4);
+		int h = m_mtc_pieces[6] | ((m_mtc_pieces[7] & 0x01) << 4);
+		// The assembled time is when piece 0 was sent; we are 7 QFs later
+		m_mtc_ms = mtc_to_ms(h, m, s, f, rate) + static_cast<qint64>(7 * qf_ms);
+		set_external_running(true);
+	} else if (m_running) {
+		m_mtc_ms += static_cast<qint64>(qf_ms);
+	}
+
+	if (m_running) {
+		int beat_index = static_cast<int>(m_mtc_ms * m_bpm / 60000.0);
+		if (beat_index != m_beat_count) {
+			int prev_bar = bar();
+			m_beat_count = beat_index;
+			emit tick();
+			emit beat_signal(beat());
+			if (bar() != prev_bar)
+				emit bar_signal(bar());
+		}
+	}
+
+	update_lock(m_pll.locked);
+	publish_sync_state();
+}
+
+// MTC full frame (F0 7F <dev> 01 01 hh mm ss ff F7): sent on locate.
+void MasterClock::on_sysex(int device, const SysExBuffer &msg)
+{
+	if (m_sync_device != -1 && device != m_sync_device)
+		return;
+	const uint8_t *d = msg.data();
+	if (msg.size() != 10 || d[1] != 0x7F || d[3] != 0x01 || d[4] != 0x01)
+		return;
+
+	int rate = (d[5] >> 5) & 0x03;
+	m_mtc_ms = mtc_to_ms(d[5] & 0x1F, d[6], d[7], d[8], rate);
+	m_mtc_received = 0;
+	m_beat_count = static_cast<int>(m_mtc_ms * m_bpm / 60000.0);
+	m_pll.reset();
+	update_lock(false);
+	publish_sync_state();
+}
+
+// ===== MasterClock — Status Ports =========================================
+
+void MasterClock::ensure_sync_ports()
+{
+	if (m_port_tempo)
+		return;
+	auto &reg = ControlRegistry::instance();
+
+	ControlDescriptor desc;
+	desc.group = "clock";
+
+	desc.id = "clock.tempo";
+	desc.display_name = "Clock Tempo";
+	desc.type = ControlType::Float;
+	desc.range_min = 20.0;
+	desc.range_max = 300.0;
+	desc.default_value = m_bpm;
+	m_port_tempo = reg.create_port(desc);
+
+	desc.id = "clock.phase_error";
+	desc.display_name = "Clock Phase Error";
+	desc.range_min = -0.5;
+	desc.range_max = 0.5;
+	desc.default_value = 0.0;
+	m_port_phase_error = reg.create_port(desc);
+
+	desc.id = "clock.locked";
+	desc.display_name = "Clock Locked";
+	desc.type = ControlType::Toggle;
+	desc.range_min = 0.0;
+	desc.range_max = 1.0;
+	m_port_locked = reg.create_port(desc);
+
+	desc.id = "clock.timecode";
+	desc.display_name = "Clock Timecode";
+	desc.type = ControlType::Time;
+	desc.range_max = 24.0 * 3600.0 * 1000.0;
+	m_port_timecode = reg.create_port(desc);
+}
+
+void MasterClock::publish_sync_state()
+{
+	if (!m_port_tempo)
+		return;
+	if (m_sync_source == ClockSyncSource::MidiClock &&
+		std::abs(m_port_tempo->as_double() - m_bpm) >= 0.01)
+		m_port_tempo->set_value(m_bpm);
+	m_port_phase_error->set_value(m_pll.error);
+	if (m_sync_source == ClockSyncSource::Mtc)
+		m_port_timecode->set_value(m_mtc_ms);
+}
+
+} // namespace super
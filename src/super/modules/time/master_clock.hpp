@@ -4,10 +4,11 @@
 // Master Clock & Scheduler
 //
 // Provides:
-//   • MasterClock: BPM-driven clock with beat/bar signals.
+//   • MasterClock: BPM-driven clock with beat/bar signals. Free-runs from
+//     its own timer or slaves to external MIDI Clock / MTC through a PLL.
 //   • Scheduler: Time-based event triggering (cue points, calendar events).
 //
-// Future extensions: LTC/MTC timecode, Ableton Link.
+// Future extensions: LTC timecode, Ableton Link.
 // ============================================================================
 
 #include <QObject>
@@ -15,10 +16,58 @@
 #include <QElapsedTimer>
 #include <QList>
 #include <QDateTime>
+#include <QPointer>
 #include <functional>
 
+class MidiBackend;
+class SysExBuffer;
+
 namespace super {
 
+class ControlPort;
+
+// ---------------------------------------------------------------------------
+// ClockPll — Second-order phase-locked loop over timestamped pulses.
+//
+// Tracks the predicted arrival time of the next pulse and the pulse period.
+// Each pulse corrects the phase by `kp` of the timing error and the period by
+// `ki` of it, which filters driver/USB jitter while following tempo changes
+// within a few beats. Pulses that land far outside the prediction re-seed
+// the loop instead of dragging it.
+// ---------------------------------------------------------------------------
+struct ClockPll {
+	double kp = 0.15;
+	double ki = 0.01;
+
+	double period_ns = 0.0;		// Smoothed pulse period
+	double next_ns = 0.0;		// Predicted time of the next pulse
+	double last_ns = 0.0;		// Smoothed time of the last pulse
+	double error = 0.0;			// Last timing error, in periods (-0.5 … 0.5)
+	double error_avg = 1.0;		// Running mean of |error|
+	int pulses = 0;
+	bool locked = false;
+
+	void reset() {
+		period_ns = next_ns = last_ns = 0.0;
+		error = 0.0;
+		error_avg = 1.0;
+		pulses = 0;
+		locked = false;
+	}
+
+	// Feed one pulse. `nominal_ns` (optional) seeds the period when known.
+	void update(qint64 t_ns, double nominal_ns = 0.0);
+};
+
+// ---------------------------------------------------------------------------
+// ClockSyncSource — What drives MasterClock.
+// ---------------------------------------------------------------------------
+enum class ClockSyncSource {
+	Internal,	// Own timer at bpm()
+	MidiClock,	// 24 PPQN 0xF8 + start/stop/continue/song position
+	Mtc			// MTC quarter frames; beats derived from timecode at bpm()
+};
+
 // ---------------------------------------------------------------------------
 // MasterClock — BPM-based timing source.
 // ---------------------------------------------------------------------------
@@ -32,15 +81,23 @@ public:
 	}
 
 	// -- BPM --
+	// While slaved to MIDI Clock, bpm() is the PLL tempo estimate and
+	// set_bpm() is ignored.
 	double bpm() const { return m_bpm; }
 	void set_bpm(double bpm) {
+		if (m_sync_source == ClockSyncSource::MidiClock)
+			return;
 		m_bpm = qBound(20.0, bpm, 300.0);
-		if (m_running)
+		if (m_running && m_sync_source == ClockSyncSource::Internal)
 			update_interval();
 	}
 
 	// -- Transport --
+	// Manual transport only applies to the internal clock; a slaved clock
+	// follows the external start/stop.
 	void start() {
+		if (m_sync_source != ClockSyncSource::Internal)
+			return;
 		m_running = true;
 		m_beat_count = 0;
 		m_elapsed.start();
@@ -50,11 +107,34 @@ public:
 	}
 
 	void stop() {
+		if (m_sync_source != ClockSyncSource::Internal)
+			return;
 		m_running = false;
 		m_tick_timer.stop();
 		emit transport_stopped();
 	}
 
+	// -- External Sync --
+	// Slave to MIDI Clock or MTC arriving on `backend` (device -1 = any).
+	// Creates the clock.* status ports on first use:
+	//   clock.tempo        Float   PLL tempo estimate (BPM)
+	//   clock.phase_error  Float   Last pulse error, fraction of a pulse
+	//   clock.locked       Toggle  PLL lock state
+	//   clock.timecode     Time    MTC position (ms)
+	void set_sync_source(ClockSyncSource source, MidiBackend *backend = nullptr,
+						 int device = -1);
+	ClockSyncSource sync_source() const { return m_sync_source; }
+	bool is_locked() const { return m_sync_locked; }
+	double phase_error() const { return m_pll.error; }
+	const ClockPll &pll() const { return m_pll; }
+
+	// Fractional beat position extrapolated from the PLL (or the internal
+	// timer), for smooth visual sync between beat signals.
+	double beat_position() const;
+
+	// MTC position in ms (valid in Mtc mode once a full frame has arrived).
+	qint64 timecode_ms() const { return m_mtc_ms; }
+
 	bool is_running() const { return m_running; }
 
 	// -- Position --
@@ -75,11 +155,14 @@ signals:
 	void bar_signal(int bar);		// Every bar
 	void transport_started();
 	void transport_stopped();
+	void lock_changed(bool locked);
 
 private:
 	MasterClock() : QObject(nullptr) {
 		m_tick_timer.setTimerType(Qt::PreciseTimer);
 		connect(&m_tick_timer, &QTimer::timeout, this, &MasterClock::on_tick);
+		m_sync_watchdog.setSingleShot(true);
+		connect(&m_sync_watchdog, &QTimer::timeout, this, &MasterClock::on_sync_timeout);
 	}
 
 	void update_interval() {
@@ -101,12 +184,43 @@ private:
 			emit bar_signal(bar());
 	}
 
+	// -- External sync (master_clock.cpp) --
+	void on_midi_timing(int device, int status, int data, qint64 timestamp_ns);
+	void on_sysex(int device, const SysExBuffer &msg);
+	void on_clock_pulse(qint64 timestamp_ns);
+	void on_mtc_quarter_frame(int data, qint64 timestamp_ns);
+	void on_sync_timeout();
+	void locate_ticks(qint64 ticks);
+	void set_external_running(bool running);
+	void update_lock(bool locked);
+	void ensure_sync_ports();
+	void publish_sync_state();
+
 	double m_bpm = 120.0;
 	int m_beats_per_bar = 4;
 	int m_beat_count = 0;
 	bool m_running = false;
 	QTimer m_tick_timer;
 	QElapsedTimer m_elapsed;
+
+	ClockSyncSource m_sync_source = ClockSyncSource::Internal;
+	QPointer<MidiBackend> m_sync_backend;
+	int m_sync_device = -1;
+	QList<QMetaObject::Connection> m_sync_connections;
+	QTimer m_sync_watchdog;			// Drops lock when pulses stop
+	ClockPll m_pll;
+	bool m_sync_locked = false;
+	qint64 m_clock_ticks = 0;		// 24 PPQN position since song start
+
+	// MTC assembly
+	int m_mtc_pieces[8] = {};
+	int m_mtc_received = 0;			// Bitmask of pieces seen this cycle
+	qint64 m_mtc_ms = 0;
+
+	ControlPort *m_port_tempo = nullptr;
+	ControlPort *m_port_phase_error = nullptr;
+	ControlPort *m_port_locked = nullptr;
+	ControlPort *m_port_timecode = nullptr;
 };
 
 // ---------------------------------------------------------------------------
@@ -1,4 +1,5 @@
 #include "s_mixer_filter_controls.hpp"
+#include "../../dev/debugger/trace_recorder.hpp"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -221,6 +222,7 @@ void SMixerFilterControls::applySettings()
 	OBSSource filter = OBSGetStrongRef(m_weak_filter);
 	if (!filter) return;
 	
+	SUPER_TRACE_SCOPE("obs", "source_update");
 	obs_source_update(filter, m_settings);
 }
 
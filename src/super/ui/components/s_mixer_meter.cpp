@@ -1,4 +1,5 @@
 #include "s_mixer_meter.hpp"
+#include "super/dev/metrics/metrics.hpp"
 
 #include <QPainter>
 #include <QPaintEvent>
@@ -130,6 +131,7 @@ QColor SMixerStereoMeter::segmentColor(float ratio) const
 
 void SMixerStereoMeter::paintEvent(QPaintEvent *)
 {
+	SUPER_METRIC_TIME("mixer.meter_paint");
 	QPainter p(this);
 	int w = width();
 	int h = height();
@@ -1,6 +1,7 @@
 #include "control_assign_popup.hpp"
 #include "../core/control_registry.hpp"
 #include "../core/control_port.hpp"
+#include "../core/expression.hpp"
 #include "../../utils/midi/midi_backend.hpp"
 #include <QApplication>
 #include <QScreen>
@@ -898,9 +899,15 @@ FilterStageRow::FilterStageRow(int index, const QColor &color, QWidget *parent)
 	m_type->addItem("Delay",0); m_type->addItem("Debounce",1);
 	m_type->addItem("Rate Limit",2); m_type->addItem("Deadzone",3);
 	m_type->addItem("Clamp",4); m_type->addItem("Scale",5);
+	m_type->addItem("Expression",6);
 	m_type->setFixedWidth(90);
+	m_expr = new QLineEdit(this);
+	m_expr->setPlaceholderText("e.g. clamp(x * 2, 0, 127)");
+	m_expr->setMinimumWidth(140);
 	auto *row = new QHBoxLayout(this);
 	setup_base_row(row);
+	row->insertWidget(row->indexOf(m_preview), m_expr, 1);
+	connect(m_expr,&QLineEdit::textChanged,this,[this]{ validate_expr(); emit changed(); });
 	connect(m_type,QOverload<int>::of(&QComboBox::currentIndexChanged),this,&FilterStageRow::on_type_changed);
 	on_type_changed(0);
 }
@@ -916,9 +923,12 @@ void FilterStageRow::on_type_changed(int) {
 		if(m_p1->value()==0.0 && m_p2->value()==0.0){ m_p1->setValue(0.0); m_p2->setValue(127.0); } break;
 	case FilterStage::Scale: m_p1_label->setText("×:"); m_p2_label->setText("+:"); s2=true;
 		if(m_p1->value()==0.0) m_p1->setValue(1.0); break;
+	case FilterStage::Expression: s1=false;
+		if(m_expr->text().isEmpty()) m_expr->setText("x"); break;
 	}
 	m_p1_label->setVisible(s1); m_p1->setVisible(s1);
 	m_p2_label->setVisible(s2); m_p2->setVisible(s2);
+	m_expr->setVisible(t==FilterStage::Expression);
 	update_title(m_title_prefix, m_index + 1);
 	emit changed();
 }
@@ -926,12 +936,20 @@ void FilterStageRow::load(const FilterStage &s) {
 	m_enabled->setChecked(s.enabled);
 	int idx=m_type->findData(s.type); if(idx>=0)m_type->setCurrentIndex(idx);
 	m_p1->setValue(s.param1); m_p2->setValue(s.param2);
+	if(!s.expr.isEmpty()) m_expr->setText(s.expr);
 }
 FilterStage FilterStageRow::build() const {
 	FilterStage s; s.type=m_type->currentData().toInt();
 	s.enabled=m_enabled->isChecked(); s.param1=m_p1->value(); s.param2=m_p2->value();
+	if(s.type==FilterStage::Expression) s.expr=m_expr->text().trimmed();
 	return s;
 }
+void FilterStageRow::validate_expr() {
+	QString err;
+	bool ok = ExpressionProgram::compile(m_expr->text(), &err) != nullptr;
+	m_expr->setStyleSheet(ok ? QString() : "border:1px solid #e74c3c;");
+	m_expr->setToolTip(ok ? "Variables: x, prev, dt — port(\"id\") reads another port" : err);
+}
 
 // ===== MasterPreview ======================================================
 MasterPreview::MasterPreview(const QString &name, double min, double max, QWidget *parent)
@@ -1034,6 +1052,7 @@ OutputBindingPanel::OutputBindingPanel(int index, QWidget *parent)
 void OutputBindingPanel::load(const MidiOutputBinding &o) {
 	m_enabled->setChecked(o.enabled);
 	if(o.device_index>=0&&o.device_index<m_device_combo->count()) m_device_combo->setCurrentIndex(o.device_index);
+	m_loaded_combo=m_device_combo->currentIndex(); m_loaded_device=o.device_index; m_loaded_device_id=o.device_id;
 	m_channel_spin->setValue(o.channel); m_cc_spin->setValue(o.cc);
 	m_in_min_spin->setValue(o.input_min); m_in_max_spin->setValue(o.input_max);
 	m_out_min_spin->setValue(o.output_min); m_out_max_spin->setValue(o.output_max);
@@ -1042,6 +1061,7 @@ void OutputBindingPanel::load(const MidiOutputBinding &o) {
 MidiOutputBinding OutputBindingPanel::build(const QString &port_id) const {
 	MidiOutputBinding o; o.port_id=port_id; o.enabled=m_enabled->isChecked();
 	o.device_index=m_device_combo->currentIndex(); o.channel=m_channel_spin->value(); o.cc=m_cc_spin->value();
+	if(m_device_combo->currentIndex()==m_loaded_combo) { o.device_index=m_loaded_device; o.device_id=m_loaded_device_id; }
 	o.input_min=m_in_min_spin->value(); o.input_max=m_in_max_spin->value();
 	o.output_min=m_out_min_spin->value(); o.output_max=m_out_max_spin->value();
 	o.on_change=m_on_change_check->isChecked(); return o;
@@ -1257,6 +1277,7 @@ void BindingPanel::load_from_binding(const MidiPortBinding &b) {
 	// device_index -1 means "any" → combo index 0; otherwise offset by +1 for "(Any)" entry
 	int combo_idx = (b.device_index < 0) ? 0 : b.device_index + 1;
 	if(combo_idx < m_device_combo->count()) m_device_combo->setCurrentIndex(combo_idx);
+	m_loaded_combo = m_device_combo->currentIndex(); m_loaded_device = b.device_index; m_loaded_device_id = b.device_id;
 	m_channel_spin->setValue(b.channel); m_cc_spin->setValue(b.data1);
 	if(m_input_min_spin) m_input_min_spin->setValue(b.input_min);
 	if(m_input_max_spin) m_input_max_spin->setValue(b.input_max);
@@ -1282,6 +1303,7 @@ MidiPortBinding BindingPanel::build_binding(const QString &port_id) const {
 	b.port_id=port_id; b.enabled=m_header_enabled->isChecked();
 	// combo index 0 = "(Any)" → device_index -1; otherwise offset by -1
 	b.device_index = m_device_combo->currentIndex() - 1;
+	if(m_device_combo->currentIndex() == m_loaded_combo) { b.device_index = m_loaded_device; b.device_id = m_loaded_device_id; }
 	b.channel=m_channel_spin->value(); b.data1=m_cc_spin->value();
 	b.map_mode=static_cast<MidiPortBinding::MapMode>(m_map_mode);
 	if(m_input_min_spin) b.input_min=m_input_min_spin->value();
@@ -1323,6 +1345,8 @@ void BindingPanel::set_learned_source(int dev, int ch, int cc, bool enc, Encoder
 	// dev is raw device index; combo has "(Any)" at 0, so offset +1
 	int combo_idx = (dev < 0) ? 0 : dev + 1;
 	if(combo_idx < m_device_combo->count()) m_device_combo->setCurrentIndex(combo_idx);
+	// Learned from a live device: id left empty so add_binding() adopts the current one
+	m_loaded_combo = m_device_combo->currentIndex(); m_loaded_device = dev; m_loaded_device_id.clear();
 	m_channel_spin->setValue(ch); m_cc_spin->setValue(cc);
 	m_is_encoder=enc; m_encoder_mode=em; m_encoder_sensitivity=es;
 	update_header(); emit changed();
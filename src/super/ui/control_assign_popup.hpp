@@ -8,6 +8,7 @@
 #include <QCheckBox>
 #include <QPushButton>
 #include <QPlainTextEdit>
+#include <QLineEdit>
 #include <QGroupBox>
 #include <QScrollArea>
 #include <QTabWidget>
@@ -212,6 +213,8 @@ public:
 	FilterStage build() const;
 private:
 	void on_type_changed(int combo_idx);
+	void validate_expr();
+	QLineEdit *m_expr = nullptr;
 };
 
 // ---------------------------------------------------------------------------
@@ -263,6 +266,9 @@ private:
 	QWidget *m_body = nullptr;
 	QCheckBox *m_enabled = nullptr;
 	QComboBox *m_device_combo = nullptr;
+	int m_loaded_combo = -1;		// Combo index set by load()
+	int m_loaded_device = -1;
+	QString m_loaded_device_id;
 	QSpinBox *m_channel_spin = nullptr;
 	QSpinBox *m_cc_spin = nullptr;
 	QDoubleSpinBox *m_in_min_spin = nullptr;
@@ -332,6 +338,11 @@ private:
 
 	// MIDI Source
 	QComboBox *m_device_combo = nullptr;
+	// Device as loaded; kept when the combo is left alone so an unplugged
+	// device's binding isn't silently turned into "(Any)"
+	int m_loaded_combo = -1;
+	int m_loaded_device = -1;
+	QString m_loaded_device_id;
 	QSpinBox *m_channel_spin = nullptr;
 	QSpinBox *m_cc_spin = nullptr;
 
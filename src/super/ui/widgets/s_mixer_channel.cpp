@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include "super/ui/components/s_mixer_effects_rack.hpp"
+#include "super/dev/metrics/metrics.hpp"
 
 namespace super {
 
@@ -32,7 +33,9 @@ namespace super {
 // Construction / Destruction
 // =====================================================================
 
-SMixerChannel::SMixerChannel(QWidget *parent) : QWidget(parent)
+SMixerChannel::SMixerChannel(QWidget *parent)
+	: QWidget(parent),
+	  m_volmeter_time(&MetricsRegistry::instance().histogram(QStringLiteral("mixer.volmeter_callback")))
 {
 	setupUi();
 	startMeterTimer();
@@ -442,6 +445,7 @@ void SMixerChannel::obsVolmeterCb(void *data, const float magnitude[MAX_AUDIO_CH
 {
 	Q_UNUSED(input_peak);
 	auto *self = static_cast<SMixerChannel *>(data);
+	MetricTimer timer(*self->m_volmeter_time);
 
 	float pl = peak[0];
 	float pr = (MAX_AUDIO_CHANNELS > 1) ? peak[1] : peak[0];
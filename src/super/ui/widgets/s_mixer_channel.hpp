@@ -54,6 +54,7 @@ class SMixerPropsSelector;
 class SMixerDbLabel;
 class SMixerSidePanel;
 class SMixerSidebarToggle;
+class Histogram;
 
 class SMixerChannel : public QWidget {
 	Q_OBJECT
@@ -161,6 +162,10 @@ private:
 	float m_disp_peak_l = -60.0f, m_disp_peak_r = -60.0f;
 	float m_disp_mag_l = -60.0f, m_disp_mag_r = -60.0f;
 
+	// "mixer.volmeter_callback", registered up front: the registry locks
+	// and allocates, which the audio thread must not do
+	Histogram *m_volmeter_time = nullptr;
+
 	// Peak Hold
 	float m_max_peak_hold = -60.0f;
 
@@ -20,6 +20,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QPointer>
+#include <QFileDialog>
 #pragma endregion
 
 #pragma region plugin_headers
@@ -35,6 +36,7 @@
 #include "docks/daw_mixer_demo_dock.hpp"
 #include "docks/s_mixer_demo_dock.hpp"
 #include "docks/advanced_monitoring_dock.hpp"
+#include "docks/performance_dock.hpp"
 #include "docks/sourcerer/sourcerer_scenes_dock.hpp"
 #include "docks/sourcerer/sourcerer_sources_dock.hpp"
 #include "windows/graph_editor_window.hpp"
@@ -47,6 +49,11 @@
 #include "utils/extras/libobs_tweaks.hpp"
 
 #include "super/core/control_registry.hpp"
+#include "super/modules/graph/audio_graph.hpp"
+#include "super/hal/profile_database.hpp"
+#include "super/dev/packager/package_manager.hpp"
+#include "super/dev/debugger/trace_recorder.hpp"
+#include "super/dev/metrics/metrics.hpp"
 
 #include "dialogs/canvas_manager.h"
 #include "dialogs/audio_channels.h"
@@ -143,10 +150,14 @@ static struct GlobalDocks {
 #if ENABLE_ADVANCED_MONITORING
 	QPointer<AdvancedMonitoringDock> advanced_monitoring;
 #endif
+#if ENABLE_PERFORMANCE_DOCK
+	QPointer<PerformanceDock> performance;
+#endif
 } g_docks;
 
 static void save_callback(obs_data_t *save_data, bool saving, void *)
 {
+	SUPER_METRIC_TIME("config.save_callback");
 	if (saving) {
 		// Saving
 #if ENABLE_DOCK_WINDOW_MANAGER
@@ -636,6 +647,7 @@ bool on_plugin_load()
 #if ENABLE_ADVANCED_MONITORING
 	register_hidden_monitor_filter();
 #endif
+	super::register_audio_graph_filter();
 
 	// Check if we have all the deps loaded
 	return true;
@@ -647,6 +659,24 @@ void on_plugin_loaded()
 	OBSFrontendTweaker::OnLoaded();
 	OBSFrontendHelper::OnLoaded();
 
+	// Hardware profiles: bundled, user-supplied, then installed packages
+	{
+		auto &profiles = super::ProfileDatabase::instance();
+		if (char *dir = obs_module_file("profiles")) {
+			profiles.load_directory(QString::fromUtf8(dir));
+			bfree(dir);
+		}
+		if (char *dir = obs_module_config_path("profiles")) {
+			profiles.load_directory(QString::fromUtf8(dir));
+			bfree(dir);
+		}
+		if (char *dir = obs_module_config_path("packages")) {
+			super::PackageManager::instance().set_packages_dir(QString::fromUtf8(dir));
+			bfree(dir);
+			profiles.load_packages();
+		}
+	}
+
 	obs_frontend_add_event_callback(on_obs_evt, nullptr);
 
 	// Add Tools menu item
@@ -723,6 +753,25 @@ void on_plugin_loaded()
 		inspector->raise();
 	});
 
+#if SUPER_TRACING
+	// Control-system trace recorder: check to record, uncheck to save
+	auto actionTrace = (QAction *)obs_frontend_add_tools_menu_qaction("Record Control Trace");
+	actionTrace->setCheckable(true);
+	QObject::connect(actionTrace, &QAction::toggled, [](bool on) {
+		auto &recorder = super::TraceRecorder::instance();
+		if (on) {
+			recorder.start();
+			return;
+		}
+		recorder.stop();
+		auto *parent = static_cast<QWidget *>(obs_frontend_get_main_window());
+		const QString path = QFileDialog::getSaveFileName(parent, "Save Control Trace",
+			"super_trace.json", "Chrome Trace (*.json)");
+		if (!path.isEmpty() && !recorder.write_chrome_json(path))
+			QMessageBox::warning(parent, "Save Control Trace", QString("Cannot write %1").arg(path));
+	});
+#endif
+
 	obs_frontend_add_save_callback(save_callback, nullptr);
 
 	// Try to load initial state
@@ -780,6 +829,11 @@ void on_plugin_loaded()
 	obs_frontend_add_dock_by_id("AdvancedMonitoringDock", "Advanced Monitoring", g_docks.advanced_monitoring);
 #endif
 
+#if ENABLE_PERFORMANCE_DOCK
+	g_docks.performance = new PerformanceDock(mainWindow);
+	obs_frontend_add_dock_by_id("SuperPerformanceDock", "Super Suite Performance", g_docks.performance);
+#endif
+
 #if ENABLE_VOLUME_METER_DOCK
 	// Restore style
 	if (VolumeMeterDemoDock::s_volumeMeterDemoStyle >= 0 && VolumeMeterDemoDock::s_volumeMeterDemoStyle < 4)
@@ -892,6 +946,13 @@ void on_plugin_unload()
 			delete g_docks.advanced_monitoring;
 		}
 #endif
+
+#if ENABLE_PERFORMANCE_DOCK
+		if (g_docks.performance) {
+			obs_frontend_remove_dock("SuperPerformanceDock");
+			delete g_docks.performance;
+		}
+#endif
 	}
 
 	MidiRouter::cleanup();
@@ -19,6 +19,7 @@
 #define ENABLE_AUDIO_MATRIX 1
 #define ENABLE_ENCODING_GRAPH 1
 #define ENABLE_TWEAKS_PANEL 1
+#define ENABLE_PERFORMANCE_DOCK 1
 
 #ifdef __cplusplus
 extern "C" {
@@ -1 +1,179 @@
 #include "midi_backend.hpp"
+
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+
+MidiBackend::MidiBackend(QObject *parent) : QObject(parent)
+{
+	qRegisterMetaType<MidiDeviceChange>();
+}
+
+MidiBackend::~MidiBackend()
+{
+	stop_device_scanner();
+}
+
+// ===== Device Scanner =====================================================
+
+void MidiBackend::ensure_scanner()
+{
+	if (m_scan_thread)
+		return;
+	m_scan_thread = new QThread();
+	m_scan_thread->setObjectName("midi-device-scan");
+	m_scan_ctx = new QObject();
+	m_scan_ctx->moveToThread(m_scan_thread);
+	m_scan_thread->start(QThread::LowPriority);
+}
+
+void MidiBackend::stop_device_scanner()
+{
+	if (!m_scan_thread)
+		return;
+	// The poll timer belongs to the scanner thread; delete it there
+	QMetaObject::invokeMethod(m_scan_ctx, [this]() {
+		delete m_poll_timer;
+		m_poll_timer = nullptr;
+	}, Qt::BlockingQueuedConnection);
+	m_scan_thread->quit();
+	m_scan_thread->wait();
+	delete m_scan_ctx;
+	m_scan_ctx = nullptr;
+	delete m_scan_thread;
+	m_scan_thread = nullptr;
+}
+
+void MidiBackend::refresh_devices()
+{
+	ensure_scanner();
+	if (m_scan_queued.exchange(true))
+		return;  // A scan is already pending; it will see the same devices
+	QMetaObject::invokeMethod(m_scan_ctx, [this]() { scan_on_worker(); },
+		Qt::QueuedConnection);
+}
+
+// Runs on the scanner thread.
+void MidiBackend::scan_on_worker()
+{
+	m_scan_queued = false;
+	QStringList inputs = enumerate_inputs();
+	QStringList outputs = enumerate_outputs();
+	QMetaObject::invokeMethod(this, [this, inputs, outputs]() {
+		apply_scan(inputs, outputs);
+	}, Qt::QueuedConnection);
+}
+
+void MidiBackend::start_device_poll(int interval_ms)
+{
+	ensure_scanner();
+	QMetaObject::invokeMethod(m_scan_ctx, [this, interval_ms]() {
+		if (!m_poll_timer) {
+			m_poll_timer = new QTimer(m_scan_ctx);
+			connect(m_poll_timer, &QTimer::timeout, m_scan_ctx, [this]() { scan_on_worker(); });
+		}
+		m_poll_timer->start(interval_ms);
+	}, Qt::QueuedConnection);
+	refresh_devices();
+}
+
+void MidiBackend::stop_device_poll()
+{
+	if (!m_scan_ctx)
+		return;
+	QMetaObject::invokeMethod(m_scan_ctx, [this]() {
+		if (m_poll_timer)
+			m_poll_timer->stop();
+	}, Qt::QueuedConnection);
+}
+
+static void diff_ids(const QStringList &before, const QStringList &after,
+	QStringList &added, QStringList &removed)
+{
+	QSet<QString> old_set(before.begin(), before.end());
+	QSet<QString> new_set(after.begin(), after.end());
+	for (const auto &id : after)
+		if (!old_set.contains(id)) added.append(id);
+	for (const auto &id : before)
+		if (!new_set.contains(id)) removed.append(id);
+}
+
+void MidiBackend::apply_scan(const QStringList &inputs, const QStringList &outputs)
+{
+	QStringList in_ids = device_ids(inputs);
+	QStringList out_ids = device_ids(outputs);
+	bool first = !m_devices_ready;
+	if (!first && in_ids == m_input_ids && out_ids == m_output_ids)
+		return;
+
+	MidiDeviceChange change;
+	diff_ids(m_input_ids, in_ids, change.added_inputs, change.removed_inputs);
+	diff_ids(m_output_ids, out_ids, change.added_outputs, change.removed_outputs);
+
+	m_inputs = inputs;
+	m_outputs = outputs;
+	m_input_ids = in_ids;
+	m_output_ids = out_ids;
+	m_devices_ready = true;
+
+	on_devices_rescanned();
+	// Also emitted for a pure reorder (empty change) so bindings get remapped
+	emit devices_changed(change);
+}
+
+// ===== Device Identity ====================================================
+
+QStringList MidiBackend::device_ids(const QStringList &names)
+{
+	QStringList ids;
+	ids.reserve(names.size());
+	QHash<QString, int> seen;
+	for (const auto &name : names)
+		ids.append(QString("%1#%2").arg(name).arg(seen[name]++));
+	return ids;
+}
+
+QString MidiBackend::input_device_id(int index) const
+{
+	return index >= 0 && index < m_input_ids.size() ? m_input_ids[index] : QString();
+}
+
+QString MidiBackend::output_device_id(int index) const
+{
+	return index >= 0 && index < m_output_ids.size() ? m_output_ids[index] : QString();
+}
+
+int MidiBackend::input_index_for_id(const QString &id) const
+{
+	return m_input_ids.indexOf(id);
+}
+
+int MidiBackend::output_index_for_id(const QString &id) const
+{
+	return m_output_ids.indexOf(id);
+}
+
+static int remap_index(int index, QString &id, const QStringList &ids, bool ready)
+{
+	if (index == -1 || !ready)
+		return index;
+	if (id.isEmpty()) {
+		// Older configs only stored the index: adopt whatever is there now
+		if (index >= 0 && index < ids.size())
+			id = ids[index];
+		return index;
+	}
+	int now = ids.indexOf(id);
+	return now >= 0 ? now : MidiBackend::kDeviceMissing;
+}
+
+int MidiBackend::remap_input_index(int index, QString &id) const
+{
+	return remap_index(index, id, m_input_ids, m_devices_ready);
+}
+
+int MidiBackend::remap_output_index(int index, QString &id) const
+{
+	return remap_index(index, id, m_output_ids, m_devices_ready);
+}
@@ -1,21 +1,71 @@
 #pragma once
 
+#include "sysex_buffer.hpp"
+
 #include <QObject>
 #include <QStringList>
 
+#include <atomic>
+
+class QThread;
+class QTimer;
+
+// Result of a device rescan, as stable device ids (see MidiBackend::device_ids).
+struct MidiDeviceChange {
+	QStringList added_inputs;
+	QStringList removed_inputs;
+	QStringList added_outputs;
+	QStringList removed_outputs;
+
+	bool is_empty() const
+	{
+		return added_inputs.isEmpty() && removed_inputs.isEmpty() &&
+		       added_outputs.isEmpty() && removed_outputs.isEmpty();
+	}
+};
+
 // Abstract MIDI backend.
 // Subclass this to add support for different MIDI APIs (WinMM, RtMidi, CoreMIDI, etc.)
+//
+// Device enumeration runs on a background thread: some drivers take hundreds
+// of ms per query, so the device lists below are a cache refreshed by
+// refresh_devices() / the hot-detect poll, never a live query.
 class MidiBackend : public QObject {
 	Q_OBJECT
 
 public:
-	explicit MidiBackend(QObject *parent = nullptr) : QObject(parent) {}
-	~MidiBackend() override = default;
+	explicit MidiBackend(QObject *parent = nullptr);
+	~MidiBackend() override;
+
+	// Device index that matches nothing (bound device is unplugged).
+	static constexpr int kDeviceMissing = -2;
+
+	// --- Device Lists (cached) ---
+
+	// False until the first background scan has finished.
+	bool devices_ready() const { return m_devices_ready; }
+
+	// Queue a background rescan; devices_changed() fires if anything moved.
+	void refresh_devices();
+
+	// Stable ids: device name plus its ordinal among devices sharing that
+	// name ("nanoKONTROL2#0"). Survives reordering of the driver's list.
+	static QStringList device_ids(const QStringList &names);
+	QString input_device_id(int index) const;
+	QString output_device_id(int index) const;
+	int input_index_for_id(const QString &id) const;   // -1 if not present
+	int output_index_for_id(const QString &id) const;
+
+	// Resolve a binding's device index from its stored id. Adopts the id
+	// from `index` when none is stored yet; returns kDeviceMissing if the
+	// device is gone. Index -1 ("any device") passes through.
+	int remap_input_index(int index, QString &id) const;
+	int remap_output_index(int index, QString &id) const;
 
 	// --- Input ---
 
-	// Enumerate available MIDI input devices
-	virtual QStringList available_input_devices() const = 0;
+	// Cached MIDI input device names
+	QStringList available_input_devices() const { return m_inputs; }
 
 	// Open a device by index. Returns true on success.
 	virtual bool open_input_device(int index) = 0;
@@ -25,8 +75,8 @@ public:
 
 	// --- Output ---
 
-	// Enumerate available MIDI output devices (may differ from inputs)
-	virtual QStringList available_output_devices() const = 0;
+	// Cached MIDI output device names (may differ from inputs)
+	QStringList available_output_devices() const { return m_outputs; }
 
 	// Open an output device by index. Returns true on success.
 	virtual bool open_output_device(int index) = 0;
@@ -38,11 +88,33 @@ public:
 	// If device == -1, send to all open output devices.
 	virtual void send_cc(int device, int channel, int cc, int value) = 0;
 
+	// Send a complete SysEx message (F0 … F7) to an output device.
+	// If device == -1, send to all open output devices.
+	// The backend keeps a reference to `msg` until the driver is done with it,
+	// so callers never need to copy the payload. Pacing against other output
+	// traffic is the caller's job (see MidiAdapter's SysEx queue).
+	virtual void send_sysex(int device, const SysExBuffer &msg)
+	{
+		Q_UNUSED(device);
+		Q_UNUSED(msg);
+	}
+
+	// --- Timing ---
+
+	// True for the messages delivered through midi_timing() instead of
+	// midi_message(): MTC quarter frame, song position, clock, start,
+	// continue and stop.
+	static bool is_timing_status(int status)
+	{
+		return status == 0xF1 || status == 0xF2 ||
+		       status == 0xF8 || status == 0xFA || status == 0xFB || status == 0xFC;
+	}
+
 	// --- Hot-Detection ---
 
-	// Start/stop periodic device polling for hot-detect
-	virtual void start_device_poll(int interval_ms = 2000) { Q_UNUSED(interval_ms); }
-	virtual void stop_device_poll() {}
+	// Start/stop periodic background rescans for hot-detect
+	void start_device_poll(int interval_ms = 2000);
+	void stop_device_poll();
 
 signals:
 	// Raw MIDI message from device
@@ -51,6 +123,50 @@ signals:
 	// data2:  second data byte (CC value / velocity)
 	void midi_message(int device, int status, int data1, int data2);
 
-	// Emitted when device lists change (add/remove)
-	void devices_changed();
+	// Clock / transport / timecode message (see is_timing_status()).
+	// data:         MTC quarter-frame byte (0xF1), 14-bit song position in
+	//               MIDI beats (0xF2), otherwise 0.
+	// timestamp_ns: std::chrono::steady_clock time captured on the driver
+	//               thread, so the consumer sees arrival time without the
+	//               queued-connection latency.
+	void midi_timing(int device, int status, int data, qint64 timestamp_ns);
+
+	// Complete SysEx message from device (F0 … F7, pooled buffer)
+	void sysex_message(int device, const SysExBuffer &msg);
+
+	// Emitted on the backend's thread after a rescan changed the device
+	// lists. The first scan reports every device as added.
+	void devices_changed(const MidiDeviceChange &change);
+
+protected:
+	// Query the driver. Called on the scanner thread; must not touch
+	// state owned by the backend's thread.
+	virtual QStringList enumerate_inputs() const = 0;
+	virtual QStringList enumerate_outputs() const = 0;
+
+	// Called on the backend's thread after the cached lists were replaced,
+	// before devices_changed(). Backends re-key open handles here.
+	virtual void on_devices_rescanned() {}
+
+	// Stop the scanner thread. Subclasses call this from their destructor,
+	// since the thread calls back into their enumerate_*() overrides.
+	void stop_device_scanner();
+
+private:
+	void ensure_scanner();
+	void scan_on_worker();
+	void apply_scan(const QStringList &inputs, const QStringList &outputs);
+
+	QStringList m_inputs;
+	QStringList m_outputs;
+	QStringList m_input_ids;
+	QStringList m_output_ids;
+	bool m_devices_ready = false;
+
+	QThread *m_scan_thread = nullptr;
+	QObject *m_scan_ctx = nullptr;   // Lives on m_scan_thread
+	QTimer *m_poll_timer = nullptr;  // Lives on m_scan_thread
+	std::atomic<bool> m_scan_queued{false};
 };
+
+Q_DECLARE_METATYPE(MidiDeviceChange)
@@ -32,6 +32,8 @@ MidiRouter::MidiRouter()
 	m_backend = std::make_unique<WinMmMidiBackend>(this);
 	connect(m_backend.get(), &MidiBackend::midi_message,
 		this, &MidiRouter::on_midi_message);
+	connect(m_backend.get(), &MidiBackend::devices_changed,
+		this, &MidiRouter::on_devices_changed);
 }
 
 MidiRouter::~MidiRouter()
@@ -58,12 +60,34 @@ void MidiRouter::open_all_devices()
 {
 	if (!m_backend)
 		return;
+	m_auto_open = true;
+	// Not scanned yet: on_devices_changed opens everything from the first scan
+	if (!m_backend->devices_ready())
+		return;
 	QStringList devices = m_backend->available_input_devices();
 	for (int i = 0; i < devices.size(); i++) {
 		m_backend->open_input_device(i);
 	}
 }
 
+void MidiRouter::on_devices_changed(const MidiDeviceChange &change)
+{
+	if (m_auto_open) {
+		for (const auto &id : change.added_inputs) {
+			int index = m_backend->input_index_for_id(id);
+			if (index >= 0)
+				m_backend->open_input_device(index);
+		}
+	}
+	remap_bindings();
+}
+
+void MidiRouter::remap_bindings()
+{
+	for (auto &b : m_bindings)
+		b.device_index = m_backend->remap_input_index(b.device_index, b.device_id);
+}
+
 void MidiRouter::close_all()
 {
 	if (m_backend) {
@@ -78,12 +102,19 @@ void MidiRouter::close_all()
 void MidiRouter::add_binding(const MidiBinding &b)
 {
 	m_bindings.append(b);
+	auto &added = m_bindings.last();
+	if (added.device_id.isEmpty() && m_backend)
+		added.device_id = m_backend->input_device_id(added.device_index);
 }
 
 void MidiRouter::update_binding_at(int index, const MidiBinding &b)
 {
-	if (index >= 0 && index < m_bindings.size())
+	if (index >= 0 && index < m_bindings.size()) {
 		m_bindings[index] = b;
+		// The popup edits the index; keep the stored identity in step
+		if (m_backend && b.device_index >= 0)
+			m_bindings[index].device_id = m_backend->input_device_id(b.device_index);
+	}
 }
 
 void MidiRouter::remove_binding_at(int index)
@@ -268,6 +299,8 @@ void MidiRouter::load(const QJsonObject &obj)
 	for (const auto &val : arr) {
 		m_bindings.append(MidiBinding::from_json(val.toObject()));
 	}
+	if (m_backend)
+		remap_bindings();
 	obs_log(LOG_INFO, "MidiRouter: loaded %d bindings", m_bindings.size());
 }
 
@@ -330,6 +363,8 @@ QJsonObject MidiBinding::to_json() const
 {
 	QJsonObject obj;
 	obj["device"] = device_index;
+	if (!device_id.isEmpty())
+		obj["deviceId"] = device_id;
 	obj["channel"] = channel;
 	obj["cc"] = cc;
 	obj["type"] = (int)type;
@@ -357,6 +392,7 @@ MidiBinding MidiBinding::from_json(const QJsonObject &obj)
 {
 	MidiBinding b;
 	b.device_index = obj["device"].toInt(-1);
+	b.device_id = obj["deviceId"].toString();
 	b.channel = obj["channel"].toInt(0);
 	b.cc = obj["cc"].toInt(0);
 	b.type = (Type)obj["type"].toInt(0);
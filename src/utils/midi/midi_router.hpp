@@ -12,6 +12,7 @@
 // Persisted mapping from a MIDI message to a widget control
 struct MidiBinding {
 	int device_index = -1;  // -1 = any device
+	QString device_id;      // Stable device identity (MidiBackend::device_ids)
 	int channel = 0;        // MIDI channel 0-15
 	int cc = 0;             // CC number 0-127 (or note number for NoteOn/NoteOff)
 	enum Type { CC = 0, NoteOn = 1, NoteOff = 2 };
@@ -72,6 +73,8 @@ public:
 	MidiBackend *backend() const;
 
 	// Device management
+	// open_all_devices() also opens inputs plugged in later; before the
+	// backend's first scan it just records the request.
 	QStringList available_devices() const;
 	bool open_device(int index);
 	void open_all_devices();
@@ -111,9 +114,12 @@ private:
 	~MidiRouter() override;
 
 	void on_midi_message(int device, int status, int data1, int data2);
+	void on_devices_changed(const MidiDeviceChange &change);
+	void remap_bindings();
 
 	std::unique_ptr<MidiBackend> m_backend;
 	QVector<MidiBinding> m_bindings;
+	bool m_auto_open = false;
 
 	// Learn state
 	bool m_learning = false;
@@ -0,0 +1,244 @@
+#include "sysex_buffer.hpp"
+
+#include <cstring>
+#include <new>
+
+// Block header; payload bytes follow immediately after it.
+struct SysExBuffer::Block {
+	std::atomic<int> refs{1};
+	uint32_t size = 0;
+	uint32_t capacity = 0;
+	int size_class = -1; // -1 = oversized, freed directly
+	Block *next_free = nullptr;
+
+	uint8_t *payload() { return reinterpret_cast<uint8_t *>(this + 1); }
+	const uint8_t *payload() const { return reinterpret_cast<const uint8_t *>(this + 1); }
+
+	static Block *create(size_t capacity, int size_class)
+	{
+		void *mem = ::operator new(sizeof(Block) + capacity);
+		auto *b = new (mem) Block();
+		b->capacity = static_cast<uint32_t>(capacity);
+		b->size_class = size_class;
+		return b;
+	}
+
+	static void destroy(Block *b)
+	{
+		b->~Block();
+		::operator delete(b);
+	}
+};
+
+// ===== SysExBuffer ========================================================
+
+SysExBuffer::SysExBuffer(const SysExBuffer &other) : m_block(other.m_block)
+{
+	if (m_block)
+		m_block->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+SysExBuffer::SysExBuffer(SysExBuffer &&other) noexcept : m_block(other.m_block)
+{
+	other.m_block = nullptr;
+}
+
+SysExBuffer &SysExBuffer::operator=(const SysExBuffer &other)
+{
+	if (m_block != other.m_block) {
+		if (other.m_block)
+			other.m_block->refs.fetch_add(1, std::memory_order_relaxed);
+		release();
+		m_block = other.m_block;
+	}
+	return *this;
+}
+
+SysExBuffer &SysExBuffer::operator=(SysExBuffer &&other) noexcept
+{
+	if (this != &other) {
+		release();
+		m_block = other.m_block;
+		other.m_block = nullptr;
+	}
+	return *this;
+}
+
+SysExBuffer::~SysExBuffer()
+{
+	release();
+}
+
+void SysExBuffer::release()
+{
+	if (!m_block)
+		return;
+	if (m_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		SysExPool::instance().recycle(m_block);
+	m_block = nullptr;
+}
+
+SysExBuffer SysExBuffer::allocate(size_t capacity)
+{
+	return SysExBuffer(SysExPool::instance().acquire(capacity));
+}
+
+SysExBuffer SysExBuffer::copy_of(const uint8_t *data, size_t size)
+{
+	SysExBuffer buf = allocate(size);
+	buf.append(data, size);
+	return buf;
+}
+
+SysExBuffer SysExBuffer::copy_of(const QByteArray &bytes)
+{
+	return copy_of(reinterpret_cast<const uint8_t *>(bytes.constData()),
+		       static_cast<size_t>(bytes.size()));
+}
+
+const uint8_t *SysExBuffer::data() const
+{
+	return m_block ? m_block->payload() : nullptr;
+}
+
+uint8_t *SysExBuffer::mutable_data()
+{
+	return m_block ? m_block->payload() : nullptr;
+}
+
+size_t SysExBuffer::size() const
+{
+	return m_block ? m_block->size : 0;
+}
+
+size_t SysExBuffer::capacity() const
+{
+	return m_block ? m_block->capacity : 0;
+}
+
+bool SysExBuffer::resize(size_t size)
+{
+	if (!m_block || size > m_block->capacity)
+		return false;
+	m_block->size = static_cast<uint32_t>(size);
+	return true;
+}
+
+bool SysExBuffer::append(const uint8_t *data, size_t size)
+{
+	if (!m_block || m_block->size + size > m_block->capacity)
+		return false;
+	if (size > 0)
+		std::memcpy(m_block->payload() + m_block->size, data, size);
+	m_block->size += static_cast<uint32_t>(size);
+	return true;
+}
+
+bool SysExBuffer::is_complete() const
+{
+	size_t n = size();
+	return n >= 2 && data()[0] == 0xF0 && data()[n - 1] == 0xF7;
+}
+
+int SysExBuffer::use_count() const
+{
+	return m_block ? m_block->refs.load(std::memory_order_relaxed) : 0;
+}
+
+QByteArray SysExBuffer::to_byte_array() const
+{
+	return QByteArray(reinterpret_cast<const char *>(data()), static_cast<qsizetype>(size()));
+}
+
+// ===== SysExPool ==========================================================
+
+SysExPool &SysExPool::instance()
+{
+	static SysExPool s_pool;
+	return s_pool;
+}
+
+SysExPool::~SysExPool()
+{
+	for (auto &list : m_free) {
+		std::lock_guard<std::mutex> lock(list.mutex);
+		while (list.head) {
+			auto *next = list.head->next_free;
+			SysExBuffer::Block::destroy(list.head);
+			list.head = next;
+		}
+		list.count = 0;
+	}
+}
+
+static int size_class_for(size_t capacity, const size_t *sizes, int count)
+{
+	for (int i = 0; i < count; i++) {
+		if (capacity <= sizes[i])
+			return i;
+	}
+	return -1;
+}
+
+void SysExPool::reserve(size_t capacity, int count)
+{
+	int cls = size_class_for(capacity, kClassSizes, kClassCount);
+	if (cls < 0)
+		return;
+	auto &list = m_free[cls];
+	std::lock_guard<std::mutex> lock(list.mutex);
+	for (int i = 0; i < count; i++) {
+		auto *b = SysExBuffer::Block::create(kClassSizes[cls], cls);
+		b->next_free = list.head;
+		list.head = b;
+		list.count++;
+	}
+}
+
+int SysExPool::blocks_pooled() const
+{
+	int total = 0;
+	for (const auto &list : m_free) {
+		std::lock_guard<std::mutex> lock(list.mutex);
+		total += list.count;
+	}
+	return total;
+}
+
+SysExBuffer::Block *SysExPool::acquire(size_t capacity)
+{
+	m_in_use.fetch_add(1, std::memory_order_relaxed);
+
+	int cls = size_class_for(capacity, kClassSizes, kClassCount);
+	if (cls < 0)
+		return SysExBuffer::Block::create(capacity, -1);
+
+	auto &list = m_free[cls];
+	{
+		std::lock_guard<std::mutex> lock(list.mutex);
+		if (auto *b = list.head) {
+			list.head = b->next_free;
+			list.count--;
+			b->next_free = nullptr;
+			b->size = 0;
+			b->refs.store(1, std::memory_order_relaxed);
+			return b;
+		}
+	}
+	return SysExBuffer::Block::create(kClassSizes[cls], cls);
+}
+
+void SysExPool::recycle(SysExBuffer::Block *block)
+{
+	m_in_use.fetch_sub(1, std::memory_order_relaxed);
+
+	if (block->size_class < 0) {
+		SysExBuffer::Block::destroy(block);
+		return;
+	}
+	auto &list = m_free[block->size_class];
+	std::lock_guard<std::mutex> lock(list.mutex);
+	block->next_free = list.head;
+	list.head = block;
+	list.count++;
+}
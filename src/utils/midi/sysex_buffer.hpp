@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Pooled, reference-counted byte buffer for SysEx messages.
+//
+// Buffers are carved from a process-wide pool of size-classed blocks. Once a
+// block has been released it goes back on its class free list, so steady-state
+// SysEx traffic does not touch the heap. Copies share the same block (the
+// reference count is atomic), which lets a message travel from the MIDI
+// callback thread to a Blob ControlPort inside a QVariant without copying the
+// payload.
+//
+// A buffer is writable while it has a single owner; once it has been shared
+// it should be treated as immutable.
+class SysExBuffer {
+public:
+	SysExBuffer() = default;
+	SysExBuffer(const SysExBuffer &other);
+	SysExBuffer(SysExBuffer &&other) noexcept;
+	SysExBuffer &operator=(const SysExBuffer &other);
+	SysExBuffer &operator=(SysExBuffer &&other) noexcept;
+	~SysExBuffer();
+
+	// Acquire an empty buffer able to hold at least `capacity` bytes.
+	static SysExBuffer allocate(size_t capacity);
+
+	// Acquire a buffer and copy `size` bytes into it.
+	static SysExBuffer copy_of(const uint8_t *data, size_t size);
+	static SysExBuffer copy_of(const QByteArray &bytes);
+
+	bool is_null() const { return m_block == nullptr; }
+	bool is_empty() const { return size() == 0; }
+
+	const uint8_t *data() const;
+	uint8_t *mutable_data();
+	size_t size() const;
+	size_t capacity() const;
+
+	// Resize within the existing capacity. Returns false if it doesn't fit.
+	bool resize(size_t size);
+
+	// Append bytes within the existing capacity. Returns false if they don't fit.
+	bool append(const uint8_t *data, size_t size);
+
+	// True if the payload is a complete F0 … F7 frame.
+	bool is_complete() const;
+
+	// Number of SysExBuffer handles sharing the block.
+	int use_count() const;
+
+	// Deep copy for serialization / display (allocates).
+	QByteArray to_byte_array() const;
+
+	// Identity comparison: two handles are equal if they share a block.
+	// Keeps QVariant change detection cheap for Blob ports.
+	bool operator==(const SysExBuffer &other) const { return m_block == other.m_block; }
+	bool operator!=(const SysExBuffer &other) const { return m_block != other.m_block; }
+
+	struct Block;
+
+private:
+	explicit SysExBuffer(Block *block) : m_block(block) {}
+	void release();
+
+	Block *m_block = nullptr;
+};
+
+Q_DECLARE_METATYPE(SysExBuffer)
+
+// Size-classed block pool backing SysExBuffer.
+class SysExPool {
+public:
+	static SysExPool &instance();
+
+	// Pre-allocate `count` blocks for the size class that fits `capacity`,
+	// so the first messages after startup don't allocate either.
+	void reserve(size_t capacity, int count);
+
+	// Blocks currently handed out / sitting on free lists (for diagnostics).
+	int blocks_in_use() const { return m_in_use.load(std::memory_order_relaxed); }
+	int blocks_pooled() const;
+
+	// Payloads larger than the biggest class are allocated directly.
+	static constexpr size_t kMaxPooledSize = 65536;
+
+private:
+	friend class SysExBuffer;
+
+	SysExPool() = default;
+	~SysExPool();
+	SysExPool(const SysExPool &) = delete;
+	SysExPool &operator=(const SysExPool &) = delete;
+
+	SysExBuffer::Block *acquire(size_t capacity);
+	void recycle(SysExBuffer::Block *block);
+
+	static constexpr int kClassCount = 4;
+	static constexpr size_t kClassSizes[kClassCount] = {128, 1024, 8192, kMaxPooledSize};
+
+	struct FreeList {
+		mutable std::mutex mutex;
+		SysExBuffer::Block *head = nullptr;
+		int count = 0;
+	};
+	FreeList m_free[kClassCount];
+	std::atomic<int> m_in_use{0};
+};
@@ -3,24 +3,27 @@
 #include <obs.h>
 #include <plugin-support.h>
 
+#include <chrono>
+
 #pragma comment(lib, "winmm.lib")
 
 WinMmMidiBackend::WinMmMidiBackend(QObject *parent)
 	: MidiBackend(parent)
 {
-	m_cached_inputs = available_input_devices();
-	m_cached_outputs = available_output_devices();
+	// First scan runs in the background; devices_changed() reports it
+	refresh_devices();
 }
 
 WinMmMidiBackend::~WinMmMidiBackend()
 {
+	stop_device_scanner();
 	WinMmMidiBackend::close_all_inputs();
 	WinMmMidiBackend::close_all_outputs();
 }
 
 // ===== Input ==============================================================
 
-QStringList WinMmMidiBackend::available_input_devices() const
+QStringList WinMmMidiBackend::enumerate_inputs() const
 {
 	QStringList devices;
 	UINT count = midiInGetNumDevs();
@@ -53,20 +56,58 @@ bool WinMmMidiBackend::open_input_device(int index)
 		return false;
 	}
 
-	midiInStart(handle);
-	m_open_devices.push_back({handle, index});
+	// Queue SysEx buffers before starting so long messages are captured
+	auto sysex = std::make_unique<SysExInput>();
+	for (int i = 0; i < SysExInput::kBufferCount; i++) {
+		MIDIHDR &hdr = sysex->headers[i];
+		hdr.lpData = sysex->data[i];
+		hdr.dwBufferLength = SysExInput::kBufferSize;
+		hdr.dwFlags = 0;
+		if (midiInPrepareHeader(handle, &hdr, sizeof(MIDIHDR)) == MMSYSERR_NOERROR)
+			midiInAddBuffer(handle, &hdr, sizeof(MIDIHDR));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_devices_mutex);
+		m_open_devices.push_back({handle, index, input_device_id(index), std::move(sysex)});
+	}
+	midiInStart(handle);  // Only once the callback can find the device
 	obs_log(LOG_INFO, "WinMM: opened MIDI input device %d", index);
 	return true;
 }
 
+void WinMmMidiBackend::close_input(OpenDevice &dev)
+{
+	// Already out of m_open_devices, so the callback ignores the buffers
+	// midiInReset() hands back and nothing re-queues them
+	midiInStop(dev.handle);
+	midiInReset(dev.handle);
+	if (dev.sysex) {
+		for (auto &hdr : dev.sysex->headers)
+			midiInUnprepareHeader(dev.handle, &hdr, sizeof(MIDIHDR));
+	}
+	midiInClose(dev.handle);
+}
+
 void WinMmMidiBackend::close_all_inputs()
 {
-	for (auto &dev : m_open_devices) {
-		midiInStop(dev.handle);
-		midiInReset(dev.handle);
-		midiInClose(dev.handle);
+	std::vector<OpenDevice> closing;
+	{
+		std::lock_guard<std::mutex> lock(m_devices_mutex);
+		closing.swap(m_open_devices);
+	}
+	for (auto &dev : closing)
+		close_input(dev);
+}
+
+int WinMmMidiBackend::input_index_for_handle(HMIDIIN handle)
+{
+	std::lock_guard<std::mutex> lock(m_devices_mutex);
+	for (const auto &dev : m_open_devices) {
+		if (dev.handle == handle)
+			return dev.index;
 	}
-	m_open_devices.clear();
+	return -1;
 }
 
 void CALLBACK WinMmMidiBackend::midi_in_proc(HMIDIIN hMidi, UINT wMsg,
@@ -74,22 +115,34 @@ void CALLBACK WinMmMidiBackend::midi_in_proc(HMIDIIN hMidi, UINT wMsg,
 {
 	Q_UNUSED(dwParam2);
 
-	if (wMsg != MIM_DATA)
+	auto *self = reinterpret_cast<WinMmMidiBackend *>(dwInstance);
+
+	if (wMsg == MIM_LONGDATA || wMsg == MIM_LONGERROR) {
+		self->on_long_data(hMidi, reinterpret_cast<MIDIHDR *>(dwParam1));
 		return;
+	}
 
-	auto *self = reinterpret_cast<WinMmMidiBackend *>(dwInstance);
+	if (wMsg != MIM_DATA)
+		return;
 
 	int status = (int)(dwParam1 & 0xFF);
 	int data1 = (int)((dwParam1 >> 8) & 0xFF);
 	int data2 = (int)((dwParam1 >> 16) & 0xFF);
 
 	// Resolve device index from handle
-	int device_index = -1;
-	for (const auto &dev : self->m_open_devices) {
-		if (dev.handle == hMidi) {
-			device_index = dev.index;
-			break;
-		}
+	int device_index = self->input_index_for_handle(hMidi);
+
+	// Clock / MTC: stamp here, before the hop to the Qt thread adds jitter
+	if (MidiBackend::is_timing_status(status)) {
+		qint64 timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		int data = status == 0xF2 ? (data1 | (data2 << 7)) : data1;
+		QMetaObject::invokeMethod(self,
+			[self, device_index, status, data, timestamp_ns]() {
+				emit self->midi_timing(device_index, status, data, timestamp_ns);
+			},
+			Qt::QueuedConnection);
+		return;
 	}
 
 	// Post to Qt main thread (callback runs on a WinMM thread)
@@ -100,9 +153,86 @@ void CALLBACK WinMmMidiBackend::midi_in_proc(HMIDIIN hMidi, UINT wMsg,
 		Qt::QueuedConnection);
 }
 
+// Runs on the WinMM callback thread. Reassembles SysEx that may span several
+// driver buffers into a pooled SysExBuffer, posted to the Qt thread by
+// reference. midiInAddBuffer may not be called from a callback, so the
+// driver buffer is handed back from the Qt thread.
+void WinMmMidiBackend::on_long_data(HMIDIIN handle, MIDIHDR *hdr)
+{
+	// Held for the whole pass so a rescan can't free `in` underneath us
+	std::lock_guard<std::mutex> lock(m_devices_mutex);
+	SysExInput *in = nullptr;
+	int device_index = -1;
+	for (const auto &dev : m_open_devices) {
+		if (dev.handle == handle) {
+			in = dev.sysex.get();
+			device_index = dev.index;
+			break;
+		}
+	}
+	if (!in || !hdr)
+		return;
+
+	const auto *bytes = reinterpret_cast<const uint8_t *>(hdr->lpData);
+	size_t count = hdr->dwBytesRecorded;
+
+	for (size_t i = 0; i < count; i++) {
+		uint8_t b = bytes[i];
+		if (b == 0xF0) {
+			// New message; drop any unterminated fragment
+			in->assembling = SysExBuffer::allocate(SysExInput::kBufferSize);
+		} else if (in->assembling.is_null()) {
+			continue;  // Stray continuation bytes
+		}
+
+		if (in->assembling.size() == in->assembling.capacity()) {
+			// Grow into the next size class (rare: multi-KB dumps)
+			auto grown = SysExBuffer::allocate(in->assembling.capacity() * 2);
+			grown.append(in->assembling.data(), in->assembling.size());
+			in->assembling = std::move(grown);
+		}
+		in->assembling.append(&b, 1);
+
+		if (b == 0xF7) {
+			SysExBuffer msg = std::move(in->assembling);
+			in->assembling = SysExBuffer();
+			QMetaObject::invokeMethod(this,
+				[this, device_index, msg]() {
+					emit sysex_message(device_index, msg);
+				},
+				Qt::QueuedConnection);
+		}
+	}
+
+	QMetaObject::invokeMethod(this,
+		[this, handle, hdr]() { requeue_input_buffer(handle, hdr); },
+		Qt::QueuedConnection);
+}
+
+void WinMmMidiBackend::requeue_input_buffer(HMIDIIN handle, MIDIHDR *hdr)
+{
+	// This thread is the only writer of m_open_devices, so no lock needed.
+	// A device closed since the post no longer owns `hdr`, and WinMM may
+	// hand its handle value to a newly opened one: only requeue a header
+	// that belongs to the live device's own pool.
+	for (const auto &dev : m_open_devices) {
+		if (dev.handle != handle || !dev.sysex)
+			continue;
+		for (MIDIHDR &own : dev.sysex->headers) {
+			// A new pool at the old address may already have it queued
+			if (&own == hdr && !(hdr->dwFlags & MHDR_INQUEUE)) {
+				hdr->dwBytesRecorded = 0;
+				midiInAddBuffer(handle, hdr, sizeof(MIDIHDR));
+				return;
+			}
+		}
+		return;
+	}
+}
+
 // ===== Output =============================================================
 
-QStringList WinMmMidiBackend::available_output_devices() const
+QStringList WinMmMidiBackend::enumerate_outputs() const
 {
 	QStringList devices;
 	UINT count = midiOutGetNumDevs();
@@ -127,7 +257,7 @@ bool WinMmMidiBackend::open_output_device(int index)
 
 	HMIDIOUT handle = nullptr;
 	MMRESULT result = midiOutOpen(&handle, (UINT)index,
-		0, 0, CALLBACK_NULL);
+		(DWORD_PTR)midi_out_proc, (DWORD_PTR)this, CALLBACK_FUNCTION);
 
 	if (result != MMSYSERR_NOERROR) {
 		obs_log(LOG_WARNING, "WinMM: failed to open MIDI out device %d (error %u)",
@@ -135,17 +265,24 @@ bool WinMmMidiBackend::open_output_device(int index)
 		return false;
 	}
 
-	m_open_outputs.push_back({handle, index});
+	m_open_outputs.push_back({handle, index, output_device_id(index),
+		std::make_unique<SysExOutput>()});
 	obs_log(LOG_INFO, "WinMM: opened MIDI output device %d", index);
 	return true;
 }
 
+void WinMmMidiBackend::close_output(OpenOutputDevice &dev)
+{
+	midiOutReset(dev.handle);  // Marks every queued header done
+	if (dev.sysex)
+		release_sysex_slots(dev.handle, *dev.sysex);
+	midiOutClose(dev.handle);
+}
+
 void WinMmMidiBackend::close_all_outputs()
 {
-	for (auto &dev : m_open_outputs) {
-		midiOutReset(dev.handle);
-		midiOutClose(dev.handle);
-	}
+	for (auto &dev : m_open_outputs)
+		close_output(dev);
 	m_open_outputs.clear();
 }
 
@@ -173,31 +310,158 @@ void WinMmMidiBackend::send_cc(int device, int channel, int cc, int value)
 	}
 }
 
-// ===== Hot-Detection ======================================================
+void WinMmMidiBackend::send_sysex(int device, const SysExBuffer &msg)
+{
+	if (msg.is_empty())
+		return;
+
+	for (auto &dev : m_open_outputs) {
+		if (device != -1 && dev.index != device)
+			continue;
+		if (dev.sysex)
+			send_sysex_to(dev.handle, *dev.sysex, msg);
+		if (device != -1)
+			break;
+	}
+}
+
+void CALLBACK WinMmMidiBackend::midi_out_proc(HMIDIOUT hMidi, UINT wMsg,
+	DWORD_PTR dwInstance, DWORD_PTR dwParam1, DWORD_PTR dwParam2)
+{
+	Q_UNUSED(dwParam1);
+	Q_UNUSED(dwParam2);
+
+	if (wMsg != MOM_DONE)
+		return;
+	auto *self = reinterpret_cast<WinMmMidiBackend *>(dwInstance);
+	QMetaObject::invokeMethod(self,
+		[self, hMidi]() { self->on_output_done(hMidi); },
+		Qt::QueuedConnection);
+}
+
+void WinMmMidiBackend::on_output_done(HMIDIOUT handle)
+{
+	for (auto &dev : m_open_outputs) {
+		if (dev.handle == handle && dev.sysex) {
+			pump_sysex(handle, *dev.sysex);
+			return;
+		}
+	}
+}
 
-void WinMmMidiBackend::start_device_poll(int interval_ms)
+// Queue the message and send what fits. The chunks of one message are
+// submitted in order, so they stay contiguous on the wire; pacing between
+// messages is done by the caller.
+void WinMmMidiBackend::send_sysex_to(HMIDIOUT handle, SysExOutput &out,
+	const SysExBuffer &msg)
 {
-	if (!m_poll_timer) {
-		m_poll_timer = new QTimer(this);
-		connect(m_poll_timer, &QTimer::timeout, this, &WinMmMidiBackend::check_device_changes);
+	out.queue.push_back({msg, 0});
+	pump_sysex(handle, out);
+}
+
+// Reclaims slots the driver has finished with and fills them from the
+// queue. A header is only unprepared or reused once MHDR_DONE is set.
+void WinMmMidiBackend::pump_sysex(HMIDIOUT handle, SysExOutput &out)
+{
+	for (int i = 0; i < SysExOutput::kSlotCount; i++) {
+		if (out.prepared[i] && (out.headers[i].dwFlags & MHDR_DONE)) {
+			midiOutUnprepareHeader(handle, &out.headers[i], sizeof(MIDIHDR));
+			out.prepared[i] = false;
+			out.refs[i] = SysExBuffer();
+		}
+	}
+
+	int slot = 0;
+	while (!out.queue.empty()) {
+		while (slot < SysExOutput::kSlotCount && out.prepared[slot])
+			slot++;
+		if (slot == SysExOutput::kSlotCount)
+			return;  // All in flight; MOM_DONE resumes
+
+		SysExOutput::Pending &p = out.queue.front();
+		size_t n = qMin(SysExOutput::kChunkBytes, p.msg.size() - p.offset);
+		MIDIHDR &hdr = out.headers[slot];
+		hdr = {};
+		hdr.lpData = reinterpret_cast<LPSTR>(const_cast<uint8_t *>(p.msg.data() + p.offset));
+		hdr.dwBufferLength = static_cast<DWORD>(n);
+		hdr.dwBytesRecorded = static_cast<DWORD>(n);
+
+		MMRESULT result = midiOutPrepareHeader(handle, &hdr, sizeof(MIDIHDR));
+		if (result == MMSYSERR_NOERROR) {
+			result = midiOutLongMsg(handle, &hdr, sizeof(MIDIHDR));
+			if (result != MMSYSERR_NOERROR)
+				midiOutUnprepareHeader(handle, &hdr, sizeof(MIDIHDR));  // Never queued
+		}
+		if (result != MMSYSERR_NOERROR) {
+			obs_log(LOG_WARNING, "WinMM: SysEx send failed (error %u)", result);
+			out.queue.pop_front();  // Drop the rest of this message
+			continue;
+		}
+
+		out.prepared[slot] = true;
+		out.refs[slot] = p.msg;  // Keep payload alive while the driver reads it
+		p.offset += n;
+		if (p.offset >= p.msg.size())
+			out.queue.pop_front();
 	}
-	m_cached_inputs = available_input_devices();
-	m_cached_outputs = available_output_devices();
-	m_poll_timer->start(interval_ms);
 }
 
-void WinMmMidiBackend::stop_device_poll()
+// Only valid after midiOutReset(), which returns every header to us.
+void WinMmMidiBackend::release_sysex_slots(HMIDIOUT handle, SysExOutput &out)
 {
-	if (m_poll_timer) m_poll_timer->stop();
+	for (int i = 0; i < SysExOutput::kSlotCount; i++) {
+		if (out.prepared[i]) {
+			midiOutUnprepareHeader(handle, &out.headers[i], sizeof(MIDIHDR));
+			out.prepared[i] = false;
+		}
+		out.refs[i] = SysExBuffer();
+	}
+	out.queue.clear();
 }
 
-void WinMmMidiBackend::check_device_changes()
+// ===== Hot-Detection ======================================================
+
+// Open handles stay valid across a rescan, but their list positions may have
+// moved. Re-key them by id so messages keep reporting the right index, and
+// close the ones whose device disappeared.
+void WinMmMidiBackend::on_devices_rescanned()
 {
-	QStringList in_now = available_input_devices();
-	QStringList out_now = available_output_devices();
-	if (in_now != m_cached_inputs || out_now != m_cached_outputs) {
-		m_cached_inputs = in_now;
-		m_cached_outputs = out_now;
-		emit devices_changed();
+	std::vector<OpenDevice> gone;
+	{
+		std::lock_guard<std::mutex> lock(m_devices_mutex);
+		for (auto it = m_open_devices.begin(); it != m_open_devices.end();) {
+			int now = input_index_for_id(it->id);
+			if (now < 0 && !it->id.isEmpty()) {
+				gone.push_back(std::move(*it));
+				it = m_open_devices.erase(it);
+				continue;
+			}
+			if (now >= 0)
+				it->index = now;
+			else
+				it->id = input_device_id(it->index);  // Opened before the first scan
+			++it;
+		}
+	}
+	for (auto &dev : gone) {
+		obs_log(LOG_INFO, "WinMM: MIDI input '%s' disappeared",
+			dev.id.toUtf8().constData());
+		close_input(dev);
+	}
+
+	for (auto it = m_open_outputs.begin(); it != m_open_outputs.end();) {
+		int now = output_index_for_id(it->id);
+		if (now < 0 && !it->id.isEmpty()) {
+			obs_log(LOG_INFO, "WinMM: MIDI output '%s' disappeared",
+				it->id.toUtf8().constData());
+			close_output(*it);
+			it = m_open_outputs.erase(it);
+			continue;
+		}
+		if (now >= 0)
+			it->index = now;
+		else
+			it->id = output_device_id(it->index);
+		++it;
 	}
 }
@@ -5,8 +5,10 @@
 #include <Windows.h>
 #include <mmsystem.h>
 
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <vector>
-#include <QTimer>
 
 class WinMmMidiBackend : public MidiBackend {
 	Q_OBJECT
@@ -16,40 +18,80 @@ public:
 	~WinMmMidiBackend() override;
 
 	// --- Input ---
-	QStringList available_input_devices() const override;
 	bool open_input_device(int index) override;
 	void close_all_inputs() override;
 
 	// --- Output ---
-	QStringList available_output_devices() const override;
 	bool open_output_device(int index) override;
 	void close_all_outputs() override;
 	void send_cc(int device, int channel, int cc, int value) override;
+	void send_sysex(int device, const SysExBuffer &msg) override;
 
-	// --- Hot-Detection ---
-	void start_device_poll(int interval_ms = 2000) override;
-	void stop_device_poll() override;
+protected:
+	QStringList enumerate_inputs() const override;
+	QStringList enumerate_outputs() const override;
+	void on_devices_rescanned() override;
 
 private:
 	static void CALLBACK midi_in_proc(HMIDIIN hMidi, UINT wMsg,
 		DWORD_PTR dwInstance, DWORD_PTR dwParam1, DWORD_PTR dwParam2);
+	static void CALLBACK midi_out_proc(HMIDIOUT hMidi, UINT wMsg,
+		DWORD_PTR dwInstance, DWORD_PTR dwParam1, DWORD_PTR dwParam2);
+
+	// SysEx input: a few driver buffers kept queued on the device, plus the
+	// message being reassembled when a dump spans several buffers.
+	struct SysExInput {
+		static constexpr int kBufferCount = 4;
+		static constexpr int kBufferSize = 1024;
+		MIDIHDR headers[kBufferCount] = {};
+		char data[kBufferCount][kBufferSize] = {};
+		SysExBuffer assembling;  // Touched only on the WinMM callback thread
+	};
 
-	void check_device_changes();
+	// SysEx output: a few long-message headers in flight, plus the chunks
+	// still waiting for one. Each slot keeps a reference to the buffer it
+	// points into until the driver marks it done; MOM_DONE refills slots.
+	struct SysExOutput {
+		static constexpr int kSlotCount = 8;
+		static constexpr size_t kChunkBytes = 1024;
+		struct Pending {
+			SysExBuffer msg;
+			size_t offset = 0;
+		};
+		MIDIHDR headers[kSlotCount] = {};
+		SysExBuffer refs[kSlotCount];
+		bool prepared[kSlotCount] = {};
+		std::deque<Pending> queue;
+	};
+
+	void on_long_data(HMIDIIN handle, MIDIHDR *hdr);
+	void requeue_input_buffer(HMIDIIN handle, MIDIHDR *hdr);
+	void on_output_done(HMIDIOUT handle);
+	void send_sysex_to(HMIDIOUT handle, SysExOutput &out, const SysExBuffer &msg);
+	static void pump_sysex(HMIDIOUT handle, SysExOutput &out);
+	static void release_sysex_slots(HMIDIOUT handle, SysExOutput &out);
 
 	struct OpenDevice {
 		HMIDIIN handle;
-		int index;
+		int index;      // Current position in the cached list
+		QString id;     // Stable identity, re-keys `index` after a rescan
+		std::unique_ptr<SysExInput> sysex;
 	};
+	// Read by the WinMM callback thread; mutate only under m_devices_mutex.
+	// Closing happens after an entry is taken out, never under the lock,
+	// because midiInReset() calls back into midi_in_proc().
 	std::vector<OpenDevice> m_open_devices;
+	std::mutex m_devices_mutex;
 
 	struct OpenOutputDevice {
 		HMIDIOUT handle;
 		int index;
+		QString id;
+		std::unique_ptr<SysExOutput> sysex;
 	};
 	std::vector<OpenOutputDevice> m_open_outputs;
 
-	// Hot-detect
-	QTimer *m_poll_timer = nullptr;
-	QStringList m_cached_inputs;
-	QStringList m_cached_outputs;
+	void close_input(OpenDevice &dev);
+	int input_index_for_handle(HMIDIIN handle);
+	void close_output(OpenOutputDevice &dev);
 };
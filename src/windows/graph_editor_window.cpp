@@ -1,4 +1,5 @@
 #include "graph_editor_window.hpp"
+#include "../super/modules/graph/graph_node.hpp"
 
 #include <QVBoxLayout>
 #include <QPainter>
@@ -13,7 +14,11 @@
 #include <QApplication>
 #include <QLabel>
 #include <QJsonDocument>
+#include <QHBoxLayout>
+#include <QListWidget>
+#include <QTimer>
 #include <QtMath>
+#include <algorithm>
 
 // ═══════════════════════════════════════════════════════════════════════════
 namespace graph {
@@ -37,6 +42,24 @@ QColor GraphNode::type_color(Type t) {
 	return cols[static_cast<int>(t)];
 }
 
+// Cold (blue) → warm (amber) → hot (red)
+QColor GraphNode::heat_color(double heat) {
+	heat = qBound(0.0, heat, 1.0);
+	if (heat < 0.5) {
+		double t = heat * 2.0;
+		return QColor::fromRgbF(0.25 + 0.75 * t, 0.45 + 0.25 * t, 1.0 - 0.8 * t);
+	}
+	double t = (heat - 0.5) * 2.0;
+	return QColor::fromRgbF(1.0, 0.7 - 0.55 * t, 0.2 - 0.1 * t);
+}
+
+void GraphNode::set_heat(double heat) {
+	if (heat == m_heat)
+		return;
+	m_heat = heat;
+	update();
+}
+
 GraphNode::GraphNode(Type type, const QString &label, QGraphicsItem *parent)
 	: QGraphicsItem(parent), m_type(type), m_label(label)
 {
@@ -120,6 +143,17 @@ void GraphNode::paint(QPainter *p, const QStyleOptionGraphicsItem *, QWidget *)
 	p->setPen(QPen(QColor(255, 255, 255, 40), 1));
 	p->drawLine(QPointF(1, 22), QPointF(W - 1, 22));
 
+	// Profiling heat: outline + bar along the bottom edge
+	if (m_heat >= 0.0) {
+		QColor hc = heat_color(m_heat);
+		p->setBrush(Qt::NoBrush);
+		p->setPen(QPen(hc, 1.5 + 2.0 * m_heat));
+		p->drawRoundedRect(QRectF(0, 0, W, H), 8, 8);
+		p->setPen(Qt::NoPen);
+		p->setBrush(hc);
+		p->drawRect(QRectF(8, H - 6, (W - 16) * qMax(0.03, m_heat), 3));
+	}
+
 	// === Ports ===
 	auto draw_port = [&](QPointF center, bool is_input, bool hovered) {
 		// Glow
@@ -189,6 +223,7 @@ QJsonObject GraphNode::to_json() const {
 	o["label"] = m_label;
 	o["x"]     = pos().x();
 	o["y"]     = pos().y();
+	o["engine_id"] = m_engine_id.toString();
 	if (!properties.isEmpty()) o["props"] = properties;
 	return o;
 }
@@ -197,6 +232,8 @@ GraphNode *GraphNode::from_json(const QJsonObject &o) {
 	auto *n = new GraphNode(static_cast<Type>(o["type"].toInt()), o["label"].toString());
 	n->setPos(o["x"].toDouble(), o["y"].toDouble());
 	if (o.contains("props")) n->properties = o["props"].toObject();
+	QUuid id = QUuid::fromString(o["engine_id"].toString());
+	if (!id.isNull()) n->m_engine_id = id;
 	return n;
 }
 
@@ -438,6 +475,7 @@ GraphEditorWindow::GraphEditorWindow(QWidget *parent)
 	setMinimumSize(800, 550);
 	resize(1100, 700);
 	setStyleSheet(WIN_STYLE);
+	m_engine = new super::GraphEngine(this);
 	setup_ui();
 }
 
@@ -453,7 +491,24 @@ void GraphEditorWindow::setup_ui()
 	m_view->setContextMenuPolicy(Qt::CustomContextMenu);
 	connect(m_view, &QGraphicsView::customContextMenuRequested, this, &GraphEditorWindow::context_menu);
 
-	top->addWidget(m_view);
+	// Hottest-nodes panel, shown while profiling
+	m_hot_list = new QListWidget(this);
+	m_hot_list->setFixedWidth(260);
+	m_hot_list->setStyleSheet(
+		"QListWidget { background:#12121a; color:#c8c8d8; border:none;"
+		" border-left:1px solid #2a2a3a; font-size:11px; }");
+	m_hot_list->hide();
+
+	auto *row = new QHBoxLayout();
+	row->setContentsMargins(0, 0, 0, 0);
+	row->setSpacing(0);
+	row->addWidget(m_view, 1);
+	row->addWidget(m_hot_list);
+	top->addLayout(row);
+
+	m_profile_timer = new QTimer(this);
+	m_profile_timer->setInterval(500);
+	connect(m_profile_timer, &QTimer::timeout, this, &GraphEditorWindow::refresh_profile);
 
 	// DnD wiring
 	connect(m_scene, &graph::GraphScene::edge_created, this,
@@ -467,6 +522,7 @@ void GraphEditorWindow::setup_ui()
 			auto *edge = new graph::GraphEdge(src, sp, dst, dp);
 			m_scene->addItem(edge);
 			m_edges.append(edge);
+			sync_engine();
 		});
 
 	// Double-click properties
@@ -482,6 +538,7 @@ void GraphEditorWindow::add_node(graph::GraphNode::Type type, const QPointF &pos
 	node->setPos(p);
 	m_scene->addItem(node);
 	m_nodes.append(node);
+	sync_engine();
 }
 
 void GraphEditorWindow::delete_selected()
@@ -511,6 +568,7 @@ void GraphEditorWindow::delete_selected()
 			delete node;
 		}
 	}
+	sync_engine();
 }
 
 void GraphEditorWindow::clear_graph()
@@ -519,6 +577,7 @@ void GraphEditorWindow::clear_graph()
 	for (auto *n : m_nodes) { m_scene->removeItem(n); delete n; }
 	m_edges.clear();
 	m_nodes.clear();
+	sync_engine();
 }
 
 void GraphEditorWindow::show_node_properties(graph::GraphNode *node)
@@ -657,6 +716,7 @@ void GraphEditorWindow::show_node_properties(graph::GraphNode *node)
 		default: break;
 		}
 		node->properties = props;
+		sync_engine();
 	}
 }
 
@@ -687,6 +747,7 @@ void GraphEditorWindow::context_menu(const QPoint &view_pos)
 						auto *e = new graph::GraphEdge(n1, 0, n2, 0);
 						m_scene->addItem(e);
 						m_edges.append(e);
+						sync_engine();
 					});
 			}
 			if (n2->out_count() > 0 && n1->in_count() > 0) {
@@ -695,6 +756,7 @@ void GraphEditorWindow::context_menu(const QPoint &view_pos)
 						auto *e = new graph::GraphEdge(n2, 0, n1, 0);
 						m_scene->addItem(e);
 						m_edges.append(e);
+						sync_engine();
 					});
 			}
 			menu.addSeparator();
@@ -714,6 +776,12 @@ void GraphEditorWindow::context_menu(const QPoint &view_pos)
 		}
 	}
 
+	menu.addSeparator();
+	auto *prof = menu.addAction("📊 Profile Nodes");
+	prof->setCheckable(true);
+	prof->setChecked(m_engine->is_profiling());
+	connect(prof, &QAction::toggled, this, &GraphEditorWindow::set_profiling);
+
 	menu.addSeparator();
 	menu.addAction("🔲 Select All  (Ctrl+A)", this, [this]{
 		QPainterPath path;
@@ -724,3 +792,192 @@ void GraphEditorWindow::context_menu(const QPoint &view_pos)
 
 	menu.exec(m_view->mapToGlobal(view_pos));
 }
+
+// ===== Engine mirror =======================================================
+
+// Engine equivalent of an editor node: a GraphEngine::load() node entry plus
+// the engine pin behind each editor port. False for types with none.
+struct EngineMapping {
+	QJsonObject node;
+	QStringList ins, outs;
+};
+
+static bool map_to_engine(const graph::GraphNode *n, EngineMapping &m)
+{
+	const QJsonObject &pr = n->properties;
+	auto make = [&](const QString &type, const QJsonObject &state,
+					const QJsonObject &defaults, QStringList ins, QStringList outs) {
+		m.node = {{"id", n->engine_id().toString()}, {"type", type}, {"name", n->label()}};
+		if (!state.isEmpty())
+			m.node["state"] = state;
+		if (!defaults.isEmpty())
+			m.node["pin_defaults"] = defaults;
+		m.ins = std::move(ins);
+		m.outs = std::move(outs);
+		return true;
+	};
+	auto math = [&](int op, double b) {
+		return make("math", {{"op", op}}, {{"b", b}}, {"a"}, {"result"});
+	};
+
+	switch (n->node_type()) {
+	case graph::GraphNode::Constant:
+		return make("constant", {{"value", pr["value"].toDouble()}}, {}, {}, {"value"});
+
+	case graph::GraphNode::Output:
+		return make("port_write", {{"port", pr["port_id"].toString()}}, {}, {"value"}, {});
+
+	case graph::GraphNode::Math: {
+		// Editor ops carry their second operand in "value"
+		static const QHash<QString, int> ops = {
+			{"Add", 0}, {"Subtract", 1}, {"Multiply", 2}, {"Divide", 3}
+		};
+		const QString op = pr["op"].toString("Add");
+		const double v = pr["value"].toDouble();
+		if (ops.contains(op))
+			return math(ops[op], v);
+		if (op == "Clamp")
+			return make("clamp", {}, {{"min", 0.0}, {"max", v}}, {"value"}, {"result"});
+		return false;
+	}
+
+	case graph::GraphNode::Filter: {
+		const QString sub = pr["subtype"].toString("Delay");
+		if (sub == "Clamp")
+			return make("clamp", {}, {{"min", pr["p1"].toDouble()}, {"max", pr["p2"].toDouble()}},
+						{"value"}, {"result"});
+		if (sub == "Scale")
+			return math(2, pr["p1"].toDouble());
+		return false;
+	}
+
+	case graph::GraphNode::Interp:
+		if (pr["subtype"].toString("Linear") == "Smooth")
+			return make("smooth", {}, {{"alpha", pr["p1"].toDouble()}}, {"input"}, {"output"});
+		return false;
+
+	default:
+		return false;
+	}
+}
+
+void GraphEditorWindow::sync_engine()
+{
+	QJsonArray nodes;
+	QHash<const graph::GraphNode *, int> index;
+	QVector<EngineMapping> maps;
+	for (auto *n : m_nodes) {
+		EngineMapping m;
+		if (!map_to_engine(n, m))
+			continue;
+		index.insert(n, nodes.size());
+		nodes.append(m.node);
+		maps.append(std::move(m));
+	}
+
+	QJsonArray conns;
+	for (auto *e : m_edges) {
+		const int si = index.value(e->source(), -1);
+		const int ti = index.value(e->dest(), -1);
+		if (si < 0 || ti < 0 ||
+			e->src_port() >= maps[si].outs.size() || e->dst_port() >= maps[ti].ins.size())
+			continue;
+		conns.append(QJsonObject{
+			{"id", QUuid::createUuid().toString()},
+			{"si", si}, {"source_pin", maps[si].outs[e->src_port()]},
+			{"ti", ti}, {"target_pin", maps[ti].ins[e->dst_port()]}});
+	}
+
+	m_engine->load({{"nodes", nodes}, {"connections", conns}});
+	if (m_engine->is_profiling())
+		refresh_profile();
+}
+
+// ===== Profiling ===========================================================
+
+void GraphEditorWindow::set_profiling(bool enabled)
+{
+	m_engine->set_profiling(enabled);
+	m_hot_list->setVisible(enabled);
+	if (enabled) {
+		m_profile_timer->start();
+		refresh_profile();
+		return;
+	}
+	m_profile_timer->stop();
+	m_hot_list->clear();
+	for (auto *n : m_nodes) {
+		n->set_heat(-1.0);
+		n->setToolTip({});
+	}
+}
+
+void GraphEditorWindow::refresh_profile()
+{
+	if (!m_engine->is_profiling()) {
+		set_profiling(false);
+		return;
+	}
+
+	const super::ExecutionPlan &plan = m_engine->plan();
+	const QVector<super::NodeStats> &stats = m_engine->stats();
+	const int count = qMin(plan.order.size(), stats.size());
+	const double secs = qMax(1e-3, m_engine->stats_seconds());
+
+	qint64 hottest = 1;
+	qint64 total = 0;
+	for (int i = 0; i < count; i++) {
+		hottest = qMax(hottest, stats[i].total_ns);
+		total += stats[i].total_ns;
+	}
+
+	auto describe = [&](int i) {
+		const super::NodeStats &st = stats[i];
+		double avg_us = st.calls ? st.total_ns / 1e3 / st.calls : 0.0;
+		return QString("%1\n%2 calls · avg %3 µs · max %4 µs\n%5 output changes/s")
+			.arg(plan.order[i]->display_name())
+			.arg(st.calls)
+			.arg(avg_us, 0, 'f', 1)
+			.arg(st.max_ns / 1e3, 0, 'f', 1)
+			.arg(st.output_changes / secs, 0, 'f', 1);
+	};
+
+	// Editor nodes → plan rank
+	QHash<QUuid, int> by_id;
+	for (int i = 0; i < count; i++)
+		by_id.insert(plan.order[i]->node_id(), i);
+	for (auto *n : m_nodes) {
+		const int rank = by_id.value(n->engine_id(), -1);
+		if (rank < 0) {
+			n->set_heat(-1.0);
+			n->setToolTip(m_engine->find_node(n->engine_id())
+				? QString() : QString("Not run by the graph engine"));
+			continue;
+		}
+		n->set_heat(static_cast<double>(stats[rank].total_ns) / hottest);
+		n->setToolTip(describe(rank));
+	}
+
+	// Top 10 by total time
+	QVector<int> ranks(count);
+	for (int i = 0; i < count; i++)
+		ranks[i] = i;
+	const int top = qMin(10, count);
+	std::partial_sort(ranks.begin(), ranks.begin() + top, ranks.end(),
+		[&](int a, int b) { return stats[a].total_ns > stats[b].total_ns; });
+
+	m_hot_list->clear();
+	m_hot_list->addItem(QString("Hottest nodes — %1 ms total").arg(total / 1e6, 0, 'f', 2));
+	for (int k = 0; k < top && stats[ranks[k]].calls > 0; k++) {
+		int i = ranks[k];
+		double share = total ? 100.0 * stats[i].total_ns / total : 0.0;
+		auto *item = new QListWidgetItem(QString("%1. %2 — %3 ms (%4%)")
+			.arg(k + 1)
+			.arg(plan.order[i]->display_name())
+			.arg(stats[i].total_ns / 1e6, 0, 'f', 2)
+			.arg(share, 0, 'f', 0));
+		item->setForeground(graph::GraphNode::heat_color(static_cast<double>(stats[i].total_ns) / hottest));
+		item->setToolTip(describe(i));
+		m_hot_list->addItem(item);
+	}
+}
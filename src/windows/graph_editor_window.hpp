@@ -7,6 +7,8 @@
 //   - Double-click nodes for property editing
 //   - Right-click context menu for all operations
 //   - Scroll-wheel zoom
+//   - Runs the graph on a GraphEngine, with a profiling overlay
+//     (heat + hottest-node panel)
 //   - No toolbar — clean canvas-first UX
 // ============================================================================
 
@@ -19,6 +21,12 @@
 #include <QJsonArray>
 #include <QMenu>
 #include <QWheelEvent>
+#include <QUuid>
+
+class QListWidget;
+class QTimer;
+
+namespace super { class GraphEngine; }
 
 // ═══════════════════════════════════════════════════════════════════════════
 namespace graph {
@@ -50,6 +58,13 @@ public:
 	QString label() const { return m_label; }
 	void set_label(const QString &l) { m_label = l; update(); }
 
+	// Id of the engine node mirroring this one (see GraphEditorWindow).
+	QUuid engine_id() const { return m_engine_id; }
+
+	// Profiling heat in [0, 1]; negative hides the overlay.
+	void set_heat(double heat);
+	double heat() const { return m_heat; }
+
 	QPointF port_center(PortDef::Dir dir, int index) const;
 	int port_at(const QPointF &local_pos, PortDef::Dir &out_dir) const;
 
@@ -67,6 +82,7 @@ public:
 
 	static QString type_name(Type t);
 	static QColor type_color(Type t);
+	static QColor heat_color(double heat);
 
 	static constexpr int W = 150, H = 64, PORT_R = 6;
 
@@ -76,6 +92,8 @@ protected:
 private:
 	Type m_type;
 	QString m_label;
+	QUuid m_engine_id = QUuid::createUuid();
+	double m_heat = -1.0;
 };
 
 // ---------------------------------------------------------------------------
@@ -165,6 +183,11 @@ class GraphEditorWindow : public QDialog {
 public:
 	explicit GraphEditorWindow(QWidget *parent = nullptr);
 
+	// The scene is mirrored into this engine after every edit. Node types
+	// with an engine equivalent run there; the others (MIDI In, Split,
+	// Merge, ...) are drawn but not executed.
+	super::GraphEngine *engine() const { return m_engine; }
+
 private:
 	void setup_ui();
 	void add_node(graph::GraphNode::Type type, const QPointF &pos = {});
@@ -172,10 +195,19 @@ private:
 	void clear_graph();
 	void show_node_properties(graph::GraphNode *node);
 	void context_menu(const QPoint &view_pos);
+	void sync_engine();
+	void set_profiling(bool enabled);
+	void refresh_profile();
 
 	graph::GraphView  *m_view  = nullptr;
 	graph::GraphScene *m_scene = nullptr;
 
 	QList<graph::GraphNode*> m_nodes;
 	QList<graph::GraphEdge*> m_edges;
+
+	super::GraphEngine *m_engine = nullptr;
+
+	// Profiling
+	QTimer      *m_profile_timer = nullptr;
+	QListWidget *m_hot_list = nullptr;
 };